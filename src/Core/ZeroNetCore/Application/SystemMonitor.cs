@@ -1,8 +1,10 @@
 using System;
+using System.Collections.Generic;
 using System.Threading;
 using Agebull.Common.ApiDocuments;
 using Agebull.Common.Logging;
 using Newtonsoft.Json;
+using Newtonsoft.Json.Linq;
 using ZeroMQ;
 
 namespace Agebull.ZeroNet.Core
@@ -81,6 +83,9 @@ namespace Agebull.ZeroNet.Core
                 case ZeroNetEventType.CenterStationState:
                     station_state(station, content);
                     return;
+                case ZeroNetEventType.CenterStationDelta:
+                    station_delta(station, content);
+                    return;
                 case ZeroNetEventType.CenterStationInstall:
                     station_install(station, content);
                     return;
@@ -125,6 +130,7 @@ namespace Agebull.ZeroNet.Core
             if (!ZeroApplication.Config.TryGetConfig(name, out var config))
                 return;
             ZeroTrace.SystemLog("station_uninstall", name);
+            StationStates.Remove(name);
             config.State = ZeroCenterState.Remove;
             ZeroApplication.Config.Remove(config);
             if (!ZeroApplication.InRun)
@@ -242,6 +248,7 @@ namespace Agebull.ZeroNet.Core
                 return;
             try
             {
+                StationStates[name] = JObject.Parse(content);
                 ZeroApplication.InvokeEvent(ZeroNetEventType.CenterStationState, content, config);
             }
             catch (Exception e)
@@ -251,6 +258,38 @@ namespace Agebull.ZeroNet.Core
             }
         }
 
+        /// <summary>
+        /// 最后一次的站点全量状态(只由侦听线程访问)
+        /// </summary>
+        private static readonly Dictionary<string, JObject> StationStates = new Dictionary<string, JObject>();
+
+        /// <summary>
+        /// 站点状态增量:合并到最后一次的全量状态后,按全量状态通知,
+        /// 未收到过全量状态时忽略(中心每隔若干周期会发布全量)
+        /// </summary>
+        /// <param name="name"></param>
+        /// <param name="content"></param>
+        private static void station_delta(string name, string content)
+        {
+            if (!ZeroApplication.Config.TryGetConfig(name, out var config))
+                return;
+            if (!StationStates.TryGetValue(name, out var state))
+                return;
+            try
+            {
+                state.Merge(JObject.Parse(content), new JsonMergeSettings
+                {
+                    MergeArrayHandling = MergeArrayHandling.Replace
+                });
+                ZeroApplication.InvokeEvent(ZeroNetEventType.CenterStationState, state.ToString(Formatting.None), config);
+            }
+            catch (Exception e)
+            {
+                LogRecorder.Exception(e);
+                ZeroTrace.WriteException("station_delta", e, name, content);
+            }
+        }
+
 
         private static void center_start(string content)
         {
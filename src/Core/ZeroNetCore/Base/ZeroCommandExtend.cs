@@ -322,7 +322,11 @@ namespace Agebull.ZeroNet.Core
                 };
                 for (int idx = 1; idx < end; idx++)
                 {
-                    result.Add(description[idx + 1], Encoding.UTF8.GetString(messages[idx].Read()));
+                    //二进制全局标识转为文本,调用方按GlobalId取值
+                    if (description[idx + 1] == ZeroFrameType.GlobalIdBin)
+                        result.Add(ZeroFrameType.GlobalId, ZeroFrameType.GlobalIdText(messages[idx].Read()));
+                    else
+                        result.Add(description[idx + 1], Encoding.UTF8.GetString(messages[idx].Read()));
                 }
 
                 return result;
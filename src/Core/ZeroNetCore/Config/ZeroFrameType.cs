@@ -15,6 +15,11 @@ namespace Agebull.ZeroNet.Core
         /// </summary>
         public const byte GlobalId = 1;
 
+        /// <summary>
+        ///     ȫֱʶ(8ֽڴ˶,binary_global_idʱʹ)
+        /// </summary>
+        public const byte GlobalIdBin = 7;
+
         /// <summary>
         ///     վ֡
         /// </summary>
@@ -106,6 +111,41 @@ namespace Agebull.ZeroNet.Core
         /// </summary>
         public const byte TsonValue = (byte)'V';
 
+        /// <summary>
+        ///     ط(¶ĴĻֵ)
+        /// </summary>
+        public const byte Replay = (byte)'R';
+
+        /// <summary>
+        ///     ¼(ֻں˿ڷ)
+        /// </summary>
+        public const byte Batch = (byte)'+';
+
+        /// <summary>
+        ///     ȫֱʶ
+        /// </summary>
+        /// <param name="bytes">8ֽڴ</param>
+        /// <returns>ȲΪ8ʱ0</returns>
+        public static long ReadGlobalId(byte[] bytes)
+        {
+            if (bytes == null || bytes.Length != 8)
+                return 0;
+            ulong value = 0;
+            foreach (var b in bytes)
+                value = (value << 8) | b;
+            return (long)value;
+        }
+
+        /// <summary>
+        ///     ȫֱʶתΪı(ĵʮıͬ:Сд,ǰ)
+        /// </summary>
+        /// <param name="bytes">8ֽڴ</param>
+        /// <returns></returns>
+        public static string GlobalIdText(byte[] bytes)
+        {
+            return ((ulong)ReadGlobalId(bytes)).ToString("x");
+        }
+
         /// <summary>
         ///     ˵֡
         /// </summary>
@@ -115,6 +155,8 @@ namespace Agebull.ZeroNet.Core
             {
                 case End:// 0;
                     return @"ֹ";
+                case GlobalIdBin:// 7;
+                    return @"ȫֱʶ()";
                 case GlobalId:// 1;
                     return @"ȫֱʶ";
                 case Station:// 2;
@@ -145,6 +187,8 @@ namespace Agebull.ZeroNet.Core
                     return @"һı";
                 case JsonValue:// (byte)'J';
                     return @"JSONı";
+                case Batch:// (byte)'+';
+                    return @"¼";
                 case BinaryValue:// (byte)'B';
                     return @"";
                 default:
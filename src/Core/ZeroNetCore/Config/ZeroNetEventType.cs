@@ -80,6 +80,21 @@ namespace Agebull.ZeroNet.Core
         */
         CenterClientLeft,
 
+        /// <summary>
+        /// 站点状态增量
+        /// </summary>
+        CenterStationDelta,
+
+        /// <summary>
+        /// 站点断路器状态变化
+        /// </summary>
+        CenterStationBreaker,
+
+        /// <summary>
+        /// 基准测试结果
+        /// </summary>
+        CenterBenchResult,
+
         /// <summary>
         /// 
         /// </summary>
@@ -68,6 +68,16 @@ namespace Agebull.ZeroNet.Core
         /// </summary>
         Pause = 0x81,
 
+        /// <summary>
+        /// 站点过载,请求未被接受
+        /// </summary>
+        Overload = 0x82,
+
+        /// <summary>
+        /// 调用者超过配额,请求未被接受
+        /// </summary>
+        Quota = 0x83,
+
         /// <summary>
         /// 逻辑BUG
         /// </summary>
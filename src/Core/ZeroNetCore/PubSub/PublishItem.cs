@@ -17,6 +17,12 @@ namespace Agebull.ZeroNet.PubSub
         [JsonProperty]
         public bool IsBadValue { get; set; }
 
+        /// <summary>
+        /// 是否为新订阅触发的缓存重发
+        /// </summary>
+        [JsonIgnore]
+        public bool IsReplay { get; set; }
+
 
         /// <summary>
         /// 带外事件
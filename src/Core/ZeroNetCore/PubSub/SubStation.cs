@@ -1,5 +1,6 @@
 using System;
 using System.Collections.Generic;
+using System.Globalization;
 using System.IO;
 using System.Runtime.Serialization.Json;
 using System.Text;
@@ -31,6 +32,11 @@ namespace Agebull.ZeroNet.PubSub
         /// </summary>
         public string Subscribe { get; set; } = "";
 
+        /// <summary>
+        /// 是否接收合批消息(站点启用合批时连接合批端口,该端口不补发缓存)
+        /// </summary>
+        public bool UseBatch { get; set; }
+
         /// <summary>
         /// 是否实时数据(如为真,则不保存未处理数据)
         /// </summary>
@@ -98,8 +104,9 @@ namespace Agebull.ZeroNet.PubSub
             //using (var socket = ZSocket.CreateClientSocket(inporcName, ZSocketType.PAIR))
             using (var pool = ZmqPool.CreateZmqPool())
             {
+                var batch = UseBatch && Config.BatchPort > 0;
                 pool.Prepare(ZPollEvent.In,
-                    ZSocket.CreateClientSocket(Config.WorkerCallAddress, ZSocketType.SUB, Identity, Subscribe));
+                    ZSocket.CreateClientSocket(batch ? Config.BatchAddress : Config.WorkerCallAddress, ZSocketType.SUB, Identity, Subscribe));
                 State = StationState.Run;
                 while (CanLoop)
                 {
@@ -109,7 +116,15 @@ namespace Agebull.ZeroNet.PubSub
                     }
                     else if (pool.CheckIn(0, out var message))
                     {
-                        if (Unpack(message, out var item))
+                        if (batch)
+                        {
+                            foreach (var batchItem in UnpackBatch(message))
+                            {
+                                if (!IsRepeated(batchItem))
+                                    DoHandle(batchItem);
+                            }
+                        }
+                        else if (Unpack(message, out var item) && !IsRepeated(item))
                         {
                             DoHandle(item);
                         }
@@ -123,6 +138,22 @@ namespace Agebull.ZeroNet.PubSub
             return true;
         }
 
+        /// <summary>
+        ///     已收到过的主题(主题\n副题)
+        /// </summary>
+        private readonly HashSet<string> _receivedTopics = new HashSet<string>();
+
+        /// <summary>
+        ///     是否为已收到过的主题的缓存重发(其它订阅者加入时中心会向全部订阅者重发最后值)
+        /// </summary>
+        /// <param name="item"></param>
+        /// <returns></returns>
+        private bool IsRepeated(TPublishItem item)
+        {
+            var key = item.SubTitle == null ? item.Title : item.Title + "\n" + item.SubTitle;
+            return !_receivedTopics.Add(key) && item.IsReplay;
+        }
+
         /// <summary>
         ///     广播消息解包
         /// </summary>
@@ -143,73 +174,160 @@ namespace Agebull.ZeroNet.PubSub
                     item = null;
                     return false;
                 }
-                var description = messages[1].Read();
-                if (description.Length < 2)
-                {
-                    item = null;
-                    return false;
-                }
+                var frames = new byte[messages.Count - 1][];
+                for (int idx = 1; idx < messages.Count; idx++)
+                    frames[idx - 1] = messages[idx].Read();
+                return UnpackFrames(messages[0].ReadString(), frames, out item);
+            }
+            catch (Exception e)
+            {
+                ZeroTrace.WriteException("Unpack", e);
+                item = null;
+                return false;
+            }
+            finally
+            {
+                messages.Dispose();
+            }
+        }
 
-                int end = description[0] + 2;
-                if (end != messages.Count)
+        /// <summary>
+        ///     合批消息解包
+        /// </summary>
+        /// <remarks>
+        ///     帧结构为 [主题][说明帧(Batch)][记录集],
+        ///     每条记录为 uint16 帧数量 + 若干(uint32 长度 + 内容),帧为说明帧及其后各帧,整数为小端.
+        ///     非合批格式的消息按单条解包
+        /// </remarks>
+        /// <param name="messages"></param>
+        /// <returns></returns>
+        protected virtual List<TPublishItem> UnpackBatch(ZMessage messages)
+        {
+            var items = new List<TPublishItem>();
+            if (messages == null)
+                return items;
+            if (messages.Count != 3)
+            {
+                if (Unpack(messages, out var single))
+                    items.Add(single);
+                return items;
+            }
+            try
+            {
+                var title = messages[0].ReadString();
+                var description = messages[1].Read();
+                var data = messages[2].Read();
+                if (description.Length < 3 || description[2] != ZeroFrameType.Batch)
                 {
-                    item = null;
-                    return false;
+                    if (UnpackFrames(title, new[] { description, data }, out var single))
+                        items.Add(single);
+                    return items;
                 }
-
-                item = new TPublishItem
+                int offset = 0;
+                while (offset + 2 <= data.Length)
                 {
-                    Title = messages[0].ReadString(),
-                    State = (ZeroOperatorStateType)description[1],
-                    ZeroEvent = (ZeroNetEventType)description[1]
-                };
-
-                for (int idx = 2; idx < end; idx++)
-                {
-                    var bytes = messages[idx].Read();
-                    if (bytes.Length == 0)
-                        continue;
-                    switch (description[idx])
+                    int count = BitConverter.ToUInt16(data, offset);
+                    offset += 2;
+                    var frames = new byte[count][];
+                    for (int idx = 0; idx < count; idx++)
                     {
-                        case ZeroFrameType.SubTitle:
-                            item.SubTitle = Encoding.UTF8.GetString(bytes);
-                            break;
-                        case ZeroFrameType.Station:
-                            item.Station = Encoding.UTF8.GetString(bytes);
-                            break;
-                        case ZeroFrameType.Publisher:
-                            item.Publisher = Encoding.UTF8.GetString(bytes);
-                            break;
-                        case ZeroFrameType.Content:
-                            if (item.Content == null)
-                                item.Content = Encoding.UTF8.GetString(bytes);
-                            else
-                                item.Values.Add(Encoding.UTF8.GetString(bytes));
-                            break;
-                        case ZeroFrameType.BinaryValue:
-                            item.Buffer = bytes;
-                            break;
-                        case ZeroFrameType.TsonValue:
-                            item.Tson = bytes;
-                            break;
-                        default:
-                            item.Values.Add(Encoding.UTF8.GetString(bytes));
-                            break;
+                        if (offset + 4 > data.Length)
+                            return items;
+                        int len = (int)BitConverter.ToUInt32(data, offset);
+                        offset += 4;
+                        if (len < 0 || offset + len > data.Length)
+                            return items;
+                        frames[idx] = new byte[len];
+                        Buffer.BlockCopy(data, offset, frames[idx], 0, len);
+                        offset += len;
                     }
+                    if (UnpackFrames(title, frames, out var item))
+                        items.Add(item);
                 }
-
-                return true;
             }
             catch (Exception e)
             {
-                ZeroTrace.WriteException("Unpack", e);
-                item = null;
-                return false;
+                ZeroTrace.WriteException("UnpackBatch", e);
             }
             finally
             {
                 messages.Dispose();
             }
+            return items;
+        }
+
+        /// <summary>
+        ///     广播消息的帧解包
+        /// </summary>
+        /// <param name="title">主题</param>
+        /// <param name="frames">说明帧及其后各帧</param>
+        /// <param name="item"></param>
+        /// <returns></returns>
+        protected bool UnpackFrames(string title, byte[][] frames, out TPublishItem item)
+        {
+            item = null;
+            if (frames.Length < 2)
+                return false;
+            var description = frames[0];
+            if (description.Length < 2)
+                return false;
+
+            int end = description[0] + 2;
+            if (end != frames.Length + 1 || description.Length < end)
+                return false;
+
+            item = new TPublishItem
+            {
+                Title = title,
+                State = (ZeroOperatorStateType)description[1],
+                ZeroEvent = (ZeroNetEventType)description[1]
+            };
+
+            for (int idx = 2; idx < end; idx++)
+            {
+                var bytes = frames[idx - 1];
+                if (bytes.Length == 0)
+                    continue;
+                switch (description[idx])
+                {
+                    case ZeroFrameType.SubTitle:
+                        item.SubTitle = Encoding.UTF8.GetString(bytes);
+                        break;
+                    case ZeroFrameType.Station:
+                        item.Station = Encoding.UTF8.GetString(bytes);
+                        break;
+                    case ZeroFrameType.Publisher:
+                        item.Publisher = Encoding.UTF8.GetString(bytes);
+                        break;
+                    case ZeroFrameType.GlobalId:
+                        long.TryParse(Encoding.UTF8.GetString(bytes).TrimEnd('\0'), NumberStyles.HexNumber, null, out var id);
+                        item.GlobalId = id;
+                        break;
+                    case ZeroFrameType.GlobalIdBin:
+                        item.GlobalId = ZeroFrameType.ReadGlobalId(bytes);
+                        break;
+                    case ZeroFrameType.Content:
+                        if (item.Content == null)
+                            item.Content = Encoding.UTF8.GetString(bytes);
+                        else
+                            item.Values.Add(Encoding.UTF8.GetString(bytes));
+                        break;
+                    case ZeroFrameType.BinaryValue:
+                        item.Buffer = bytes;
+                        break;
+                    case ZeroFrameType.TsonValue:
+                        item.Tson = bytes;
+                        break;
+                    case ZeroFrameType.Replay:
+                        item.IsReplay = true;
+                        break;
+                    default:
+                        item.Values.Add(Encoding.UTF8.GetString(bytes));
+                        break;
+                }
+            }
+
+            return true;
         }
 
         /// <summary>
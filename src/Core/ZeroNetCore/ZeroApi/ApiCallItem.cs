@@ -38,6 +38,11 @@ namespace Agebull.ZeroNet.ZeroApi
         /// </summary>
         public string GlobalId { get; set; }
 
+        /// <summary>
+        /// 二进制的全局ID(中心以二进制发送时原样返回,中心按原值匹配请求)
+        /// </summary>
+        public byte[] GlobalIdBin { get; set; }
+
         /// <summary>
         /// 调用方的全局ID
         /// </summary>
@@ -702,6 +702,10 @@ namespace Agebull.ZeroNet.ZeroApi
                         case ZeroFrameType.GlobalId:
                             item.GlobalId = val;
                             break;
+                        case ZeroFrameType.GlobalIdBin:
+                            item.GlobalIdBin = bytes;
+                            item.GlobalId = ZeroFrameType.GlobalIdText(bytes);
+                            break;
                         case ZeroFrameType.RequestId:
                             item.RequestId = val;
                             break;
@@ -756,10 +760,10 @@ namespace Agebull.ZeroNet.ZeroApi
                     new ZFrame(item.Caller),
                     new ZFrame(new byte[]
                     {
-                        2, (byte) state, ZeroFrameType.Requester, ZeroFrameType.GlobalId
+                        2, (byte) state, ZeroFrameType.Requester, GlobalIdType(item)
                     }),
                     new ZFrame(item.Requester.ToZeroBytes()),
-                    new ZFrame((item.GlobalId).ToZeroBytes())
+                    new ZFrame(GlobalIdBytes(item))
                 });
 
             return SendResult(ref socket, new ZMessage
@@ -767,14 +771,30 @@ namespace Agebull.ZeroNet.ZeroApi
                 new ZFrame(item.Caller),
                 new ZFrame(new byte[]
                 {
-                    3, (byte) state, ZeroFrameType.JsonValue, ZeroFrameType.Requester, ZeroFrameType.GlobalId
+                    3, (byte) state, ZeroFrameType.JsonValue, ZeroFrameType.Requester, GlobalIdType(item)
                 }),
                 new ZFrame((item.Result).ToZeroBytes()),
                 new ZFrame(item.Requester.ToZeroBytes()),
-                new ZFrame((item.GlobalId).ToZeroBytes())
+                new ZFrame(GlobalIdBytes(item))
             });
         }
 
+        /// <summary>
+        /// 返回的全局ID帧类型(与收到的一致)
+        /// </summary>
+        private static byte GlobalIdType(ApiCallItem item)
+        {
+            return item.GlobalIdBin != null ? ZeroFrameType.GlobalIdBin : ZeroFrameType.GlobalId;
+        }
+
+        /// <summary>
+        /// 返回的全局ID帧内容(与收到的一致)
+        /// </summary>
+        private static byte[] GlobalIdBytes(ApiCallItem item)
+        {
+            return item.GlobalIdBin ?? item.GlobalId.ToZeroBytes();
+        }
+
         /// <summary>
         /// 发送返回值 
         /// </summary>
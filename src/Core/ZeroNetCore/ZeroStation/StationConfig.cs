@@ -110,6 +110,20 @@ namespace Agebull.ZeroNet.Core
         [JsonProperty]
         public string SubAddress => ZeroIdentityHelper.GetSubscriberAddress(StationName, WorkerCallPort);
 
+        /// <summary>
+        ///     广播合批端口(未启用合批时为0)
+        /// </summary>
+        [DataMember]
+        [JsonProperty("batch_port")]
+        public int BatchPort { get; set; }
+
+        /// <summary>
+        ///     广播合批地址
+        /// </summary>
+        [DataMember]
+        [JsonProperty]
+        public string BatchAddress => ZeroIdentityHelper.GetWorkerAddress(StationName, BatchPort);
+
 
         /// <summary>
         ///     运行状态
@@ -130,6 +144,7 @@ namespace Agebull.ZeroNet.Core
             RequestPort = src.RequestPort;
             WorkerCallPort = src.WorkerCallPort;
             WorkerResultPort = src.WorkerResultPort;
+            BatchPort = src.BatchPort;
             State = src.State;
             IsBaseStation = src.IsBaseStation;
             StationName = src.StationName;
@@ -6,10 +6,45 @@ namespace agebull
 	int json_config::base_tcp_port = 7999;
 	int json_config::plan_exec_timeout = 300;
 	int json_config::plan_cache_size = 1024;
-	//bool json_config::use_ipc_protocol = false;
+	bool json_config::use_ipc_protocol = false;
+	bool json_config::use_shm_ring = false;
+	int json_config::shm_ring_size = 1024 * 1024;
+	char json_config::shm_group[64] = "";
+	bool json_config::use_reactor = false;
+	int json_config::reactor_threads = 2;
+	bool json_config::hot_restart = true;
+	int json_config::drain_timeout = 5000;
+	int json_config::drain_hold_size = 0;
+	int json_config::admit_max_inflight = 0;
+	bool json_config::admit_adaptive = false;
+	int json_config::admit_min_inflight = 8;
+	int json_config::admit_target = 100;
+	int json_config::admit_interval = 100;
+	int json_config::quota_rate = 0;
+	int json_config::quota_burst = 0;
+	int json_config::quota_callers = 4096;
+	bool json_config::breaker = false;
+	int json_config::breaker_error_rate = 50;
+	int json_config::breaker_min_requests = 20;
+	int json_config::breaker_window = 10000;
+	int json_config::breaker_open_time = 1000;
+	int json_config::breaker_probes = 1;
+	int json_config::single_flight_timeout = 3000;
+	int json_config::single_flight_waiters = 256;
+	bool json_config::binary_global_id = false;
+	int json_config::latency_commands = 64;
+	int json_config::metrics_port = 0;
+	int json_config::log_ring_size = 1024;
 	char json_config::redis_addr[512] = "127.0.0.1:6379";
 	int json_config::redis_defdb = 0x10;
 	int json_config::worker_sound_ivl = 2000;
+	int json_config::worker_state_full_ivl = 30;
+	int json_config::pub_cache_size = 0;
+	int json_config::pub_replay_size = 0;
+	int json_config::pub_cache_bytes = 0;
+	int json_config::pub_republish_ivl = 1000;
+	int json_config::pub_batch_linger = 0;
+	int json_config::pub_batch_size = 0;
 
 	int json_config::IMMEDIATE = 1;
 	int json_config::LINGER = -1;
@@ -66,20 +101,92 @@ namespace agebull
 			plan_exec_timeout = get_global_int("plan_exec_timeout", plan_exec_timeout);
 			plan_cache_size = get_global_int("plan_cache_size", plan_cache_size);
 			base_tcp_port = get_global_int("base_tcp_port", base_tcp_port);
-			//use_ipc_protocol = get_global_bool("use_ipc_protocol", use_ipc_protocol);
+			use_ipc_protocol = get_global_bool("use_ipc_protocol", use_ipc_protocol);
+			use_shm_ring = get_global_bool("use_shm_ring", use_shm_ring);
+			shm_ring_size = get_global_int("shm_ring_size", shm_ring_size);
+			var group = get_global_string("shm_group");
+			if (group.length() > 0 && group.length() < sizeof(shm_group))
+				strcpy(shm_group, group.c_str());
+			use_reactor = get_global_bool("use_reactor", use_reactor);
+			reactor_threads = get_global_int("reactor_threads", reactor_threads);
+			hot_restart = get_global_bool("hot_restart", hot_restart);
+			drain_timeout = get_global_int("drain_timeout", drain_timeout);
+			drain_hold_size = get_global_int("drain_hold_size", drain_hold_size);
+			admit_max_inflight = get_global_int("admit_max_inflight", admit_max_inflight);
+			admit_adaptive = get_global_bool("admit_adaptive", admit_adaptive);
+			admit_min_inflight = get_global_int("admit_min_inflight", admit_min_inflight);
+			admit_target = get_global_int("admit_target", admit_target);
+			admit_interval = get_global_int("admit_interval", admit_interval);
+			quota_rate = get_global_int("quota_rate", quota_rate);
+			quota_burst = get_global_int("quota_burst", quota_burst);
+			quota_callers = get_global_int("quota_callers", quota_callers);
+			breaker = get_global_bool("breaker", breaker);
+			breaker_error_rate = get_global_int("breaker_error_rate", breaker_error_rate);
+			breaker_min_requests = get_global_int("breaker_min_requests", breaker_min_requests);
+			breaker_window = get_global_int("breaker_window", breaker_window);
+			breaker_open_time = get_global_int("breaker_open_time", breaker_open_time);
+			breaker_probes = get_global_int("breaker_probes", breaker_probes);
+			single_flight_timeout = get_global_int("single_flight_timeout", single_flight_timeout);
+			single_flight_waiters = get_global_int("single_flight_waiters", single_flight_waiters);
+			binary_global_id = get_global_bool("binary_global_id", binary_global_id);
+			latency_commands = get_global_int("latency_commands", latency_commands);
+			metrics_port = get_global_int("metrics_port", metrics_port);
+			log_ring_size = get_global_int("log_ring_size", log_ring_size);
 			var addr = get_global_string("redis_addr");
 			if (addr.length() > 0)
 				strcpy(redis_addr, addr.c_str());
 			redis_defdb = get_global_int("redis_defdb", redis_defdb);
 			worker_sound_ivl = get_global_int("worker_sound_ivl", worker_sound_ivl);
+			worker_state_full_ivl = get_global_int("worker_state_full_ivl", worker_state_full_ivl);
+			pub_cache_size = get_global_int("pub_cache_size", pub_cache_size);
+			pub_replay_size = get_global_int("pub_replay_size", pub_replay_size);
+			pub_cache_bytes = get_global_int("pub_cache_bytes", pub_cache_bytes);
+			pub_republish_ivl = get_global_int("pub_republish_ivl", pub_republish_ivl);
+			pub_batch_linger = get_global_int("pub_batch_linger", pub_batch_linger);
+			pub_batch_size = get_global_int("pub_batch_size", pub_batch_size);
 		}
 		log_msg1("config => base_tcp_port : %d", base_tcp_port);
 		log_msg1("config => worker_sound_ivl : %d", worker_sound_ivl);
-		//log_msg1("config => use_ipc_protocol : %d", use_ipc_protocol);
+		log_msg1("config => worker_state_full_ivl : %d", worker_state_full_ivl);
+		log_msg1("config => use_ipc_protocol : %d", use_ipc_protocol);
+		log_msg1("config => use_shm_ring : %d", use_shm_ring);
+		log_msg1("config => shm_ring_size : %d", shm_ring_size);
+		log_msg1("config => shm_group : %s", shm_group);
+		log_msg1("config => use_reactor : %d", use_reactor);
+		log_msg1("config => reactor_threads : %d", reactor_threads);
+		log_msg1("config => hot_restart : %d", hot_restart);
+		log_msg1("config => drain_timeout : %d", drain_timeout);
+		log_msg1("config => drain_hold_size : %d", drain_hold_size);
+		log_msg1("config => admit_max_inflight : %d", admit_max_inflight);
+		log_msg1("config => admit_adaptive : %d", admit_adaptive);
+		log_msg1("config => admit_min_inflight : %d", admit_min_inflight);
+		log_msg1("config => admit_target : %d", admit_target);
+		log_msg1("config => admit_interval : %d", admit_interval);
+		log_msg1("config => quota_rate : %d", quota_rate);
+		log_msg1("config => quota_burst : %d", quota_burst);
+		log_msg1("config => quota_callers : %d", quota_callers);
+		log_msg1("config => breaker : %d", breaker);
+		log_msg1("config => breaker_error_rate : %d", breaker_error_rate);
+		log_msg1("config => breaker_min_requests : %d", breaker_min_requests);
+		log_msg1("config => breaker_window : %d", breaker_window);
+		log_msg1("config => breaker_open_time : %d", breaker_open_time);
+		log_msg1("config => breaker_probes : %d", breaker_probes);
+		log_msg1("config => single_flight_timeout : %d", single_flight_timeout);
+		log_msg1("config => single_flight_waiters : %d", single_flight_waiters);
+		log_msg1("config => binary_global_id : %d", binary_global_id);
+		log_msg1("config => latency_commands : %d", latency_commands);
+		log_msg1("config => metrics_port : %d", metrics_port);
+		log_msg1("config => log_ring_size : %d", log_ring_size);
 		log_msg1("config => redis_addr : %s", redis_addr);
 		log_msg1("config => redis_defdb : %d", redis_defdb);
 		log_msg1("config => plan_exec_timeout : %d", plan_exec_timeout);
 		log_msg1("config => plan_cache_size : %d", plan_cache_size);
+		log_msg1("config => pub_cache_size : %d", pub_cache_size);
+		log_msg1("config => pub_replay_size : %d", pub_replay_size);
+		log_msg1("config => pub_cache_bytes : %d", pub_cache_bytes);
+		log_msg1("config => pub_republish_ivl : %d", pub_republish_ivl);
+		log_msg1("config => pub_batch_linger : %d", pub_batch_linger);
+		log_msg1("config => pub_batch_size : %d", pub_batch_size);
 
 		log_msg1("config => ZMQ_IMMEDIATE : %d", IMMEDIATE);
 		log_msg1("config => ZMQ_LINGER : %d", LINGER);
@@ -14,10 +14,45 @@ namespace agebull
 		static int base_tcp_port;
 		static int plan_exec_timeout;
 		static int plan_cache_size;
-		//static bool use_ipc_protocol;
+		static bool use_ipc_protocol;
+		static bool use_shm_ring;
+		static int shm_ring_size;
+		static char shm_group[64];
+		static bool use_reactor;
+		static int reactor_threads;
+		static bool hot_restart;
+		static int drain_timeout;
+		static int drain_hold_size;
+		static int admit_max_inflight;
+		static bool admit_adaptive;
+		static int admit_min_inflight;
+		static int admit_target;
+		static int admit_interval;
+		static int quota_rate;
+		static int quota_burst;
+		static int quota_callers;
+		static bool breaker;
+		static int breaker_error_rate;
+		static int breaker_min_requests;
+		static int breaker_window;
+		static int breaker_open_time;
+		static int breaker_probes;
+		static int single_flight_timeout;
+		static int single_flight_waiters;
+		static bool binary_global_id;
+		static int latency_commands;
+		static int metrics_port;
+		static int log_ring_size;
 		static char redis_addr[512];
 		static int redis_defdb;
 		static int worker_sound_ivl;
+		static int worker_state_full_ivl;
+		static int pub_cache_size;
+		static int pub_replay_size;
+		static int pub_cache_bytes;
+		static int pub_republish_ivl;
+		static int pub_batch_linger;
+		static int pub_batch_size;
 		static int IMMEDIATE;
 		static int LINGER;
 		static int RCVHWM;
@@ -0,0 +1,196 @@
+#pragma once
+#ifndef _AGEBULL_COW_MAP_H_
+#define _AGEBULL_COW_MAP_H_
+#include "../stdinc.h"
+#include <atomic>
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		 * \brief 取得一个新的快照版本
+		 * \remark 所有cow_map共用一个计数,字典销毁后在同一地址新建的字典也不会与线程缓存的(地址,版本)重复
+		 */
+		inline uint64_t cow_map_next_version()
+		{
+			static std::atomic<uint64_t> version(0);
+			return version.fetch_add(1, std::memory_order_relaxed) + 1;
+		}
+
+		/**
+		 * \brief 写时复制的字典
+		 * \remark
+		 * 写入在锁内复制整个字典,修改后以原子方式发布新的快照并更换版本号;
+		 * 读取只比较版本号,版本未变时直接使用本线程缓存的快照,不加锁也不修改共享内存.
+		 * 适用于读远多于写的登记表(站点实例,站点配置).
+		 * 线程缓存的旧快照在该线程下次读取时才释放,值的生命周期须由调用者另行保证.
+		 */
+		template <typename TKey, typename TValue>
+		class cow_map
+		{
+		public:
+			typedef std::map<TKey, TValue> map_type;
+			typedef std::shared_ptr<const map_type> snapshot_type;
+		private:
+			/**
+			* \brief 当前快照(只通过 std::atomic_load/atomic_store 访问)
+			*/
+			snapshot_type map_;
+			/**
+			* \brief 快照版本(每次发布后取一个全局唯一的新版本)
+			*/
+			std::atomic<uint64_t> version_;
+			/**
+			* \brief 写入锁
+			*/
+			boost::mutex mutex_;
+
+			/**
+			* \brief 线程缓存的快照
+			*/
+			struct local_cache
+			{
+				const cow_map* owner;
+				uint64_t version;
+				snapshot_type map;
+			};
+
+			/**
+			* \brief 本线程的快照(版本变化时重新取得)
+			*/
+			const snapshot_type& local() const
+			{
+				static thread_local local_cache cache{ nullptr, 0, nullptr };
+				const uint64_t version = version_.load(std::memory_order_acquire);
+				if (cache.owner != this || cache.version != version)
+				{
+					cache.map = std::atomic_load(&map_);
+					cache.owner = this;
+					cache.version = version;
+				}
+				return cache.map;
+			}
+		public:
+			/**
+			* \brief 构造
+			*/
+			cow_map()
+				: map_(std::make_shared<const map_type>())
+				, version_(cow_map_next_version())
+			{
+			}
+
+			cow_map(const cow_map&) = delete;
+			cow_map& operator=(const cow_map&) = delete;
+
+			/**
+			* \brief 取得快照(可在遍历中调用其它读写方法)
+			*/
+			snapshot_type snapshot() const
+			{
+				return local();
+			}
+
+			/**
+			* \brief 查找
+			* \return 未找到时返回false,value不变
+			*/
+			bool find(const TKey& key, TValue& value) const
+			{
+				const map_type& map = *local();
+				const auto iter = map.find(key);
+				if (iter == map.end())
+					return false;
+				value = iter->second;
+				return true;
+			}
+
+			/**
+			* \brief 是否存在
+			*/
+			bool contains(const TKey& key) const
+			{
+				const map_type& map = *local();
+				return map.find(key) != map.end();
+			}
+
+			/**
+			* \brief 数量
+			*/
+			size_t size() const
+			{
+				return local()->size();
+			}
+
+			/**
+			* \brief 修改:在写入锁内复制当前字典交给func修改,func返回true时发布
+			* \return func的返回值
+			*/
+			template <typename TFunc>
+			bool update(TFunc func)
+			{
+				boost::lock_guard<boost::mutex> guard(mutex_);
+				std::shared_ptr<map_type> copy = std::make_shared<map_type>(*std::atomic_load(&map_));
+				if (!func(*copy))
+					return false;
+				std::atomic_store(&map_, snapshot_type(std::move(copy)));
+				version_.store(cow_map_next_version(), std::memory_order_release);
+				return true;
+			}
+
+			/**
+			* \brief 不存在时加入
+			* \return 已存在时返回false
+			*/
+			bool insert(const TKey& key, const TValue& value)
+			{
+				if (contains(key))
+					return false;
+				return update([&key, &value](map_type& map)
+				{
+					return map.insert(std::make_pair(key, value)).second;
+				});
+			}
+
+			/**
+			* \brief 加入或替换
+			*/
+			void set(const TKey& key, const TValue& value)
+			{
+				update([&key, &value](map_type& map)
+				{
+					map[key] = value;
+					return true;
+				});
+			}
+
+			/**
+			* \brief 删除
+			* \return 不存在时返回false
+			*/
+			bool erase(const TKey& key)
+			{
+				if (!contains(key))
+					return false;
+				return update([&key](map_type& map)
+				{
+					return map.erase(key) > 0;
+				});
+			}
+
+			/**
+			* \brief 清空
+			*/
+			void clear()
+			{
+				update([](map_type& map)
+				{
+					map.clear();
+					return true;
+				});
+			}
+		};
+	}
+}
+#endif //!_AGEBULL_COW_MAP_H_
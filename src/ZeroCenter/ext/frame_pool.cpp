@@ -0,0 +1,375 @@
+/**
+ * 帧内存池
+ */
+#include "../stdafx.h"
+#include "frame_pool.h"
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		* \brief 一个线程的缓存(只增不删,线程退出后由新线程接管)
+		*/
+		struct frame_pool_cache
+		{
+			/**
+			* \brief 各等级的空闲链表(只有所有者访问)
+			*/
+			shared_block* free_list[frame_pool::class_count];
+			/**
+			* \brief 各等级的空闲数量
+			*/
+			size_t free_count[frame_pool::class_count];
+			/**
+			* \brief 其它线程归还的内存块(无锁栈)
+			*/
+			std::atomic<shared_block*> remote;
+			/**
+			* \brief 分配次数(所有者写)
+			*/
+			std::atomic<int64_t> allocs;
+			/**
+			* \brief 命中次数(所有者写)
+			*/
+			std::atomic<int64_t> hits;
+			/**
+			* \brief 分配字节数(所有者写)
+			*/
+			std::atomic<int64_t> alloc_bytes;
+			/**
+			* \brief 本线程归还的字节数(所有者写)
+			*/
+			std::atomic<int64_t> free_bytes;
+			/**
+			* \brief 空闲链表中的字节数(所有者写)
+			*/
+			std::atomic<int64_t> cached_bytes;
+			/**
+			* \brief 其它线程归还的次数
+			*/
+			std::atomic<int64_t> remote_frees;
+			/**
+			* \brief 其它线程归还的字节数
+			*/
+			std::atomic<int64_t> remote_bytes;
+			/**
+			* \brief 是否有线程在使用
+			*/
+			bool live;
+			/**
+			* \brief 线程名称
+			*/
+			char name[64];
+		};
+
+		namespace
+		{
+			/**
+			* \brief 缓存登记表(不析构,线程退出晚于静态对象析构时仍可访问)
+			*/
+			vector<frame_pool_cache*>& registry()
+			{
+				static vector<frame_pool_cache*>* caches = new vector<frame_pool_cache*>();
+				return *caches;
+			}
+
+			boost::mutex& registry_mutex()
+			{
+				static boost::mutex* mutex = new boost::mutex();
+				return *mutex;
+			}
+
+			inline size_t class_block_size(uint32_t size_class)
+			{
+				return frame_pool::min_block << size_class;
+			}
+
+			inline uint32_t class_of(size_t block_size)
+			{
+				uint32_t size_class = 0;
+				size_t size = frame_pool::min_block;
+				while (size < block_size && size_class < frame_pool::class_count)
+				{
+					size <<= 1;
+					++size_class;
+				}
+				return size_class;
+			}
+
+			inline shared_block*& next_of(shared_block* block)
+			{
+				return *reinterpret_cast<shared_block**>(block + 1);
+			}
+
+			inline void add(std::atomic<int64_t>& counter, int64_t value)
+			{
+				//单一写者,不需要原子加
+				counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+			}
+
+			/**
+			* \brief 接管一个空闲的缓存或新建
+			*/
+			frame_pool_cache* adopt_cache()
+			{
+				boost::lock_guard<boost::mutex> guard(registry_mutex());
+				for (auto cache : registry())
+				{
+					if (!cache->live)
+					{
+						cache->live = true;
+						return cache;
+					}
+				}
+				frame_pool_cache* cache = new frame_pool_cache();
+				memset(cache->free_list, 0, sizeof(cache->free_list));
+				memset(cache->free_count, 0, sizeof(cache->free_count));
+				cache->remote.store(nullptr);
+				cache->allocs.store(0);
+				cache->hits.store(0);
+				cache->alloc_bytes.store(0);
+				cache->free_bytes.store(0);
+				cache->cached_bytes.store(0);
+				cache->remote_frees.store(0);
+				cache->remote_bytes.store(0);
+				cache->live = true;
+				cache->name[0] = '\0';
+				registry().push_back(cache);
+				return cache;
+			}
+
+			/**
+			* \brief 当前线程的缓存(平凡类型,线程退出过程中仍可访问)
+			*/
+			thread_local frame_pool_cache* thread_cache = nullptr;
+			/**
+			* \brief 当前线程是否已在退出
+			*/
+			thread_local bool thread_exited = false;
+			/**
+			* \brief 当前线程的分配计入的站点计数
+			*/
+			thread_local frame_pool_counters* thread_counters = nullptr;
+
+			/**
+			* \brief 线程退出时释放空闲链表并交还缓存
+			*/
+			struct cache_holder
+			{
+				cache_holder()
+				{
+					thread_cache = adopt_cache();
+				}
+
+				~cache_holder()
+				{
+					frame_pool_cache* cache = thread_cache;
+					thread_cache = nullptr;
+					thread_exited = true;
+					for (uint32_t idx = 0; idx < frame_pool::class_count; idx++)
+					{
+						shared_block* block = cache->free_list[idx];
+						while (block != nullptr)
+						{
+							shared_block* next = next_of(block);
+							free(block);
+							block = next;
+						}
+						cache->free_list[idx] = nullptr;
+						cache->free_count[idx] = 0;
+					}
+					cache->cached_bytes.store(0, std::memory_order_relaxed);
+					boost::lock_guard<boost::mutex> guard(registry_mutex());
+					cache->name[0] = '\0';
+					cache->live = false;
+				}
+			};
+
+			/**
+			* \brief 当前线程的缓存,线程退出后(析构静态对象时)返回nullptr
+			*/
+			inline frame_pool_cache* local_cache()
+			{
+				if (thread_cache == nullptr && !thread_exited)
+				{
+					static thread_local cache_holder holder;
+				}
+				return thread_cache;
+			}
+
+			/**
+			* \brief 放回空闲链表(超过上限时直接释放)
+			*/
+			inline void push_local(frame_pool_cache* cache, shared_block* block)
+			{
+				const uint32_t size_class = block->size_class;
+				const size_t size = class_block_size(size_class);
+				if (cache->free_count[size_class] * size >= frame_pool::class_cache_bytes)
+				{
+					free(block);
+					return;
+				}
+				next_of(block) = cache->free_list[size_class];
+				cache->free_list[size_class] = block;
+				++cache->free_count[size_class];
+				add(cache->cached_bytes, static_cast<int64_t>(size));
+			}
+
+			/**
+			* \brief 取回其它线程归还的内存块
+			*/
+			void drain_remote(frame_pool_cache* cache)
+			{
+				shared_block* block = cache->remote.exchange(nullptr, std::memory_order_acquire);
+				while (block != nullptr)
+				{
+					shared_block* next = next_of(block);
+					push_local(cache, block);
+					block = next;
+				}
+			}
+		}
+
+		/**
+		* \brief 分配内存块(计数为1,容量不小于capacity)
+		*/
+		shared_block* frame_pool::alloc(size_t capacity)
+		{
+			frame_pool_cache* cache = local_cache();
+			const size_t need = sizeof(shared_block) + capacity;
+			uint32_t size_class = class_of(need);
+			shared_block* block;
+			size_t size;
+			if (cache == nullptr)
+			{
+				//线程退出过程中,不经过缓存
+				block = static_cast<shared_block*>(malloc(need));
+				if (block == nullptr)
+					throw std::bad_alloc();
+				new (&block->count) std::atomic<int>(1);
+				block->size_class = class_count;
+				block->owner = nullptr;
+				block->capacity = capacity;
+				return block;
+			}
+			add(cache->allocs, 1);
+			if (thread_counters != nullptr)
+				thread_counters->allocs.fetch_add(1, std::memory_order_relaxed);
+			if (size_class >= class_count)
+			{
+				size_class = class_count;
+				size = need;
+				block = static_cast<shared_block*>(malloc(size));
+			}
+			else
+			{
+				size = class_block_size(size_class);
+				if (cache->free_list[size_class] == nullptr && cache->remote.load(std::memory_order_relaxed) != nullptr)
+					drain_remote(cache);
+				block = cache->free_list[size_class];
+				if (block != nullptr)
+				{
+					cache->free_list[size_class] = next_of(block);
+					--cache->free_count[size_class];
+					add(cache->cached_bytes, -static_cast<int64_t>(size));
+					add(cache->hits, 1);
+					if (thread_counters != nullptr)
+						thread_counters->hits.fetch_add(1, std::memory_order_relaxed);
+				}
+				else
+				{
+					block = static_cast<shared_block*>(malloc(size));
+				}
+			}
+			if (block == nullptr)
+				throw std::bad_alloc();
+			add(cache->alloc_bytes, static_cast<int64_t>(size));
+			new (&block->count) std::atomic<int>(1);
+			block->size_class = size_class;
+			block->owner = cache;
+			block->capacity = size - sizeof(shared_block);
+			return block;
+		}
+
+		/**
+		* \brief 归还内存块(计数已为0)
+		*/
+		void frame_pool::release(shared_block* block)
+		{
+			frame_pool_cache* owner = block->owner;
+			if (owner == nullptr)
+			{
+				free(block);
+				return;
+			}
+			const size_t size = block->size_class >= class_count
+				? sizeof(shared_block) + block->capacity
+				: class_block_size(block->size_class);
+			frame_pool_cache* cache = local_cache();
+			if (owner == cache)
+			{
+				add(cache->free_bytes, static_cast<int64_t>(size));
+				if (block->size_class >= class_count)
+					free(block);
+				else
+					push_local(cache, block);
+				return;
+			}
+			owner->remote_frees.fetch_add(1, std::memory_order_relaxed);
+			owner->remote_bytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+			if (block->size_class >= class_count)
+			{
+				free(block);
+				return;
+			}
+			shared_block* head = owner->remote.load(std::memory_order_relaxed);
+			do
+			{
+				next_of(block) = head;
+			} while (!owner->remote.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		/**
+		* \brief 标记当前线程的名称,用于按站点统计
+		*/
+		void frame_pool::set_thread_name(const char* name)
+		{
+			frame_pool_cache* cache = local_cache();
+			boost::lock_guard<boost::mutex> guard(registry_mutex());
+			strncpy(cache->name, name == nullptr ? "" : name, sizeof(cache->name) - 1);
+			cache->name[sizeof(cache->name) - 1] = '\0';
+		}
+
+		/**
+		* \brief 当前线程此后的分配计入的站点计数
+		*/
+		void frame_pool::attribute(frame_pool_counters* counters)
+		{
+			thread_counters = counters;
+		}
+
+		/**
+		* \brief 取得统计
+		*/
+		frame_pool_stats frame_pool::get_stats(const char* name)
+		{
+			frame_pool_stats stats;
+			memset(&stats, 0, sizeof(stats));
+			boost::lock_guard<boost::mutex> guard(registry_mutex());
+			for (auto cache : registry())
+			{
+				if (name != nullptr && strcmp(cache->name, name) != 0)
+					continue;
+				stats.allocs += cache->allocs.load(std::memory_order_relaxed);
+				stats.hits += cache->hits.load(std::memory_order_relaxed);
+				stats.remote_frees += cache->remote_frees.load(std::memory_order_relaxed);
+				stats.outstanding += cache->alloc_bytes.load(std::memory_order_relaxed)
+					- cache->free_bytes.load(std::memory_order_relaxed)
+					- cache->remote_bytes.load(std::memory_order_relaxed);
+				stats.cached += cache->cached_bytes.load(std::memory_order_relaxed);
+			}
+			return stats;
+		}
+	}
+}
@@ -0,0 +1,137 @@
+#pragma once
+#ifndef _AGEBULL_FRAME_POOL_H_
+#define _AGEBULL_FRAME_POOL_H_
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		struct frame_pool_cache;
+
+		/**
+		 * \brief 共享内存块头(与内容在同一次分配中,内容紧随其后)
+		 */
+		struct shared_block
+		{
+			/**
+			* \brief 引用计数
+			*/
+			std::atomic<int> count;
+			/**
+			* \brief 尺寸等级(frame_pool::class_count 表示直接由malloc分配)
+			*/
+			uint32_t size_class;
+			/**
+			* \brief 分配线程的缓存(释放时归还到这里)
+			*/
+			frame_pool_cache* owner;
+			/**
+			* \brief 内容容量
+			*/
+			size_t capacity;
+		};
+
+		/**
+		 * \brief 帧内存池的统计
+		 */
+		struct frame_pool_stats
+		{
+			/**
+			* \brief 分配次数
+			*/
+			int64_t allocs;
+			/**
+			* \brief 命中空闲链表的次数
+			*/
+			int64_t hits;
+			/**
+			* \brief 其它线程归还的次数
+			*/
+			int64_t remote_frees;
+			/**
+			* \brief 未归还的字节数
+			*/
+			int64_t outstanding;
+			/**
+			* \brief 空闲链表中缓存的字节数
+			*/
+			int64_t cached;
+		};
+
+		/**
+		 * \brief 按站点归属的分配计数(站点配置持有,重启后累计)
+		 */
+		struct frame_pool_counters
+		{
+			/**
+			* \brief 分配次数
+			*/
+			std::atomic<int64_t> allocs;
+			/**
+			* \brief 命中空闲链表的次数
+			*/
+			std::atomic<int64_t> hits;
+
+			frame_pool_counters()
+				: allocs(0)
+				, hits(0)
+			{
+			}
+		};
+
+		/**
+		 * \brief 帧内存池:按线程,按尺寸等级(64字节到64K,2的幂)缓存释放的内存块
+		 * \remark
+		 * 分配只访问本线程的缓存,无锁;本线程释放直接放回空闲链表,
+		 * 其它线程释放压入所有者的无锁栈,由所有者在空闲链表为空时整体取回.
+		 * 线程退出时缓存交还全局登记表,由新线程接管,已发出的内存块仍可安全归还.
+		 */
+		class frame_pool
+		{
+		public:
+			/**
+			* \brief 尺寸等级数量
+			*/
+			static const uint32_t class_count = 11;
+			/**
+			* \brief 最小等级的块大小(含块头)
+			*/
+			static const size_t min_block = 64;
+			/**
+			* \brief 每个等级空闲链表缓存的字节上限
+			*/
+			static const size_t class_cache_bytes = 1024 * 1024;
+
+			/**
+			* \brief 分配内存块(计数为1,容量不小于capacity)
+			*/
+			static shared_block* alloc(size_t capacity);
+
+			/**
+			* \brief 归还内存块(计数已为0)
+			*/
+			static void release(shared_block* block);
+
+			/**
+			* \brief 标记当前线程的名称,用于按站点统计
+			*/
+			static void set_thread_name(const char* name);
+
+			/**
+			* \brief 当前线程此后的分配计入的站点计数(nullptr 不计入)
+			* \remark 共享轮询的线程在处理每个站点前切换,站点的分配次数与命中不受线程划分影响
+			*/
+			static void attribute(frame_pool_counters* counters);
+
+			/**
+			* \brief 取得统计
+			* \param name 线程名称,nullptr 表示全部线程
+			*/
+			static frame_pool_stats get_stats(const char* name = nullptr);
+		};
+	}
+}
+#endif //!_AGEBULL_FRAME_POOL_H_
@@ -0,0 +1,101 @@
+#pragma once
+#ifndef _AGEBULL_GLOBAL_ID_H_
+#define _AGEBULL_GLOBAL_ID_H_
+#include <cstddef>
+#include <cstdint>
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		 * \brief 全局标识的编码
+		 * \remark
+		 * 二进制帧为8字节大端整数(按字节比较与数值大小一致);
+		 * 文本为不带前导零的小写十六进制,与 sprintf("%llx") 的结果相同,用于Redis键与兼容旧客户端.
+		 * 编码与解码均不按字符分支,也不经过格式化函数.
+		 */
+		namespace id_codec
+		{
+			/**
+			* \brief 二进制帧的长度
+			*/
+			static const size_t bin_size = 8;
+			/**
+			* \brief 十六进制文本的最大长度(不含结尾的零字节)
+			*/
+			static const size_t hex_size = 16;
+
+			/**
+			* \brief 编码为十六进制文本(写入结尾的零字节)
+			* \param buffer 至少 hex_size + 1 字节
+			* \return 文本长度
+			*/
+			inline size_t to_hex(uint64_t value, char* buffer)
+			{
+				static const char digits[] = "0123456789abcdef";
+				//有效位数(0也输出一位),按半字节向上取整即为长度
+				const size_t len = static_cast<size_t>(67 - __builtin_clzll(value | 1)) >> 2;
+				for (size_t idx = 0; idx < len; idx++)
+					buffer[idx] = digits[(value >> ((len - 1 - idx) << 2)) & 0xF];
+				buffer[len] = '\0';
+				return len;
+			}
+
+			/**
+			* \brief 解码十六进制文本(大小写均可,遇到零字节或超过 hex_size 位时结束)
+			*/
+			inline uint64_t from_hex(const char* str, size_t len)
+			{
+				uint64_t value = 0;
+				if (len > hex_size)
+					len = hex_size;
+				for (size_t idx = 0; idx < len && str[idx] != '\0'; idx++)
+				{
+					const uint8_t ch = static_cast<uint8_t>(str[idx]);
+					//'0'-'9' 取低4位;'a'-'f'/'A'-'F' 低4位为1-6,第6位为1,补9
+					value = (value << 4) | static_cast<uint64_t>((ch & 0xF) + 9 * (ch >> 6));
+				}
+				return value;
+			}
+
+			/**
+			* \brief 编码为二进制帧
+			* \param buffer 至少 bin_size 字节
+			*/
+			inline void to_bin(uint64_t value, char* buffer)
+			{
+				for (size_t idx = 0; idx < bin_size; idx++)
+					buffer[idx] = static_cast<char>(value >> ((bin_size - 1 - idx) << 3));
+			}
+
+			/**
+			* \brief 解码二进制帧
+			*/
+			inline uint64_t from_bin(const char* buffer)
+			{
+				uint64_t value = 0;
+				for (size_t idx = 0; idx < bin_size; idx++)
+					value = (value << 8) | static_cast<uint8_t>(buffer[idx]);
+				return value;
+			}
+
+			/**
+			* \brief 生成键:前缀 + 站点 + ':' + 十六进制标识,等同 sprintf("%s%s:%llx")
+			* \param buffer 长度须容纳前缀,站点与 hex_size + 2 字节
+			* \return 键长度
+			*/
+			inline size_t make_key(char* buffer, const char* prefix, const char* station, uint64_t value)
+			{
+				char* ptr = buffer;
+				while (*prefix != '\0')
+					*ptr++ = *prefix++;
+				while (*station != '\0')
+					*ptr++ = *station++;
+				*ptr++ = ':';
+				return static_cast<size_t>(ptr - buffer) + to_hex(value, ptr);
+			}
+		}
+	}
+}
+#endif //!_AGEBULL_GLOBAL_ID_H_
@@ -0,0 +1,199 @@
+#pragma once
+#ifndef _AGEBULL_LATENCY_HISTOGRAM_H_
+#define _AGEBULL_LATENCY_HISTOGRAM_H_
+#include "../stdinc.h"
+#include <atomic>
+#include <chrono>
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		 * \brief 延时分布的统计结果(微秒)
+		 */
+		struct latency_summary
+		{
+			int64 count;
+			int64 sum;
+			int64 p50;
+			int64 p99;
+			int64 p999;
+			int64 max;
+		};
+
+		/**
+		 * \brief 对数分桶的延时直方图(微秒)
+		 * \remark
+		 * 与HDR直方图相同的分桶方式:小于8微秒的值各占一桶,其后每个2的幂区间再等分为8个子桶,
+		 * 相对误差不超过12.5%,覆盖到2^40微秒(约12天),更大的值计入最后一桶.
+		 * 记录只做无锁的原子累加,可由多个线程同时写入;读取时复制全部桶后计算分位数.
+		 */
+		class latency_histogram
+		{
+		public:
+			/**
+			* \brief 每个2的幂区间的子桶位数
+			*/
+			static const int sub_bits = 3;
+			/**
+			* \brief 最大的2的幂
+			*/
+			static const int max_exponent = 40;
+			/**
+			* \brief 桶数量
+			*/
+			static const size_t bucket_count = (max_exponent - sub_bits + 2) << sub_bits;
+		private:
+			/**
+			* \brief 各桶的次数
+			*/
+			std::atomic<int64> buckets_[bucket_count];
+			/**
+			* \brief 最大值
+			*/
+			std::atomic<int64> max_;
+			/**
+			* \brief 总和
+			*/
+			std::atomic<int64> sum_;
+
+			/**
+			* \brief 值所在的桶
+			*/
+			static size_t bucket_of(uint64_t value)
+			{
+				if (value < (1ULL << sub_bits))
+					return static_cast<size_t>(value);
+				const int exponent = 63 - __builtin_clzll(value);
+				if (exponent > max_exponent)
+					return bucket_count - 1;
+				const size_t sub = static_cast<size_t>(value >> (exponent - sub_bits)) & ((1 << sub_bits) - 1);
+				return (static_cast<size_t>(exponent - sub_bits + 1) << sub_bits) + sub;
+			}
+
+			/**
+			* \brief 桶内的最大值
+			*/
+			static int64 highest_of(size_t bucket)
+			{
+				if (bucket < (1U << sub_bits))
+					return static_cast<int64>(bucket);
+				const int exponent = static_cast<int>(bucket >> sub_bits) + sub_bits - 1;
+				const uint64_t sub = bucket & ((1 << sub_bits) - 1);
+				const uint64_t lowest = ((1ULL << sub_bits) + sub) << (exponent - sub_bits);
+				return static_cast<int64>(lowest + (1ULL << (exponent - sub_bits)) - 1);
+			}
+		public:
+			/**
+			* \brief 构造
+			*/
+			latency_histogram()
+			{
+				reset();
+			}
+
+			latency_histogram(const latency_histogram&) = delete;
+			latency_histogram& operator=(const latency_histogram&) = delete;
+
+			/**
+			* \brief 当前时间(单调时钟,微秒)
+			*/
+			static int64 now()
+			{
+				return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			}
+
+			/**
+			* \brief 记录一次延时
+			*/
+			void record(int64 value)
+			{
+				if (value < 0)
+					value = 0;
+				buckets_[bucket_of(static_cast<uint64_t>(value))].fetch_add(1, std::memory_order_relaxed);
+				sum_.fetch_add(value, std::memory_order_relaxed);
+				int64 max = max_.load(std::memory_order_relaxed);
+				while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+				{
+				}
+			}
+
+			/**
+			* \brief 清零(与记录并发时可能丢失少量记录)
+			*/
+			void reset()
+			{
+				for (size_t idx = 0; idx < bucket_count; idx++)
+					buckets_[idx].store(0, std::memory_order_relaxed);
+				max_.store(0, std::memory_order_relaxed);
+				sum_.store(0, std::memory_order_relaxed);
+			}
+
+			/**
+			* \brief 计算分位数
+			*/
+			latency_summary summary() const
+			{
+				int64 counts[bucket_count];
+				latency_summary result;
+				result.count = 0;
+				for (size_t idx = 0; idx < bucket_count; idx++)
+				{
+					counts[idx] = buckets_[idx].load(std::memory_order_relaxed);
+					result.count += counts[idx];
+				}
+				result.max = max_.load(std::memory_order_relaxed);
+				result.sum = sum_.load(std::memory_order_relaxed);
+				result.p50 = percentile(counts, result.count, 0.5);
+				result.p99 = percentile(counts, result.count, 0.99);
+				result.p999 = percentile(counts, result.count, 0.999);
+				//桶的上界可能超过实际最大值
+				if (result.p50 > result.max)
+					result.p50 = result.max;
+				if (result.p99 > result.max)
+					result.p99 = result.max;
+				if (result.p999 > result.max)
+					result.p999 = result.max;
+				return result;
+			}
+		private:
+			static int64 percentile(const int64(&counts)[bucket_count], int64 total, double quantile)
+			{
+				if (total == 0)
+					return 0;
+				int64 rank = static_cast<int64>(quantile * static_cast<double>(total) + 0.5);
+				if (rank < 1)
+					rank = 1;
+				int64 seen = 0;
+				for (size_t idx = 0; idx < bucket_count; idx++)
+				{
+					seen += counts[idx];
+					if (seen >= rank)
+						return highest_of(idx);
+				}
+				return highest_of(bucket_count - 1);
+			}
+		};
+
+		/**
+		 * \brief 一组请求阶段的延时
+		 */
+		struct latency_set
+		{
+			/**
+			* \brief 请求进入到发往工作者
+			*/
+			latency_histogram queue;
+			/**
+			* \brief 发往工作者到工作者返回
+			*/
+			latency_histogram worker;
+			/**
+			* \brief 请求进入到工作者返回
+			*/
+			latency_histogram total;
+		};
+	}
+}
+#endif //!_AGEBULL_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,99 @@
+#pragma once
+#ifndef _AGEBULL_MPSC_QUEUE_H_
+#define _AGEBULL_MPSC_QUEUE_H_
+#include "../stdinc.h"
+#include <atomic>
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		 * \brief 多生产者单消费者的无锁队列
+		 * \remark
+		 * 链表实现(Vyukov):生产者以一次原子交换挂到队尾,不加锁也不等待;
+		 * 只允许一个线程取出.生产者交换与链接之间的短暂间隙里,取出可能暂时看不到其后的元素,
+		 * 调用者应在生产者完成放入后再通知消费者(如写eventfd),以免漏取.
+		 * \tparam T 元素类型(须可默认构造与移动)
+		 */
+		template <typename T>
+		class mpsc_queue
+		{
+			/**
+			* \brief 节点
+			*/
+			struct node
+			{
+				std::atomic<node*> next;
+				T value;
+
+				node()
+					: next(nullptr)
+				{
+				}
+			};
+			/**
+			* \brief 最后放入的节点(生产者交换)
+			*/
+			std::atomic<node*> head_;
+			char padding_[64 - sizeof(std::atomic<node*>)];
+			/**
+			* \brief 已取出的最后一个节点(只由消费者访问,其后为待取出的元素)
+			*/
+			node* tail_;
+		public:
+			/**
+			* \brief 构造
+			*/
+			mpsc_queue()
+			{
+				node* stub = new node();
+				head_.store(stub, std::memory_order_relaxed);
+				tail_ = stub;
+			}
+
+			/**
+			* \brief 析构(未取出的元素一并释放)
+			*/
+			~mpsc_queue()
+			{
+				T value;
+				while (pop(value))
+				{
+				}
+				delete tail_;
+			}
+
+			mpsc_queue(const mpsc_queue&) = delete;
+			mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+			/**
+			* \brief 放入(任意线程)
+			*/
+			void push(T&& value)
+			{
+				node* item = new node();
+				item->value = std::move(value);
+				node* prev = head_.exchange(item, std::memory_order_acq_rel);
+				prev->next.store(item, std::memory_order_release);
+			}
+
+			/**
+			* \brief 取出(只在消费者线程调用)
+			* \return 为空时返回false
+			*/
+			bool pop(T& value)
+			{
+				node* tail = tail_;
+				node* next = tail->next.load(std::memory_order_acquire);
+				if (next == nullptr)
+					return false;
+				value = std::move(next->value);
+				tail_ = next;
+				delete tail;
+				return true;
+			}
+		};
+	}
+}
+#endif //!_AGEBULL_MPSC_QUEUE_H_
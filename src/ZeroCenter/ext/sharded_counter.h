@@ -0,0 +1,209 @@
+#pragma once
+#ifndef _AGEBULL_SHARDED_COUNTER_H_
+#define _AGEBULL_SHARDED_COUNTER_H_
+#include "../stdinc.h"
+#include <atomic>
+#include <chrono>
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		 * \brief 分片计数器
+		 * \remark
+		 * 每个线程固定写入一个分片(按线程首次使用的顺序轮流分配),分片之间相隔一个缓存行,
+		 * 不同线程的累加互不干扰;读取时汇总全部分片.
+		 * 分片按64字节间隔排列,无论对象起始地址如何对齐,任意两个分片都不会落在同一缓存行.
+		 */
+		class sharded_counter
+		{
+		public:
+			/**
+			* \brief 分片数量
+			*/
+			static const size_t shard_count = 16;
+		private:
+			/**
+			* \brief 分片(填充到缓存行大小)
+			*/
+			struct shard
+			{
+				std::atomic<int64> value;
+				char padding[64 - sizeof(std::atomic<int64>)];
+			};
+			/**
+			* \brief 分片
+			*/
+			shard shards_[shard_count];
+
+			/**
+			* \brief 当前线程使用的分片
+			*/
+			static size_t shard_index()
+			{
+				static std::atomic<size_t> next(0);
+				static thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % shard_count;
+				return index;
+			}
+		public:
+			/**
+			* \brief 构造
+			*/
+			sharded_counter()
+			{
+				for (size_t idx = 0; idx < shard_count; idx++)
+					shards_[idx].value.store(0, std::memory_order_relaxed);
+			}
+
+			sharded_counter(const sharded_counter&) = delete;
+			sharded_counter& operator=(const sharded_counter&) = delete;
+
+			/**
+			* \brief 累加
+			*/
+			void add(int64 value)
+			{
+				shards_[shard_index()].value.fetch_add(value, std::memory_order_relaxed);
+			}
+
+			void operator++()
+			{
+				add(1);
+			}
+
+			void operator++(int)
+			{
+				add(1);
+			}
+
+			/**
+			* \brief 汇总
+			*/
+			int64 load() const
+			{
+				int64 value = 0;
+				for (size_t idx = 0; idx < shard_count; idx++)
+					value += shards_[idx].value.load(std::memory_order_relaxed);
+				return value;
+			}
+
+			operator int64() const
+			{
+				return load();
+			}
+
+			/**
+			* \brief 重置为指定值(只在没有并发累加时使用,如读取配置)
+			*/
+			sharded_counter& operator=(int64 value)
+			{
+				shards_[0].value.store(value, std::memory_order_relaxed);
+				for (size_t idx = 1; idx < shard_count; idx++)
+					shards_[idx].value.store(0, std::memory_order_relaxed);
+				return *this;
+			}
+		};
+
+		/**
+		 * \brief 由计数采样计算的速率(条/秒)
+		 * \remark
+		 * 采样间隔不小于1秒,保留最近64个采样;窗口速率为当前值与窗口起点之前最近一次采样之差除以间隔,
+		 * 运行时间不足一个窗口时以最早的采样为起点.非线程安全,由调用者加锁.
+		 * \tparam N 计数的数量
+		 */
+		template <size_t N>
+		class counter_rates
+		{
+		public:
+			/**
+			* \brief 保留的采样数量
+			*/
+			static const size_t sample_count = 64;
+			/**
+			* \brief 最小采样间隔(毫秒)
+			*/
+			static const int64 sample_interval = 1000;
+		private:
+			/**
+			* \brief 采样
+			*/
+			struct sample
+			{
+				int64 time;
+				int64 values[N];
+			};
+			/**
+			* \brief 采样环
+			*/
+			sample samples_[sample_count];
+			/**
+			* \brief 已有的采样数量
+			*/
+			size_t count_;
+			/**
+			* \brief 下一个写入位置
+			*/
+			size_t next_;
+
+			const sample& at(size_t age) const
+			{
+				return samples_[(next_ + sample_count - 1 - age) % sample_count];
+			}
+		public:
+			/**
+			* \brief 构造
+			*/
+			counter_rates()
+				: count_(0)
+				, next_(0)
+			{
+			}
+
+			/**
+			* \brief 当前时间(单调时钟,毫秒)
+			*/
+			static int64 now()
+			{
+				return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			}
+
+			/**
+			* \brief 采样(距上次采样不足 sample_interval 时忽略)
+			*/
+			void add_sample(int64 time, const int64(&values)[N])
+			{
+				if (count_ > 0 && time - at(0).time < sample_interval)
+					return;
+				sample& item = samples_[next_];
+				item.time = time;
+				memcpy(item.values, values, sizeof(item.values));
+				next_ = (next_ + 1) % sample_count;
+				if (count_ < sample_count)
+					++count_;
+			}
+
+			/**
+			* \brief 窗口内的速率
+			* \param time 当前时间
+			* \param values 当前计数
+			* \param index 计数序号
+			* \param window 窗口(毫秒)
+			*/
+			double rate(int64 time, const int64(&values)[N], size_t index, int64 window) const
+			{
+				if (count_ == 0)
+					return 0;
+				size_t age = 0;
+				while (age + 1 < count_ && time - at(age).time < window)
+					++age;
+				const sample& base = at(age);
+				const int64 span = time - base.time;
+				if (span <= 0)
+					return 0;
+				return static_cast<double>(values[index] - base.values[index]) * 1000.0 / static_cast<double>(span);
+			}
+		};
+	}
+}
+#endif //!_AGEBULL_SHARDED_COUNTER_H_
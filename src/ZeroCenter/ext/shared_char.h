@@ -3,6 +3,8 @@
 #include "../rpc/zero_default.h"
 #include <acl/acl_cpp/stdlib/string.hpp>
 #include <zeromq/zmq.h>
+#include "frame_pool.h"
+#include "global_id.h"
 
 namespace agebull
 {
@@ -10,13 +12,29 @@ namespace agebull
 	{
 		/**
 		 * \brief 字节智能指针
+		 * \remark
+		 * 不超过 sbo_size 字节的内容存放在对象内部,复制时按值复制,不共享;
+		 * 更大的内容存放在带引用计数头的单块内存中(由frame_pool分配),复制时共享,计数为原子操作,可跨线程传递.
+		 * 内容之后始终保留至少8个零字节,可直接作为C字符串使用.
 		 */
 		class shared_char
 		{
-			int* count_;
+		public:
+			/**
+			* \brief 内部存储的最大内容长度
+			*/
+			static const size_t sbo_size = 32;
+		private:
+			/**
+			* \brief 内部存储的容量(含结尾的零字节)
+			*/
+			static const size_t inline_size = sbo_size + 8;
+			/**
+			* \brief 共享内存块(内部存储或空时为nullptr)
+			*/
+			shared_block* block_;
 			char* buffer_;
 			size_t size_;
-			size_t alloc_size_;
 			/**
 			* \bref 是否二进制,0 不确定,1 文本,2 二进制
 			*/
@@ -25,87 +43,67 @@ namespace agebull
 			* \bref 是否固定值
 			*/
 			bool is_const_;
+			/**
+			* \brief 内部存储
+			*/
+			char inline_[inline_size];
 		public:
 
-			shared_char() : count_(nullptr), buffer_(nullptr), size_(0), alloc_size_(0), is_binary_(0), is_const_(false)
+			shared_char() : block_(nullptr), buffer_(nullptr), size_(0), is_binary_(0), is_const_(false)
 			{
 			}
 
-			shared_char(const shared_char& fri) : count_(fri.count_), buffer_(fri.buffer_), size_(fri.size_),
-				alloc_size_(fri.alloc_size_), is_binary_(fri.is_binary_), is_const_(false)
+			shared_char(const shared_char& fri) : block_(nullptr), buffer_(nullptr), size_(0), is_binary_(0), is_const_(false)
 			{
-				if (count_ != nullptr)
-					*count_ += 1;
+				share_(fri);
 			}
 
-			shared_char(char* buffer, int len) : count_(new int()), buffer_(buffer), size_(len), alloc_size_(len),
-				is_binary_(2), is_const_(false)
+			shared_char(shared_char&& fri) noexcept : block_(nullptr), buffer_(nullptr), size_(0), is_binary_(0), is_const_(false)
 			{
-				*count_ = 1;
+				move_(fri);
 			}
 
-			shared_char(const char* buffer)
+			shared_char(const char* buffer) : block_(nullptr), buffer_(nullptr), size_(0), is_binary_(0), is_const_(false)
 			{
 				if (buffer == nullptr)
-				{
-					set_empty();
 					return;
-				}
-				size_ = strlen(buffer);
-				if (size_ == 0)
-				{
-					set_empty();
+				const size_t size = strlen(buffer);
+				if (size == 0)
 					return;
-				}
-				copy_(size_, buffer);
+				copy_(size, buffer);
 				is_binary_ = 1;
 			}
 
-			shared_char(zmq_msg_t& msg)
+			shared_char(zmq_msg_t& msg) : block_(nullptr), buffer_(nullptr), size_(0), is_binary_(0), is_const_(false)
 			{
-				size_ = zmq_msg_size(&msg);
-				if (size_ == 0)
-				{
-					set_empty();
+				const size_t size = zmq_msg_size(&msg);
+				if (size == 0)
 					return;
-				}
-				copy_(size_, zmq_msg_data(&msg));
+				copy_(size, zmq_msg_data(&msg));
 			}
 
-			shared_char(const std::string& msg)
+			shared_char(const std::string& msg) : block_(nullptr), buffer_(nullptr), size_(0), is_binary_(0), is_const_(false)
 			{
-				size_ = msg.length();
-				if (size_ == 0)
-				{
-					set_empty();
+				if (msg.length() == 0)
 					return;
-				}
-				copy_(size_, msg.c_str());
+				copy_(msg.length(), msg.c_str());
 			}
 
 			/**
 			 *\bref 用指定大小构造(注意不是等于)
 			**/
-			explicit shared_char(size_t size) : buffer_(nullptr), is_binary_(0), is_const_(false)
+			explicit shared_char(size_t size) : block_(nullptr), buffer_(nullptr), size_(0), is_binary_(0), is_const_(false)
 			{
-				size_ = size;
-				if (size_ == 0)
-				{
-					set_empty();
+				if (size == 0)
 					return;
-				}
-				alloc_(size_);
+				alloc_(size);
 			}
 
-			shared_char(const acl::string& msg) : is_binary_(1), is_const_(false)
+			shared_char(const acl::string& msg) : block_(nullptr), buffer_(nullptr), size_(0), is_binary_(1), is_const_(false)
 			{
-				size_ = msg.length();
-				if (size_ == 0)
-				{
-					set_empty();
+				if (msg.length() == 0)
 					return;
-				}
-				copy_(size_, msg.c_str());
+				copy_(msg.length(), msg.c_str());
 			}
 
 			~shared_char()
@@ -114,15 +112,6 @@ namespace agebull
 			}
 
 		private:
-			void set_empty()
-			{
-				size_ = 0;
-				buffer_ = nullptr;
-				count_ = nullptr;
-				alloc_size_ = 0;
-				is_binary_ = 0;
-			}
-
 			void alloc(size_t size)
 			{
 				free();
@@ -131,90 +120,139 @@ namespace agebull
 
 			void free()
 			{
-				if (count_ == nullptr || size_ == 0)
-					return;
-				int cnt = --(*count_);
-				if (cnt == 0)
-				{
-					delete count_;
-					delete[] buffer_;
-				}
-				count_ = nullptr;
+				if (block_ != nullptr && block_->count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					release_block(block_);
+				block_ = nullptr;
 				buffer_ = nullptr;
 				size_ = 0;
 				is_binary_ = 0;
-				alloc_size_ = 0;
 				is_const_ = false;
 			}
 
+			/**
+			* \brief 分配(内容清零)
+			*/
 			void alloc_(size_t size)
 			{
-				size_ = size;
-				alloc_size_ = size_ + 8;
-				buffer_ = new char[alloc_size_];
-				memset(buffer_, 0, alloc_size_);
-				count_ = new int();
-				*count_ = 1;
-				is_const_ = false;
+				reserve_(size, size + 8);
+				memset(buffer_, 0, size + 8);
+			}
+
+			/**
+			* \brief 独占且容量足够时保留原存储,否则重新分配
+			*/
+			void reuse_(size_t size)
+			{
+				if (buffer_ == nullptr || is_const_ || size + 8 > alloc_size() || (block_ != nullptr && block_->count.load(std::memory_order_acquire) != 1))
+				{
+					free();
+					alloc_(size);
+				}
 			}
 
+			/**
+			* \brief 分配并复制
+			*/
 			void copy_(size_t size, const void* src)
 			{
-				size_ = size;
-				count_ = new int();
-				*count_ = 1;
-				is_const_ = false;
-				alloc_size_ = size_ + 8;
-				buffer_ = new char[alloc_size_];
+				reserve_(size, size + 8);
 				memcpy(buffer_, src, size);
-				memset(buffer_ + size, 0, 4);
+				memset(buffer_ + size, 0, 8);
 			}
 
-		public:
 			/**
-			* \brief 绑定游离内存
+			* \brief 取得存储:容量足够时使用内部存储,否则分配共享块
 			*/
-			shared_char& binding(char* fri, size_t len)
+			void reserve_(size_t size, size_t capacity)
 			{
-				free();
-				size_ = len;
-				alloc_size_ = len;
-				buffer_ = fri;
-				count_ = new int();
-				*count_ = 1;
-				return *this;
+				size_ = size;
+				is_const_ = false;
+				if (capacity <= inline_size)
+				{
+					block_ = nullptr;
+					buffer_ = inline_;
+					return;
+				}
+				block_ = alloc_block(capacity);
+				buffer_ = reinterpret_cast<char*>(block_ + 1);
 			}
 
 			/**
-			* \brief 交换
+			* \brief 共享(内部存储按值复制)
 			*/
-			shared_char& swap(shared_char& fri) noexcept
+			void share_(const shared_char& fri)
 			{
+				if (fri.buffer_ == nullptr)
+					return;
+				if (fri.block_ != nullptr)
 				{
-					char* tmp = buffer_;
+					fri.block_->count.fetch_add(1, std::memory_order_relaxed);
+					block_ = fri.block_;
 					buffer_ = fri.buffer_;
-					fri.buffer_ = tmp;
-				}
-				{
-					int* tmp = count_;
-					count_ = fri.count_;
-					fri.count_ = tmp;
 				}
+				else
 				{
-					const size_t tmp = size_;
-					size_ = fri.size_;
-					fri.size_ = tmp;
+					memcpy(inline_, fri.inline_, inline_size);
+					buffer_ = inline_;
 				}
+				size_ = fri.size_;
+				is_binary_ = fri.is_binary_;
+			}
+
+			/**
+			* \brief 转移(对方置为空)
+			*/
+			void move_(shared_char& fri) noexcept
+			{
+				if (fri.buffer_ == nullptr)
+					return;
+				if (fri.block_ != nullptr)
 				{
-					const size_t tmp = alloc_size_;
-					alloc_size_ = fri.alloc_size_;
-					fri.alloc_size_ = tmp;
+					block_ = fri.block_;
+					buffer_ = fri.buffer_;
 				}
+				else
 				{
-					const int tmp = is_binary_;
-					is_binary_ = fri.is_binary_;
-					fri.is_binary_ = tmp;
+					memcpy(inline_, fri.inline_, inline_size);
+					buffer_ = inline_;
 				}
+				size_ = fri.size_;
+				is_binary_ = fri.is_binary_;
+				is_const_ = fri.is_const_;
+				fri.block_ = nullptr;
+				fri.buffer_ = nullptr;
+				fri.size_ = 0;
+				fri.is_binary_ = 0;
+				fri.is_const_ = false;
+			}
+
+			/**
+			* \brief 分配共享块(计数为1)
+			*/
+			static shared_block* alloc_block(size_t capacity)
+			{
+				return frame_pool::alloc(capacity);
+			}
+
+			/**
+			* \brief 释放共享块
+			*/
+			static void release_block(shared_block* block)
+			{
+				frame_pool::release(block);
+			}
+
+		public:
+			/**
+			* \brief 交换
+			*/
+			shared_char& swap(shared_char& fri) noexcept
+			{
+				if (this == &fri)
+					return *this;
+				shared_char tmp(std::move(fri));
+				fri.move_(*this);
+				move_(tmp);
 				return *this;
 			}
 
@@ -225,7 +263,9 @@ namespace agebull
 
 			int user_count() const
 			{
-				return count_ == nullptr ? 0 : *count_;
+				if (block_ != nullptr)
+					return block_->count.load(std::memory_order_relaxed);
+				return buffer_ == nullptr ? 0 : 1;
 			}
 
 			size_t size() const
@@ -234,7 +274,9 @@ namespace agebull
 			}
 			size_t alloc_size() const
 			{
-				return alloc_size_;
+				if (block_ != nullptr)
+					return block_->capacity;
+				return buffer_ == nullptr ? 0 : inline_size;
 			}
 
 			bool empty() const
@@ -247,34 +289,57 @@ namespace agebull
 				return buffer_ == nullptr || idx >= size_ ? '\0' : buffer_[idx];
 			}
 
+			/**
+			* \brief 复制内容,独占且容量足够时复用现有存储,否则重新分配
+			*/
+			shared_char& assign(const void* src, size_t size)
+			{
+				if (size == 0)
+				{
+					free();
+					return *this;
+				}
+				if (buffer_ == nullptr || size + 8 > alloc_size() || (block_ != nullptr && block_->count.load(std::memory_order_acquire) != 1))
+				{
+					free();
+					copy_(size, src);
+					return *this;
+				}
+				memcpy(buffer_, src, size);
+				memset(buffer_ + size, 0, 8);
+				size_ = size;
+				is_binary_ = 0;
+				is_const_ = false;
+				return *this;
+			}
+
 			shared_char& operator =(zmq_msg_t& msg)
 			{
 				free();
-				size_ = zmq_msg_size(&msg);
-				if (size_ == 0)
+				const size_t size = zmq_msg_size(&msg);
+				if (size == 0)
 					return *this;
-				copy_(size_, zmq_msg_data(&msg));
+				copy_(size, zmq_msg_data(&msg));
 				return *this;
 			}
 
 			shared_char& operator =(const std::string& msg)
 			{
 				free();
-				is_binary_ = 1;
-				size_ = msg.length();
-				if (size_ == 0)
+				if (msg.length() == 0)
 					return *this;
-				copy_(size_, msg.c_str());
+				copy_(msg.length(), msg.c_str());
+				is_binary_ = 1;
 				return *this;
 			}
 
 			shared_char& operator =(const char* msg)
 			{
 				free();
-				size_ = strlen(msg);
-				if (size_ == 0)
+				const size_t size = strlen(msg);
+				if (size == 0)
 					return *this;
-				copy_(size_, msg);
+				copy_(size, msg);
 				is_binary_ = 1;
 				return *this;
 			}
@@ -321,40 +386,56 @@ namespace agebull
 				return *this;
 			}
 
+			/**
+			* \brief 设置为十六进制文本(全局标识的文本形式)
+			*/
 			shared_char& set_int64x(const int64 value)
 			{
-				if (size_ < 16)
-				{
-					alloc(16);
-				}
+				reuse_(id_codec::hex_size);
+				size_ = id_codec::to_hex(static_cast<uint64_t>(value), buffer_);
+				memset(buffer_ + size_, 0, 8);
 				is_binary_ = 1;
-				sprintf(buffer_, "%llx", value);
+				return *this;
+			}
+
+			/**
+			* \brief 设置为8字节二进制(全局标识的二进制帧,ZERO_FRAME_GLOBAL_ID_BIN)
+			*/
+			shared_char& set_int64b(const int64 value)
+			{
+				reuse_(id_codec::bin_size);
+				id_codec::to_bin(static_cast<uint64_t>(value), buffer_);
+				memset(buffer_ + id_codec::bin_size, 0, 8);
+				size_ = id_codec::bin_size;
+				is_binary_ = 0;
 				return *this;
 			}
 
 			shared_char& operator =(const acl::string& msg)
 			{
 				free();
-				is_binary_ = 1;
-				size_ = msg.length();
-				if (size_ == 0)
+				if (msg.length() == 0)
 					return *this;
-				copy_(size_, msg.c_str());
+				copy_(msg.length(), msg.c_str());
+				is_binary_ = 1;
 				return *this;
 			}
 
 			shared_char& operator =(const shared_char& fri)
 			{
+				if (this == &fri)
+					return *this;
 				free();
-				if (fri.buffer_ != nullptr)
-				{
-					buffer_ = fri.buffer_;
-					size_ = fri.size_;
-					count_ = fri.count_;
-					*count_ += 1;
-					is_binary_ = fri.is_binary_;
-					alloc_size_ = fri.alloc_size_;
-				}
+				share_(fri);
+				return *this;
+			}
+
+			shared_char& operator =(shared_char&& fri) noexcept
+			{
+				if (this == &fri)
+					return *this;
+				free();
+				move_(fri);
 				return *this;
 			}
 
@@ -515,7 +596,7 @@ namespace agebull
 
 			char frame_type(size_t index) const
 			{
-				return alloc_size_ < index ? 0 : buffer_[index + 2];
+				return alloc_size() < index + 3 ? 0 : buffer_[index + 2];
 			}
 
 			void append_frame(char type)
@@ -529,20 +610,24 @@ namespace agebull
 			void frame_type(size_t index, char type)
 			{
 				index += 2;
-				if (alloc_size_ > index)
+				const size_t alloc_size = this->alloc_size();
+				if (alloc_size > index + 1)
 				{
+					//池中的块容量按等级取整,超出原内容的部分未清零
 					if (index >= size_)
+					{
+						memset(buffer_ + size_, 0, index + 2 - size_);
 						size_ = index + 1;
+					}
 				}
 				else
 				{
-					char* old = buffer_;
-					buffer_ = new char[index + 8];
-					memcpy(buffer_, old, alloc_size_);
-					memset(buffer_ + alloc_size_, 0, index + 8 - alloc_size_);
-					delete[] old;
-					size_ = index + 4;
-					alloc_size_ = index + 8;
+					//扩容后为独占的新存储,不影响其它共享者
+					shared_char old(std::move(*this));
+					reserve_(index + 4, index + 8);
+					memcpy(buffer_, old.buffer_, old.size_);
+					memset(buffer_ + old.size_, 0, index + 8 - old.size_);
+					is_binary_ = old.is_binary_;
 				}
 				buffer_[index] = type;
 			}
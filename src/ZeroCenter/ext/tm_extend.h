@@ -4,8 +4,16 @@
 #include <ctime>
 #include <cstdio>
 #include <string>
+#include <chrono>
 namespace agebull
 {
+	/**
+	* \brief 单调时钟(微秒),只用于计算时间间隔
+	*/
+	inline long long time_us()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
 	inline void today_str(char *str, int zone)
 	{
 		time_t tt = time(nullptr);
@@ -41,6 +41,156 @@ namespace agebull
 	///C端命令调用队列锁
 	boost::mutex server_cmd_mutex;
 
+	/**
+	* \bref 日志记录的类型
+	*/
+	enum class log_kind
+	{
+		msg, warn, error, fatal, debug, trace
+	};
+
+	/**
+	* \bref 已格式化的日志记录
+	* \remark fname与func来自__FILE__与__FUNCTION__,为静态字符串,只保存指针
+	*/
+	struct log_record
+	{
+		log_kind kind;
+		int section;
+		int level;
+		int line;
+		const char* fname;
+		const char* func;
+		boost::posix_time::ptime time;
+		/**
+		* \brief 内容(槽位复用时保留容量,稳定后写入不再分配内存)
+		*/
+		string text;
+	};
+
+	/**
+	* \bref 单生产者单消费者的日志环(每个写日志的线程一个)
+	* \remark 生产者为所属线程,消费者为后台写入线程;环满时丢弃并计数,不阻塞生产者
+	*/
+	class log_ring
+	{
+		vector<log_record> slots_;
+		size_t mask_;
+		/**
+		* \brief 写入位置(只由生产者修改)
+		*/
+		std::atomic<size_t> head_;
+		char padding1_[64 - sizeof(std::atomic<size_t>)];
+		/**
+		* \brief 读取位置(只由消费者修改)
+		*/
+		std::atomic<size_t> tail_;
+		char padding2_[64 - sizeof(std::atomic<size_t>)];
+	public:
+		/**
+		* \brief 环满丢弃的记录数
+		*/
+		std::atomic<int64> dropped;
+		/**
+		* \brief 所属线程已结束
+		*/
+		std::atomic<bool> closed;
+
+		/**
+		* \brief 构造
+		* \param size 槽位数量(向上取整为2的幂)
+		*/
+		explicit log_ring(size_t size)
+			: head_(0)
+			, tail_(0)
+			, dropped(0)
+			, closed(false)
+		{
+			size_t capacity = 2;
+			while (capacity < size)
+				capacity <<= 1;
+			slots_.resize(capacity);
+			mask_ = capacity - 1;
+		}
+
+		/**
+		* \brief 取得可写入的槽位(生产者),环满时返回空
+		*/
+		log_record* acquire()
+		{
+			const size_t head = head_.load(std::memory_order_relaxed);
+			if (head - tail_.load(std::memory_order_acquire) >= slots_.size())
+				return nullptr;
+			return &slots_[head & mask_];
+		}
+
+		/**
+		* \brief 发布已写入的槽位(生产者)
+		*/
+		void publish()
+		{
+			head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		/**
+		* \brief 最早的记录(消费者),为空时返回空
+		*/
+		const log_record* front() const
+		{
+			const size_t tail = tail_.load(std::memory_order_relaxed);
+			if (tail == head_.load(std::memory_order_acquire))
+				return nullptr;
+			return &slots_[tail & mask_];
+		}
+
+		/**
+		* \brief 释放最早的记录(消费者)
+		*/
+		void pop()
+		{
+			tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		bool empty() const
+		{
+			return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+		}
+	};
+
+	/**
+	* \bref 线程结束时标记其日志环(由写入线程写完后回收)
+	*/
+	struct log_ring_holder
+	{
+		shared_ptr<log_ring> ring;
+		~log_ring_holder()
+		{
+			if (ring)
+				ring->closed.store(true, std::memory_order_release);
+		}
+	};
+
+	/**
+	* \bref 是否由后台线程写入
+	*/
+	static std::atomic<bool> log_async_(false);
+	/**
+	* \bref 全部日志环(只在登记,回收与复制时加锁)
+	*/
+	static vector<shared_ptr<log_ring>> log_rings_;
+	static boost::mutex log_rings_mutex_;
+	/**
+	* \bref 日志环登记表的版本(写入线程据此决定是否重新复制)
+	*/
+	static std::atomic<uint64_t> log_rings_version_(0);
+	/**
+	* \bref 后台写入线程
+	*/
+	static boost::thread* log_thread_ = nullptr;
+	static thread_local log_ring_holder log_local_ring_;
+
+	void log_write_loop();
+
 	/**
 	* \bref 初始化日志
 	*/
@@ -50,6 +200,11 @@ namespace agebull
 		log.append("logs/zero_center.log");
 		acl::acl_cpp_init();
 		logger_open(log, "zero_center", DEBUG_CONFIG);
+		if (json_config::log_ring_size > 0 && log_thread_ == nullptr)
+		{
+			log_async_.store(true, std::memory_order_release);
+			log_thread_ = new boost::thread(log_write_loop);
+		}
 		return log;
 	}
 
@@ -65,40 +220,195 @@ namespace agebull
 			cout << strTime.c_str();
 		}
 	}
+
+	/**
+	* \bref 写入一条记录(控制台与acl日志)
+	*/
+	void log_write(log_kind kind, int section, int level, const char* fname, int line, const char* func, boost::posix_time::ptime time, const char* msg)
+	{
+		switch (kind)
+		{
+		case log_kind::msg:
+			out_debug(time, msg);
+			acl::log::msg1(msg);
+			break;
+		case log_kind::warn:
+			out_debug(time, msg);
+			acl::log::warn4(fname, line, func, msg);
+			break;
+		case log_kind::error:
+			out_debug(time, msg);
+			acl::log::error4(fname, line, func, msg);
+			break;
+		case log_kind::fatal:
+			out_debug(time, msg);
+			acl::log::fatal4(fname, line, func, msg);
+			break;
+		case log_kind::debug:
+			if (level < 2)
+				out_debug(time, msg);
+			acl::log::msg6(section, level, fname, line, func, msg);
+			break;
+		case log_kind::trace:
+			if (level < 2)
+				out_debug(time, msg);
+			acl::log::msg1(msg);
+			break;
+		}
+	}
+
+	/**
+	* \bref 写出一个日志环中的记录
+	* \param limit 最多写出的数量(避免一个线程的日志风暴饿死其它线程)
+	* \return 写出的数量
+	*/
+	size_t log_drain(log_ring& ring, size_t limit)
+	{
+		size_t count = 0;
+		const log_record* record;
+		while (count < limit && (record = ring.front()) != nullptr)
+		{
+			log_write(record->kind, record->section, record->level, record->fname, record->line, record->func, record->time, record->text.c_str());
+			ring.pop();
+			++count;
+		}
+		const int64 dropped = ring.dropped.exchange(0, std::memory_order_relaxed);
+		if (dropped > 0)
+		{
+			char msg[64];
+			sprintf(msg, "log ring full,%lld records dropped", dropped);
+			log_write(log_kind::warn, 0, 0, __FILE__, __LINE__, __FUNCTION__, boost::posix_time::microsec_clock::local_time(), msg);
+		}
+		return count;
+	}
+
+	/**
+	* \bref 后台写入线程
+	*/
+	void log_write_loop()
+	{
+		vector<shared_ptr<log_ring>> rings;
+		uint64_t version = ~0ULL;
+		while (true)
+		{
+			const bool stop = !log_async_.load(std::memory_order_acquire);
+			if (version != log_rings_version_.load(std::memory_order_acquire))
+			{
+				boost::lock_guard<boost::mutex> guard(log_rings_mutex_);
+				rings = log_rings_;
+				version = log_rings_version_.load(std::memory_order_relaxed);
+			}
+			size_t count = 0;
+			for (auto& ring : rings)
+				count += log_drain(*ring, 256);
+			if (count > 0)
+				continue;
+			if (stop)
+				break;
+			//空闲时回收已结束线程的日志环
+			bool closed = false;
+			for (auto& ring : rings)
+				closed |= ring->closed.load(std::memory_order_acquire) && ring->empty();
+			if (closed)
+			{
+				boost::lock_guard<boost::mutex> guard(log_rings_mutex_);
+				log_rings_.erase(std::remove_if(log_rings_.begin(), log_rings_.end(), [](const shared_ptr<log_ring>& ring)
+				{
+					return ring->closed.load(std::memory_order_acquire) && ring->empty();
+				}), log_rings_.end());
+				log_rings_version_.fetch_add(1, std::memory_order_release);
+			}
+			thread_sleep(1);
+		}
+	}
+
+	/**
+	* \bref 停止后台写入线程(写完已排队的记录),之后的日志同步写入
+	*/
+	void log_close()
+	{
+		if (log_thread_ == nullptr)
+			return;
+		log_async_.store(false, std::memory_order_release);
+		log_thread_->join();
+		delete log_thread_;
+		log_thread_ = nullptr;
+		//停止前最后一刻排队的记录
+		boost::lock_guard<boost::mutex> guard(log_rings_mutex_);
+		for (auto& ring : log_rings_)
+			log_drain(*ring, ~static_cast<size_t>(0));
+	}
+
+	/**
+	* \bref 立即改为同步写入,不等待后台线程(崩溃处理中使用)
+	*/
+	void log_sync()
+	{
+		log_async_.store(false, std::memory_order_release);
+	}
+
+	/**
+	* \bref 放入当前线程的日志环
+	* \return 未启用后台写入时返回false,由调用者同步写入
+	*/
+	bool log_push(log_kind kind, int section, int level, const char* fname, int line, const char* func, const char* msg)
+	{
+		if (!log_async_.load(std::memory_order_acquire))
+			return false;
+		if (!log_local_ring_.ring)
+		{
+			log_local_ring_.ring = make_shared<log_ring>(static_cast<size_t>(json_config::log_ring_size));
+			boost::lock_guard<boost::mutex> guard(log_rings_mutex_);
+			log_rings_.push_back(log_local_ring_.ring);
+			log_rings_version_.fetch_add(1, std::memory_order_release);
+		}
+		log_ring& ring = *log_local_ring_.ring;
+		log_record* record = ring.acquire();
+		if (record == nullptr)
+		{
+			ring.dropped.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		record->kind = kind;
+		record->section = section;
+		record->level = level;
+		record->fname = fname;
+		record->line = line;
+		record->func = func;
+		record->time = boost::posix_time::microsec_clock::local_time();
+		record->text.assign(msg);
+		ring.publish();
+		return true;
+	}
+
 	void log_acl_msg(const char* msg)
 	{
-		out_debug(boost::posix_time::microsec_clock::local_time(), msg);
-		acl::log::msg1(msg);
+		if (!log_push(log_kind::msg, 0, 0, nullptr, 0, nullptr, msg))
+			log_write(log_kind::msg, 0, 0, nullptr, 0, nullptr, boost::posix_time::microsec_clock::local_time(), msg);
 	}
 	void log_acl_warn(const char* fname, int line, const char* func, const char* msg)
 	{
-		out_debug(boost::posix_time::microsec_clock::local_time(), msg);
-		acl::log::warn4(fname, line, func, msg);
+		if (!log_push(log_kind::warn, 0, 0, fname, line, func, msg))
+			log_write(log_kind::warn, 0, 0, fname, line, func, boost::posix_time::microsec_clock::local_time(), msg);
 	}
 	void log_acl_error(const char* fname, int line, const char* func, const char* msg)
 	{
-		out_debug(boost::posix_time::microsec_clock::local_time(), msg);
-		acl::log::error4(fname, line, func, msg);
+		if (!log_push(log_kind::error, 0, 0, fname, line, func, msg))
+			log_write(log_kind::error, 0, 0, fname, line, func, boost::posix_time::microsec_clock::local_time(), msg);
 	}
 	void log_acl_fatal(const char* fname, int line, const char* func, const char* msg)
 	{
-		out_debug(boost::posix_time::microsec_clock::local_time(), msg);
-		acl::log::fatal4(fname, line, func, msg);
+		//致命错误后进程可能立即退出,同步写入
+		log_write(log_kind::fatal, 0, 0, fname, line, func, boost::posix_time::microsec_clock::local_time(), msg);
 	}
 	void log_acl_debug(int section, int  level, const char* fname, int line, const char* func, const char* msg)
 	{
-		if (level < 2)
-		{
-			out_debug(boost::posix_time::microsec_clock::local_time(), msg);
-		}
-		acl::log::msg6(section, level, fname, line, func, msg);
+		if (!log_push(log_kind::debug, section, level, fname, line, func, msg))
+			log_write(log_kind::debug, section, level, fname, line, func, boost::posix_time::microsec_clock::local_time(), msg);
 	}
 	void log_acl_trace(int section, int  level, const char* msg)
 	{
-		if (level < 2)
-		{
-			out_debug(boost::posix_time::microsec_clock::local_time(), msg);
-		}
-		acl::log::msg1(msg);
+		if (!log_push(log_kind::trace, section, level, nullptr, 0, nullptr, msg))
+			log_write(log_kind::trace, section, level, nullptr, 0, nullptr, boost::posix_time::microsec_clock::local_time(), msg);
 	}
-}
\ No newline at end of file
+}
@@ -19,6 +19,16 @@ namespace agebull
 	*/
 	acl::string log_init();
 
+	/**
+	* \bref 停止后台写入线程(写完已排队的记录),之后的日志同步写入
+	*/
+	void log_close();
+
+	/**
+	* \bref 立即改为同步写入,不等待后台线程(崩溃处理中使用)
+	*/
+	void log_sync();
+
 	void log_acl_msg(const char* msg);
 	void log_acl_warn(const char* fname, int line, const char* func, const char* msg);
 	void log_acl_error(const char* fname, int line, const char* func, const char* msg);
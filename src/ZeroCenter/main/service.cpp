@@ -4,6 +4,8 @@
 
 #include "../stdafx.h"
 #include "service.h"
+#include "../rpc/zero_metrics.h"
+#include "../rpc/station_reactor.h"
 #include <netdb.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -21,7 +23,7 @@ namespace agebull
 	{
 		ZMQ_HANDLE zmq_context;
 		volatile NET_STATE net_state = NET_STATE_NONE;
-		//应该启动的线程数量
+		//当前启动阶段应登记(运行或失败)的线程数量,达到后放行一次
 		volatile int zero_thread_count = 0;
 		//当前启动了多少命令线程
 		volatile int zero_thread_run = 0;
@@ -33,6 +35,11 @@ namespace agebull
 		boost::interprocess::interprocess_semaphore task_semaphore(0);
 		boost::interprocess::interprocess_semaphore close_semaphore(0);
 		boost::mutex task_mutex;
+		/**
+		* \brief 网络状态变化的通知
+		*/
+		boost::mutex net_state_mutex;
+		boost::condition_variable net_state_cond;
 
 
 		/**
@@ -117,6 +124,7 @@ namespace agebull
 		void rpc_service::stop()
 		{
 			close_net_command();
+			log_close();
 			acl::log::close();
 		}
 
@@ -136,11 +144,22 @@ namespace agebull
 		}
 		void check_semaphore_start()
 		{
-			if (zero_thread_run + zero_thread_bad <= 2)
+			if (zero_thread_count > 0 && zero_thread_run + zero_thread_bad == zero_thread_count)
+			{
+				zero_thread_count = 0;
 				task_semaphore.post();
-			else
-				if ((zero_thread_run + zero_thread_bad) == zero_thread_count)
-					task_semaphore.post();
+			}
+		}
+		//等待登记(运行或失败)的线程达到数量(启动阶段的屏障)
+		void wait_command_thread(int count)
+		{
+			{
+				boost::lock_guard<boost::mutex> guard(task_mutex);
+				zero_thread_count = count;
+				//线程可能已先于设置完成登记
+				check_semaphore_start();
+			}
+			task_semaphore.wait();
 		}
 		//登记线程开始
 		void set_command_thread_run(const char* name)
@@ -173,6 +192,25 @@ namespace agebull
 			return net_state;
 		}
 
+		//设置运行状态并立即唤醒各站点,反应器与间隔休眠中的线程
+		void set_net_state(NET_STATE state)
+		{
+			{
+				boost::lock_guard<boost::mutex> guard(net_state_mutex);
+				net_state = state;
+				net_state_cond.notify_all();
+			}
+			station_warehouse::wake_all();
+			station_reactor::wake_all();
+		}
+
+		//等待网络开始关闭
+		bool wait_net_closing(int ms)
+		{
+			boost::unique_lock<boost::mutex> lock(net_state_mutex);
+			return net_state_cond.timed_wait(lock, boost::posix_time::milliseconds(ms), []() { return net_state >= NET_STATE_CLOSING; });
+		}
+
 		//初始化网络命令环境
 		int config_zero_center()
 		{
@@ -196,51 +234,58 @@ namespace agebull
 			//boost::thread thread_xxx(boost::bind(socket_ex::zmq_monitor, nullptr));
 
 			net_state = NET_STATE_RUNING;
-			reset_command_thread(static_cast<int>(station_warehouse::get_station_count()));
+			reset_command_thread(0);
+			var tm = boost::posix_time::microsec_clock::local_time();
 			log_msg("$start system dispatcher ...");
-			station_warehouse::foreach_configs([](shared_ptr<zero_config>& cfg)
+			station_warehouse::foreach_configs([](const shared_ptr<zero_config>& cfg)
 			{
 				if (cfg->station_type_ == STATION_TYPE_DISPATCHER)
 					log_msg(cfg->to_info_json());
 			});
 			station_dispatcher::run();
-			task_semaphore.wait();
+			wait_command_thread(1);
 			if (zero_thread_bad == 1)
 			{
 				log_msg("$system dispatcher failed ...");
 				return	net_state = NET_STATE_FAILED;
 			}
-			log_msg("$start plan dispatcher ...");
-			station_warehouse::foreach_configs([](shared_ptr<zero_config>& cfg)
+			var sp = boost::posix_time::microsec_clock::local_time() - tm;
+			log_msg1("$system dispatcher ready(%lldms)", static_cast<long long>(sp.total_milliseconds()));
+			//计划调度与业务站点互不依赖,同时启动,全部登记(运行或失败)后再继续
+			log_msg("$start plan dispatcher & business stations...");
+			station_warehouse::foreach_configs([](const shared_ptr<zero_config>& cfg)
 			{
-				if (cfg->station_type_ > STATION_TYPE_SPECIAL)
+				if (cfg->station_type_ > STATION_TYPE_DISPATCHER)
+				{
 					log_msg(cfg->to_info_json());
+				}
 			});
+			tm = boost::posix_time::microsec_clock::local_time();
 			plan_dispatcher::run();
-			task_semaphore.wait();
-			if (zero_thread_bad == 1)
+			const int business = station_warehouse::restore();
+			wait_command_thread(2 + business);
+			sp = boost::posix_time::microsec_clock::local_time() - tm;
+			const shared_ptr<zero_config> plan = station_warehouse::get_config("PlanDispatcher", false);
+			if (!plan || plan->is_state(station_state::Failed))
 			{
 				log_msg("$plan dispatcher failed ...");
 				return	net_state = NET_STATE_FAILED;
 			}
-			log_msg("$start business stations...");
-			station_warehouse::foreach_configs([](shared_ptr<zero_config>& cfg)
+			log_msg3("$plan dispatcher & %d business stations ready(%lldms),%d failed", business, static_cast<long long>(sp.total_milliseconds()), zero_thread_bad);
+			zero_metrics::run();
+			sp = boost::posix_time::microsec_clock::local_time() - rpc_service::start_time;
+			log_msg1("$all stations in service(%lldms),send system_start event", static_cast<long long>(sp.total_milliseconds()));
+			//启动事件为晚连接的订阅者重复发送,在后台进行,不推迟启动完成
+			boost::thread([]()
 			{
-				if (cfg->station_type_ > STATION_TYPE_DISPATCHER && cfg->station_type_ <= STATION_TYPE_SPECIAL)
+				for (int i = 0; i < 10; i++)
 				{
-					log_msg(cfg->to_info_json());
+					system_event(zero_net_event::event_system_start, nullptr, ">>Wecome ZeroNet,luck every day!<<");
+					if (wait_net_closing(50))
+						break;
 				}
 			});
-			station_warehouse::restore();
-			task_semaphore.wait();
-			var sp = boost::posix_time::microsec_clock::local_time() - rpc_service::start_time;
-			log_msg1("$all stations in service(%lldms),send system_start event", sp.total_milliseconds());
-			for (int i = 0; i < 10; i++)
-			{
-				system_event(zero_net_event::event_system_start, nullptr, ">>Wecome ZeroNet,luck every day!<<");
-				thread_sleep(50);
-			}
-			boost::posix_time::microsec_clock::local_time() - rpc_service::start_time;
+			sp = boost::posix_time::microsec_clock::local_time() - rpc_service::start_time;
 			log_msg1("$success(%lldms)\n", sp.total_milliseconds());
 			return net_state;
 		}
@@ -258,20 +303,20 @@ namespace agebull
 			var sp = tm - rpc_service::start_time;
 			log_msg3("$total run %lld:%lld:%lld", sp.hours(), sp.minutes(), sp.seconds());
 			log_msg("$closing...");
-			for (int i = 0; i < 5; i++)
-			{
-				system_event(zero_net_event::event_system_closing);
-				thread_sleep(40);
-			}
-			net_state = NET_STATE_CLOSING;
+			//事件进入系统站点的发件箱,站点结束轮询前会发送完
+			system_event(zero_net_event::event_system_closing);
+			set_net_state(NET_STATE_CLOSING);
 			task_semaphore.wait();
-			net_state = NET_STATE_CLOSED;
+			const var closing = boost::posix_time::microsec_clock::local_time() - tm;
+			set_net_state(NET_STATE_CLOSED);
 			system_event(zero_net_event::event_system_stop, nullptr, ">>ZeroNet close,see you late!<<");
 			close_semaphore.post();
 			task_semaphore.wait();
-			net_state = NET_STATE_DISTORY;
+			set_net_state(NET_STATE_DISTORY);
 			sp = boost::posix_time::microsec_clock::local_time() - tm;
-			log_msg1("$distory(%lldms)", sp.total_milliseconds());
+			log_msg4("$distory(%lldms) > stations closed(%lldms) restart(%lld times,max %lldms)", static_cast<long long>(sp.total_milliseconds()),
+				static_cast<long long>(closing.total_milliseconds()), static_cast<long long>(zero_config::restart_count.load()),
+				static_cast<long long>(zero_config::restart_max.load() / 1000));
 			log_msg("$zmq shutdown\n");
 			tm = boost::posix_time::microsec_clock::local_time();
 			zmq_ctx_shutdown(zmq_context);
@@ -140,6 +140,7 @@ namespace agebull
 		{
 			try
 			{
+				log_sync();
 				log_error("#########################################################");
 				if (SIGINT == sig)
 				{
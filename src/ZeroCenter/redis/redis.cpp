@@ -8,6 +8,24 @@ namespace agebull
 	*/
 	static thread_local trans_redis* thread_context_ = nullptr;
 
+	zmq_net::latency_histogram trans_redis::call_latency;
+
+	/**
+	* \brief 记录一次Redis调用的耗时
+	*/
+	struct redis_call_timer
+	{
+		int64 start;
+		redis_call_timer()
+			: start(zmq_net::latency_histogram::now())
+		{
+		}
+		~redis_call_timer()
+		{
+			trans_redis::call_latency.record(zmq_net::latency_histogram::now() - start);
+		}
+	};
+
 
 	redis_live_scope::redis_live_scope() : redis_live_scope(json_config::redis_defdb)
 	{
@@ -484,6 +502,7 @@ namespace agebull
 				return true;
 			}
 		}
+		redis_call_timer timer;
 		m_redis_cmd->clear();
 		acl::string vl2;
 		if (!m_redis_cmd->get(key, vl2))
@@ -497,6 +516,7 @@ namespace agebull
 	}
 	void trans_redis::set(const char* key, acl::string&vl)
 	{
+		redis_call_timer timer;
 		if (m_trans_num > 0)
 		{
 			m_local_values[key] = vl;
@@ -512,6 +532,7 @@ namespace agebull
 	}
 	void trans_redis::set(const char* key, const char* vl)
 	{
+		redis_call_timer timer;
 		if (m_trans_num > 0)
 		{
 			m_local_values[key] = vl;
@@ -527,6 +548,7 @@ namespace agebull
 	}
 	void trans_redis::set(const char* key, const char* vl, size_t len)
 	{
+		redis_call_timer timer;
 		if (m_trans_num > 0)
 		{
 			acl::string svl;
@@ -599,6 +621,7 @@ namespace agebull
 	}
 	vector<acl::string> trans_redis::find_redis_keys(const char* find_key) const
 	{
+		redis_call_timer timer;
 		vector<acl::string> keys;
 		m_redis_cmd->clear();
 		if (m_redis_cmd->keys_pattern(find_key, &keys) < 0)
@@ -655,6 +678,7 @@ namespace agebull
 
 	size_t trans_redis::incr_redis(const char* key) const
 	{
+		redis_call_timer timer;
 		long long id;
 		if (!m_redis_cmd->incr(key, &id))
 		{
@@ -667,6 +691,7 @@ namespace agebull
 
 	bool trans_redis::lock_from_redis(const char* key) const
 	{
+		redis_call_timer timer;
 		char vl[2] = "1";
 		const int re = m_redis_cmd->setnx(key, vl);
 		if (re < 0)
@@ -681,6 +706,7 @@ namespace agebull
 	}
 	bool trans_redis::unlock_from_redis(const char* key) const
 	{
+		redis_call_timer timer;
 		if (m_redis_cmd->del(key) < 0)
 		{
 			log_error3("(%s)del(%s)时发生错误(%s)", redis_ip(), key, m_redis_cmd->result_error());
@@ -690,6 +716,7 @@ namespace agebull
 
 	bool trans_redis::get_hash(const char* key, const char* sub_key, acl::string& vl) const
 	{
+		redis_call_timer timer;
 		m_redis_cmd->clear();
 		if (!m_redis_cmd->hget(key, sub_key, vl))
 		{
@@ -702,6 +729,7 @@ namespace agebull
 
 	bool trans_redis::set_hash(const char* key, const char* sub_key, const char* vl) const
 	{
+		redis_call_timer timer;
 		m_redis_cmd->clear();
 		acl::string vl2;
 		if (m_redis_cmd->hset(key, sub_key, vl) < 0)
@@ -714,6 +742,7 @@ namespace agebull
 	}
 	bool trans_redis::get_hash(const char* key, std::map<acl::string, acl::string>& vl) const
 	{
+		redis_call_timer timer;
 		m_redis_cmd->clear();
 		if (!m_redis_cmd->hgetall(key, vl))
 		{
@@ -727,6 +756,7 @@ namespace agebull
 
 	bool trans_redis::del_hash(const char* key, const char* sub_key) const
 	{
+		redis_call_timer timer;
 		m_redis_cmd->clear();
 		acl::string vl2;
 		if (m_redis_cmd->hdel(key, sub_key) < 0)
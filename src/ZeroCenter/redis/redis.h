@@ -4,6 +4,7 @@
 #include "../stdinc.h"
 #include "../cfg/json_config.h"
 #include "../ext/shared_char.h"
+#include "../ext/latency_histogram.h"
 namespace agebull
 {
 	class redis_live_scope;
@@ -50,6 +51,10 @@ namespace agebull
 		*/
 		map<acl::string, acl::string> m_local_values;
 	public:
+		/**
+		* \brief ɱװRedisúʱ(΢)
+		*/
+		static zmq_net::latency_histogram call_latency;
 		/**
 		* \brief ļеredisĵַ
 		*/
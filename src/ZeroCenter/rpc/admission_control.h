@@ -0,0 +1,197 @@
+#pragma once
+#ifndef _ZERO_ADMISSION_CONTROL_H_
+#define _ZERO_ADMISSION_CONTROL_H_
+#include "../stdinc.h"
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		* \brief 准入控制:按未返回请求数量限制发往工作者的请求,超出的立即以过载状态回复
+		* \remark
+		* 固定模式只用上限(zero_config::get_admit_max_inflight);
+		* 自适应模式(zero_config::is_admit_adaptive)按梯度(类似CoDel)的思路观察每个间隔内工作者往返时间(发往工作者到返回)的最小值:
+		* 中心转发本身只有微秒级,排队发生在工作者端,往返时间的最小值减去基线(较长时间内的最小往返)即为工作者的排队时间.
+		* 排队时间仍超过目标说明工作者有积压,上限降为当时未返回数量的9/10(乘性减);
+		* 否则在上限被用满时加一(加性增).被接受的请求因此不会在工作者端排长队,其余的快速拒绝.
+		* 基线每隔若干间隔以当时的最小往返重设,处理耗时整体变化(如业务变慢)后不会一直误判为排队.
+		* 本身不加锁,只由站点的轮询线程访问.
+		*/
+		class admission_control
+		{
+			/**
+			* \brief 是否启用
+			*/
+			bool enable_;
+			/**
+			* \brief 是否自适应
+			*/
+			bool adaptive_;
+			/**
+			* \brief 上限的最大值
+			*/
+			double max_limit_;
+			/**
+			* \brief 上限的最小值
+			*/
+			double min_limit_;
+			/**
+			* \brief 当前上限
+			*/
+			double limit_;
+			/**
+			* \brief 目标延时(微秒)
+			*/
+			int64 target_;
+			/**
+			* \brief 观察间隔(微秒)
+			*/
+			int64 interval_;
+			/**
+			* \brief 当前间隔的结束时间(微秒)
+			*/
+			int64 interval_end_;
+			/**
+			* \brief 当前间隔内的最小延时(微秒,-1 表示没有样本)
+			*/
+			int64 min_latency_;
+			/**
+			* \brief 当前间隔内未返回数量的最大值
+			*/
+			size_t peak_inflight_;
+			/**
+			* \brief 往返时间的基线(微秒,-1 表示没有基线)
+			*/
+			int64 base_latency_;
+			/**
+			* \brief 基线已保持的间隔数
+			*/
+			int base_age_;
+		public:
+			/**
+			* \brief 基线重设的间隔数
+			*/
+			static const int base_reset = 100;
+			/**
+			* \brief 构造
+			*/
+			admission_control()
+				: enable_(false)
+				, adaptive_(false)
+				, max_limit_(0)
+				, min_limit_(1)
+				, limit_(0)
+				, target_(0)
+				, interval_(0)
+				, interval_end_(0)
+				, min_latency_(-1)
+				, peak_inflight_(0)
+				, base_latency_(-1)
+				, base_age_(0)
+			{
+			}
+
+			/**
+			* \brief 初始化
+			* \param max_inflight 未返回数量的上限(0 不限制)
+			* \param adaptive 是否自适应
+			* \param min_inflight 自适应时上限的最小值
+			* \param target 自适应的目标延时(毫秒)
+			* \param interval 自适应的观察间隔(毫秒)
+			* \param absolute 未设置上限时自适应使用的最大值
+			*/
+			void initialize(int max_inflight, bool adaptive, int min_inflight, int target, int interval, size_t absolute)
+			{
+				adaptive_ = adaptive && target > 0 && interval > 0;
+				enable_ = max_inflight > 0 || adaptive_;
+				max_limit_ = max_inflight > 0 ? static_cast<double>(max_inflight) : static_cast<double>(absolute);
+				min_limit_ = min_inflight > 0 ? std::min(static_cast<double>(min_inflight), max_limit_) : 1;
+				limit_ = max_limit_;
+				target_ = target * 1000LL;
+				interval_ = interval * 1000LL;
+				interval_end_ = 0;
+				min_latency_ = -1;
+				peak_inflight_ = 0;
+				base_latency_ = -1;
+				base_age_ = 0;
+			}
+
+			/**
+			* \brief 是否启用
+			*/
+			bool enable() const
+			{
+				return enable_;
+			}
+
+			/**
+			* \brief 当前上限
+			*/
+			int64 limit() const
+			{
+				return static_cast<int64>(limit_);
+			}
+
+			/**
+			* \brief 能否接受一个新请求
+			* \param inflight 当前未返回的数量
+			*/
+			bool admit(size_t inflight)
+			{
+				if (!enable_)
+					return true;
+				if (inflight >= peak_inflight_)
+					peak_inflight_ = inflight + 1;
+				return static_cast<double>(inflight) < limit_;
+			}
+
+			/**
+			* \brief 当前的往返基线(微秒,-1 表示没有基线)
+			*/
+			int64 base_latency() const
+			{
+				return base_latency_;
+			}
+
+			/**
+			* \brief 记录一个请求的往返时间,到达间隔时调整上限
+			* \param latency 请求发往工作者到返回的时间(微秒)
+			* \param inflight 当前未返回的数量
+			* \param now 当前时间(微秒)
+			*/
+			void sample(int64 latency, size_t inflight, int64 now)
+			{
+				if (!adaptive_)
+					return;
+				if (min_latency_ < 0 || latency < min_latency_)
+					min_latency_ = latency;
+				if (interval_end_ == 0)
+				{
+					interval_end_ = now + interval_;
+					return;
+				}
+				if (now < interval_end_)
+					return;
+				if (base_latency_ < 0 || min_latency_ < base_latency_ || ++base_age_ >= base_reset)
+				{
+					base_latency_ = min_latency_;
+					base_age_ = 0;
+				}
+				if (min_latency_ - base_latency_ > target_)
+				{
+					//整个间隔都在排队:按实际并发收缩,而不是从可能很大的上限开始慢慢减
+					limit_ = std::max(min_limit_, std::min(limit_, static_cast<double>(inflight + 1)) * 0.9);
+				}
+				else if (static_cast<double>(peak_inflight_) >= limit_)
+				{
+					limit_ = std::min(max_limit_, limit_ + 1);
+				}
+				interval_end_ = now + interval_;
+				min_latency_ = -1;
+				peak_inflight_ = inflight;
+			}
+		};
+	}
+}
+#endif //!_ZERO_ADMISSION_CONTROL_H_
@@ -1,6 +1,7 @@
 #include "../stdafx.h"
 #include "api_station.h"
 #include "inner_socket.h"
+#include "station_reactor.h"
 
 namespace agebull
 {
@@ -18,14 +19,33 @@ namespace agebull
 				set_command_thread_bad(config.station_name_.c_str());
 				return;
 			}
-			if (!station_warehouse::join(station.get()))
+			if (!station_warehouse::join(station))
 			{
 				config.failed("join warehouse");
 				set_command_thread_bad(config.station_name_.c_str());
 				return;
 			}
+			station->flights_.initialize(config.get_single_flight(), json_config::single_flight_timeout, json_config::single_flight_waiters);
 			station->task_semaphore_.post();
+			//低流量站点交给共享的反应器线程轮询,本线程结束
+			if (config.is_use_reactor())
+			{
+				station_reactor::attach(station, [station]()
+				{
+					finish(station);
+				});
+				return;
+			}
 			station->poll();
+			finish(station);
+		}
+
+		/**
+		* \brief 轮询结束后的清理与重启
+		*/
+		void api_station::finish(const shared_ptr<api_station>& station)
+		{
+			zero_config& config = station->get_config();
 			station_warehouse::left(station.get());
 			station->destruct();
 			if (!config.is_state(station_state::Stop) && get_net_state() == NET_STATE_RUNING)
@@ -61,13 +81,14 @@ namespace agebull
 					reqid = i;
 					break;
 				case ZERO_FRAME_GLOBAL_ID:
+				case ZERO_FRAME_GLOBAL_ID_BIN:
 					glid_index = i;
 					break;
 				}
 			}
 			if (glid_index == 0)
 			{
-				send_request_status(socket, *caller, ZERO_STATUS_FRAME_INVALID_ID, list, 0, reqid, reqer);
+				send_request_status(socket, caller, ZERO_STATUS_FRAME_INVALID_ID, list, 0, reqid, reqer);
 				return;
 			}
 			switch (description[1])
@@ -82,7 +103,7 @@ namespace agebull
 				//	send_request_result(iter->second);
 				//}
 				//else
-				send_request_status(socket, *caller, ZERO_STATUS_NOT_WORKER_ID, list, glid_index, reqid, reqer);
+				send_request_status(socket, caller, ZERO_STATUS_NOT_WORKER_ID, list, glid_index, reqid, reqer);
 			}break;
 			case ZERO_BYTE_COMMAND_CLOSE_REQUEST:
 			{
@@ -90,16 +111,53 @@ namespace agebull
 				const auto iter = results.find(atoll(*list[glid_index]));
 				if (iter != results.end())
 					results.erase(iter);*/
-				send_request_status(socket, *caller, ZERO_STATUS_OK_ID, list, glid_index, reqid, reqer);
+				send_request_status(socket, caller, ZERO_STATUS_OK_ID, list, glid_index, reqid, reqer);
 			}break;
 			default:
-				if (!send_response(list))
+				//单个调用者超过配额时拒绝,不占用其他调用者的容量
+				if (!take_quota(caller, list, reqer))
 				{
-					send_request_status(socket, *caller, ZERO_STATUS_NOT_WORKER_ID, list, glid_index, reqid, reqer);
+					send_request_status(socket, caller, ZERO_STATUS_QUOTA_ID, list, glid_index, reqid, reqer);
+					break;
 				}
-				else if (description[1] == ZERO_BYTE_COMMAND_PROXY)//必须返回信息到代理
 				{
-					send_request_status(socket, *caller, ZERO_STATUS_RUNING_ID, list, glid_index, reqid, reqer);
+					//相同的幂等请求正在执行时等待其结果,不再发往工作者(代理执行须立即回复,不合并)
+					string flight_key;
+					const bool coalesce = flights_.enable() && description[1] == ZERO_BYTE_COMMAND_NONE && flights_.make_key(list, flight_key);
+					const uint64_t flight_code = coalesce ? single_flight::hash(flight_key) : 0;
+					if (coalesce)
+					{
+						flight_waiter waiter{ list[0], reqer == 0 ? shared_char() : list[reqer], reqid == 0 ? shared_char() : list[reqid],
+							list[glid_index], is_global_id_bin(list, glid_index) };
+						if (flights_.join(flight_code, flight_key, waiter, latency_histogram::now()))
+						{
+							get_config().request_coalesced++;
+							break;
+						}
+					}
+					//工作者已饱和时立即拒绝,不再堆进工作者的队列
+					if (!admit())
+					{
+						send_request_status(socket, caller, ZERO_STATUS_OVERLOAD_ID, list, glid_index, reqid, reqer);
+						break;
+					}
+					if (!send_response(list))
+					{
+						breaker_result(true);
+						send_request_status(socket, caller, ZERO_STATUS_NOT_WORKER_ID, list, glid_index, reqid, reqer);
+						break;
+					}
+					trace_dispatch(list, glid_index);
+					if (coalesce)
+					{
+						vector<flight_waiter> expired;
+						flights_.lead(flight_code, flight_key, inflight_key(list[0], list[glid_index]), latency_histogram::now(), expired);
+						expire_flights(expired);
+					}
+				}
+				if (description[1] == ZERO_BYTE_COMMAND_PROXY)//必须返回信息到代理
+				{
+					send_request_status(socket, caller, ZERO_STATUS_RUNING_ID, list, glid_index, reqid, reqer);
 				}
 				break;
 			}
@@ -117,7 +175,110 @@ namespace agebull
 					results.erase(results.begin());
 				}
 			}*/
-			send_request_result(list[0][0] == '-' ? request_socket_inproc_ : request_scoket_tcp_, list);
+			send_request_result(result_socket(list[0]), list);
+			if (!flights_.empty())
+				fan_out(list);
+		}
+
+		/**
+		* \brief 定时回复超时的合并的等待者
+		*/
+		int api_station::job_timer(int64 now)
+		{
+			if (flights_.empty())
+				return -1;
+			vector<flight_waiter> expired;
+			flights_.expire(now, expired);
+			expire_flights(expired);
+			//空闲时轮询也按秒醒来检查
+			return flights_.empty() ? -1 : 1000;
+		}
+
+		/**
+		* \brief 关闭或重启时回复全部合并的等待者
+		*/
+		void api_station::job_stop()
+		{
+			if (flights_.empty())
+				return;
+			//工作者此后的返回不再分发,等待者不能一直挂起
+			vector<flight_waiter> waiters;
+			flights_.clear(waiters);
+			expire_flights(waiters, "single flight stop");
+		}
+
+		/**
+		* \brief 把合并的请求的结果分发给等待者
+		*/
+		void api_station::fan_out(vector<shared_char>& list)
+		{
+			const shared_char& description = list[1];
+			size_t glid_index = 0, reqid = 0, reqer = 0;
+			for (size_t idx = 2; idx < description.frame_size() + 2 && idx < list.size(); idx++)
+			{
+				switch (description[idx])
+				{
+				case ZERO_FRAME_REQUESTER:
+					reqer = idx;
+					break;
+				case ZERO_FRAME_REQUEST_ID:
+					reqid = idx;
+					break;
+				case ZERO_FRAME_GLOBAL_ID:
+				case ZERO_FRAME_GLOBAL_ID_BIN:
+					glid_index = idx;
+					break;
+				}
+			}
+			vector<flight_waiter> waiters;
+			if (glid_index == 0 || !flights_.finish(inflight_key(list[0], list[glid_index]), waiters))
+				return;
+			const bool global_id_bin = description[glid_index] == ZERO_FRAME_GLOBAL_ID_BIN;
+			shared_char other_description;
+			//结果帧共享,只替换各等待者自己的地址与标识
+			vector<shared_char> result(list);
+			for (auto& waiter : waiters)
+			{
+				result[0] = waiter.caller;
+				result[glid_index] = waiter.global_id;
+				if (reqer != 0)
+					result[reqer] = waiter.requester;
+				if (reqid != 0)
+					result[reqid] = waiter.request_id;
+				if (waiter.global_id_bin == global_id_bin)
+				{
+					result[1] = description;
+				}
+				else
+				{
+					//全局标识的格式与返回不同时说明帧须独立一份
+					if (other_description.empty())
+					{
+						other_description = shared_char(string(description.get_buffer(), description.size()));
+						other_description.frame_type(glid_index - 2, waiter.global_id_bin ? ZERO_FRAME_GLOBAL_ID_BIN : ZERO_FRAME_GLOBAL_ID);
+					}
+					result[1] = other_description;
+				}
+				send_request_result(result_socket(waiter.caller), result);
+			}
+		}
+
+		/**
+		* \brief 以超时状态回复合并的等待者
+		*/
+		void api_station::expire_flights(vector<flight_waiter>& waiters, const char* reason)
+		{
+			if (waiters.empty())
+				return;
+			get_config().log(reason, std::to_string(waiters.size()).c_str());
+			for (auto& waiter : waiters)
+			{
+				send_request_status(result_socket(waiter.caller), waiter.caller, ZERO_STATUS_TIMEOUT_ID,
+					waiter.global_id,
+					waiter.request_id.empty() ? frame_span() : frame_span(waiter.request_id),
+					waiter.requester.empty() ? frame_span() : frame_span(waiter.requester),
+					frame_span(), waiter.global_id_bin);
+			}
 		}
 
 	}
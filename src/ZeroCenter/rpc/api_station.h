@@ -3,6 +3,7 @@
 #pragma once
 #include "../stdinc.h"
 #include "zero_station.h"
+#include "single_flight.h"
 namespace agebull
 {
 	namespace zmq_net
@@ -12,6 +13,10 @@ namespace agebull
 		*/
 		class api_station :public zero_station
 		{
+			/**
+			* \brief 相同请求的合并(仅轮询线程使用)
+			*/
+			single_flight flights_;
 		public:
 			/**
 			* \brief 构造
@@ -54,6 +59,10 @@ namespace agebull
 			* \brief 执行
 			*/
 			static void launch(shared_ptr<api_station>& station);
+			/**
+			* \brief 轮询结束后的清理与重启
+			*/
+			static void finish(const shared_ptr<api_station>& station);
 		private:
 			/**
 			* \brief 工作开始（发送到工作者）
@@ -63,6 +72,31 @@ namespace agebull
 			* \brief 工作结束(发送到请求者)
 			*/
 			void job_end(vector<shared_char>& list) final;
+			/**
+			* \brief 定时回复超时的合并的等待者
+			*/
+			int job_timer(int64 now) final;
+			/**
+			* \brief 关闭或重启时回复全部合并的等待者
+			*/
+			void job_stop() final;
+			/**
+			* \brief 返回请求者的套接字(内部调用的地址以'-'开头)
+			*/
+			ZMQ_HANDLE result_socket(const shared_char& caller) const
+			{
+				return caller[0] == '-' ? request_socket_inproc_ : request_scoket_tcp_;
+			}
+			/**
+			* \brief 把合并的请求的结果分发给等待者
+			*/
+			void fan_out(vector<shared_char>& list);
+			/**
+			* \brief 以超时状态回复合并的等待者
+			* \param waiters 等待者
+			* \param reason 日志说明
+			*/
+			void expire_flights(vector<flight_waiter>& waiters, const char* reason = "single flight timeout");
 		};
 
 	}
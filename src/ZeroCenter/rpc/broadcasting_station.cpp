@@ -7,6 +7,7 @@
 #include "../stdafx.h"
 #include "station_warehouse.h"
 #include "broadcasting_station.h"
+#include "station_reactor.h"
 
 namespace agebull
 {
@@ -37,6 +38,7 @@ namespace agebull
 					cid = idx;
 					break;
 				case ZERO_FRAME_GLOBAL_ID:
+				case ZERO_FRAME_GLOBAL_ID_BIN:
 					gid = idx;
 					break;
 				case ZERO_FRAME_PUB_TITLE:
@@ -46,10 +48,10 @@ namespace agebull
 			}
 			if (tid == 0)
 			{
-				send_request_status(socket, *caller, ZERO_STATUS_FRAME_INVALID_ID, list, gid, rid, cid);
+				send_request_status(socket, caller, ZERO_STATUS_FRAME_INVALID_ID, list, gid, rid, cid);
 				return;
 			}
-			send_request_status(socket, *caller, ZERO_STATUS_OK_ID, list, gid, rid, cid);
+			send_request_status(socket, caller, ZERO_STATUS_OK_ID, list, gid, rid, cid);
 			list[0] = list[tid];
 			send_response(list, 0);
 		}
@@ -83,7 +85,7 @@ namespace agebull
 			datas.emplace_back(arg.c_str());
 
 			shared_char global_id;
-			global_id.set_int64x(station_warehouse::get_glogal_id());
+			datas[1].frame_type(sizeof(frames1) - 1, write_global_id(global_id, station_warehouse::get_glogal_id()));
 
 			datas.emplace_back(global_id);
 			return send_response(datas);
@@ -107,7 +109,7 @@ namespace agebull
 			datas.emplace_back(arg.c_str());
 
 			shared_char global_id;
-			global_id.set_int64x(station_warehouse::get_glogal_id());
+			datas[1].frame_type(sizeof(frames2) - 1, write_global_id(global_id, station_warehouse::get_glogal_id()));
 
 			datas.emplace_back(global_id);
 
@@ -126,13 +128,31 @@ namespace agebull
 				set_command_thread_bad(config.station_name_.c_str());
 				return;
 			}
-			if (!station_warehouse::join(station.get()))
+			if (!station_warehouse::join(station))
 			{
 				config.failed("join warehouse");
 				set_command_thread_bad(config.station_name_.c_str());
 				return;
 			}
+			//低流量站点交给共享的反应器线程轮询,本线程结束
+			if (config.is_use_reactor())
+			{
+				station_reactor::attach(station, [station]()
+				{
+					finish(station);
+				});
+				return;
+			}
 			station->poll();
+			finish(station);
+		}
+
+		/**
+		* \brief 轮询结束后的清理与重启
+		*/
+		void broadcasting_station::finish(const shared_ptr<broadcasting_station>& station)
+		{
+			zero_config& config = station->get_config();
 			station_warehouse::left(station.get());
 			station->destruct();
 			if (!config.is_state(station_state::Stop) && get_net_state() == NET_STATE_RUNING)
@@ -75,6 +75,10 @@ namespace agebull
 			*\brief 运行一个广播线程
 			*/
 			static void launch(shared_ptr<broadcasting_station> station);
+			/**
+			* \brief 轮询结束后的清理与重启
+			*/
+			static void finish(const shared_ptr<broadcasting_station>& station);
 		};
 	}
 }
@@ -0,0 +1,197 @@
+#pragma once
+#ifndef _ZERO_CALLER_QUOTA_H_
+#define _ZERO_CALLER_QUOTA_H_
+#include "../stdinc.h"
+#include <atomic>
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		* \brief 一个调用者的令牌桶
+		*/
+		struct caller_bucket
+		{
+			/**
+			* \brief 剩余令牌(百万分之一个)
+			*/
+			int64 tokens;
+			/**
+			* \brief 上次补充的时间(微秒)
+			*/
+			int64 last_time;
+			/**
+			* \brief 被拒绝的次数(第一次拒绝时由站点关联到配置中按调用者的计数,回收后重新关联)
+			*/
+			shared_ptr<std::atomic<int64>> rejected;
+		};
+
+		/**
+		* \brief 按调用者的令牌桶限流
+		* \remark
+		* 调用者标识(请求者帧或ZMQ身份)驻留为连续的序号,桶放在数组中,查找只有一次哈希.
+		* 调用者数量达到上限时先回收已补满(空闲)的桶,仍然不够时新调用者共用序号0的溢出桶,
+		* 大量伪造的身份因此也只能分到一个桶的速率.
+		* 本身不加锁,只由站点的轮询线程访问.
+		*/
+		class caller_quota
+		{
+			/**
+			* \brief 一个令牌的单位
+			*/
+			static const int64 token_unit = 1000000LL;
+			/**
+			* \brief 每秒补充的令牌数(0 不限流)
+			*/
+			int64 rate_;
+			/**
+			* \brief 桶容量(已乘单位)
+			*/
+			int64 capacity_;
+			/**
+			* \brief 调用者数量上限
+			*/
+			size_t max_callers_;
+			/**
+			* \brief 调用者 => 桶序号
+			*/
+			boost::unordered_map<string, uint32_t> ids_;
+			/**
+			* \brief 桶(序号0为溢出桶)
+			*/
+			vector<caller_bucket> buckets_;
+			/**
+			* \brief 已回收可复用的序号
+			*/
+			vector<uint32_t> free_;
+			/**
+			* \brief 上次回收的时间(微秒)
+			*/
+			int64 recycle_time_;
+		public:
+			/**
+			* \brief 构造
+			*/
+			caller_quota()
+				: rate_(0)
+				, capacity_(0)
+				, max_callers_(0)
+				, recycle_time_(0)
+			{
+			}
+
+			/**
+			* \brief 初始化
+			* \param rate 每个调用者每秒的请求数(小于等于0 不限流)
+			* \param burst 允许的突发数量(小于等于0 与rate相同)
+			* \param max_callers 跟踪的调用者数量上限
+			*/
+			void initialize(int rate, int burst, int max_callers)
+			{
+				rate_ = rate > 0 ? rate : 0;
+				capacity_ = (burst > 0 ? burst : rate_) * token_unit;
+				max_callers_ = max_callers > 0 ? static_cast<size_t>(max_callers) : 1;
+				ids_.clear();
+				free_.clear();
+				buckets_.assign(1, caller_bucket{ capacity_, 0, nullptr });
+			}
+
+			/**
+			* \brief 是否启用
+			*/
+			bool enable() const
+			{
+				return rate_ > 0;
+			}
+
+			/**
+			* \brief 取得调用者的桶(不存在时驻留)
+			* \param caller 调用者标识
+			* \param now 当前时间(微秒)
+			*/
+			caller_bucket& find(const string& caller, int64 now)
+			{
+				const auto iter = ids_.find(caller);
+				if (iter != ids_.end())
+					return buckets_[iter->second];
+				if (ids_.size() >= max_callers_)
+				{
+					//回收要遍历全部桶,大量新身份涌入时每100毫秒至多一次
+					if (now - recycle_time_ >= 100000LL)
+					{
+						recycle_time_ = now;
+						recycle(now);
+					}
+					if (ids_.size() >= max_callers_)
+						return buckets_[0];
+				}
+				uint32_t id;
+				if (free_.empty())
+				{
+					id = static_cast<uint32_t>(buckets_.size());
+					buckets_.push_back(caller_bucket{ capacity_, now, nullptr });
+				}
+				else
+				{
+					id = free_.back();
+					free_.pop_back();
+					buckets_[id] = caller_bucket{ capacity_, now, nullptr };
+				}
+				ids_.emplace(caller, id);
+				return buckets_[id];
+			}
+
+			/**
+			* \brief 补充并取一个令牌
+			* \return 没有令牌时返回false
+			*/
+			bool take(caller_bucket& bucket, int64 now)
+			{
+				refill(bucket, now);
+				if (bucket.tokens < token_unit)
+					return false;
+				bucket.tokens -= token_unit;
+				return true;
+			}
+		private:
+			/**
+			* \brief 按经过的时间补充令牌
+			*/
+			void refill(caller_bucket& bucket, int64 now) const
+			{
+				const int64 elapsed = now - bucket.last_time;
+				if (elapsed <= 0)
+					return;
+				bucket.last_time = now;
+				//超过补满所需的时间按补满计,避免乘法溢出
+				if (elapsed >= capacity_ / rate_ + 1)
+					bucket.tokens = capacity_;
+				else
+					bucket.tokens = std::min(capacity_, bucket.tokens + elapsed * rate_);
+			}
+
+			/**
+			* \brief 回收已补满(空闲)的桶
+			*/
+			void recycle(int64 now)
+			{
+				for (auto iter = ids_.begin(); iter != ids_.end();)
+				{
+					caller_bucket& bucket = buckets_[iter->second];
+					refill(bucket, now);
+					if (bucket.tokens >= capacity_)
+					{
+						free_.push_back(iter->second);
+						iter = ids_.erase(iter);
+					}
+					else
+					{
+						++iter;
+					}
+				}
+			}
+		};
+	}
+}
+#endif //!_ZERO_CALLER_QUOTA_H_
@@ -0,0 +1,268 @@
+#pragma once
+#ifndef _ZERO_CIRCUIT_BREAKER_H_
+#define _ZERO_CIRCUIT_BREAKER_H_
+#include "../stdinc.h"
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		* \brief 断路器状态
+		*/
+		enum class breaker_state
+		{
+			/**
+			* \brief 闭合:正常转发
+			*/
+			closed,
+			/**
+			* \brief 断开:直接拒绝
+			*/
+			open,
+			/**
+			* \brief 半开:放行少量探测请求
+			*/
+			half_open
+		};
+
+		/**
+		* \brief 站点的断路器
+		* \remark
+		* 没有就绪的工作者时立即断开,工作者恢复后直接进入半开;
+		* 观察窗口内请求数足够且失败比例达到阈值时断开,断开时间过后且有就绪的工作者才进入半开.
+		* 半开时放行若干探测请求,第一个返回决定闭合还是再次断开,探测在断开时间内未返回按失败处理.
+		* 探测在发往工作者成功后(dispatched)才计数,被配额、准入或合并拒绝的请求不占用探测名额.
+		* 本身不加锁,只由站点的轮询线程访问.
+		*/
+		class circuit_breaker
+		{
+			/**
+			* \brief 是否启用
+			*/
+			bool enable_;
+			/**
+			* \brief 断开的失败比例(百分比,0 只按工作者断开)
+			*/
+			int error_rate_;
+			/**
+			* \brief 按失败比例断开所需的最少请求数
+			*/
+			int min_requests_;
+			/**
+			* \brief 观察窗口(微秒)
+			*/
+			int64 window_;
+			/**
+			* \brief 断开时间(微秒)
+			*/
+			int64 open_time_;
+			/**
+			* \brief 半开时的探测数量
+			*/
+			int probes_;
+			/**
+			* \brief 当前状态
+			*/
+			breaker_state state_;
+			/**
+			* \brief 当前窗口的结束时间(微秒)
+			*/
+			int64 window_end_;
+			/**
+			* \brief 当前窗口的请求数
+			*/
+			int requests_;
+			/**
+			* \brief 当前窗口的失败数
+			*/
+			int failures_;
+			/**
+			* \brief 断开到期的时间(微秒)
+			*/
+			int64 open_until_;
+			/**
+			* \brief 半开时已放行的探测数
+			*/
+			int probing_;
+			/**
+			* \brief 最后一个探测发往工作者的时间(微秒)
+			*/
+			int64 probe_time_;
+		public:
+			/**
+			* \brief 构造
+			*/
+			circuit_breaker()
+				: enable_(false)
+				, error_rate_(0)
+				, min_requests_(0)
+				, window_(0)
+				, open_time_(0)
+				, probes_(1)
+				, state_(breaker_state::closed)
+				, window_end_(0)
+				, requests_(0)
+				, failures_(0)
+				, open_until_(0)
+				, probing_(0)
+				, probe_time_(0)
+			{
+			}
+
+			/**
+			* \brief 初始化
+			* \param enable 是否启用
+			* \param error_rate 断开的失败比例(百分比,0 只按工作者断开)
+			* \param min_requests 按失败比例断开所需的最少请求数
+			* \param window 观察窗口(毫秒)
+			* \param open_time 断开时间(毫秒)
+			* \param probes 半开时的探测数量
+			*/
+			void initialize(bool enable, int error_rate, int min_requests, int window, int open_time, int probes)
+			{
+				enable_ = enable;
+				error_rate_ = error_rate > 0 ? std::min(error_rate, 100) : 0;
+				min_requests_ = min_requests > 0 ? min_requests : 1;
+				window_ = (window > 0 ? window : 10000) * 1000LL;
+				open_time_ = (open_time > 0 ? open_time : 1000) * 1000LL;
+				probes_ = probes > 0 ? probes : 1;
+				state_ = breaker_state::closed;
+				window_end_ = 0;
+				requests_ = 0;
+				failures_ = 0;
+				open_until_ = 0;
+				probing_ = 0;
+				probe_time_ = 0;
+			}
+
+			/**
+			* \brief 是否启用
+			*/
+			bool enable() const
+			{
+				return enable_;
+			}
+
+			/**
+			* \brief 当前状态
+			*/
+			breaker_state state() const
+			{
+				return state_;
+			}
+
+			/**
+			* \brief 能否转发一个请求
+			* \param ready 是否有就绪的工作者
+			* \param now 当前时间(微秒)
+			*/
+			bool allow(bool ready, int64 now)
+			{
+				switch (state_)
+				{
+				case breaker_state::closed:
+					if (ready)
+						return true;
+					trip(now, false);
+					return false;
+				case breaker_state::open:
+					if (!ready || now < open_until_)
+						return false;
+					state_ = breaker_state::half_open;
+					probing_ = 0;
+					break;
+				default:
+					if (!ready)
+					{
+						trip(now, false);
+						return false;
+					}
+					break;
+				}
+				if (probing_ < probes_)
+					return true;
+				//探测丢失(工作者未返回)时不能一直停在半开
+				if (now - probe_time_ >= open_time_)
+					trip(now, true);
+				return false;
+			}
+
+			/**
+			* \brief 记录一个请求已发往工作者,半开时计为探测
+			*/
+			void dispatched(int64 now)
+			{
+				if (state_ != breaker_state::half_open || probing_ >= probes_)
+					return;
+				++probing_;
+				probe_time_ = now;
+			}
+
+			/**
+			* \brief 记录一个成功的返回
+			*/
+			void success(int64 now)
+			{
+				if (state_ == breaker_state::half_open)
+				{
+					state_ = breaker_state::closed;
+					reset(now);
+					return;
+				}
+				if (state_ == breaker_state::closed)
+					count(now, false);
+			}
+
+			/**
+			* \brief 记录一个失败(发送失败或工作者返回错误)
+			*/
+			void failure(int64 now)
+			{
+				if (state_ == breaker_state::half_open)
+				{
+					trip(now, true);
+					return;
+				}
+				if (state_ == breaker_state::closed && count(now, true))
+					trip(now, true);
+			}
+		private:
+			/**
+			* \brief 计入当前窗口
+			* \return 是否达到断开条件
+			*/
+			bool count(int64 now, bool failed)
+			{
+				if (now >= window_end_)
+					reset(now);
+				++requests_;
+				if (failed)
+					++failures_;
+				return error_rate_ > 0 && requests_ >= min_requests_ && failures_ * 100 >= error_rate_ * requests_;
+			}
+
+			/**
+			* \brief 开始新的窗口
+			*/
+			void reset(int64 now)
+			{
+				window_end_ = now + window_;
+				requests_ = 0;
+				failures_ = 0;
+			}
+
+			/**
+			* \brief 断开
+			* \param timed 是否等待断开时间(没有工作者时工作者就绪即可半开)
+			*/
+			void trip(int64 now, bool timed)
+			{
+				state_ = breaker_state::open;
+				open_until_ = timed ? now + open_time_ : now;
+				probing_ = 0;
+			}
+		};
+	}
+}
+#endif //!_ZERO_CIRCUIT_BREAKER_H_
@@ -11,6 +11,7 @@ namespace agebull
 		* \brief 
 		*/
 		plan_dispatcher* plan_dispatcher::instance = nullptr;
+		latency_histogram plan_dispatcher::exec_lag;
 
 		/**
 		* \brief ִ
@@ -24,7 +25,7 @@ namespace agebull
 				set_command_thread_bad(config.station_name_.c_str());
 				return;
 			}
-			if (!station_warehouse::join(station.get()))
+			if (!station_warehouse::join(station))
 			{
 				config.failed("join warehouse");
 				set_command_thread_bad(config.station_name_.c_str());
@@ -99,6 +100,7 @@ namespace agebull
 					arg.emplace_back(list[idx]);
 					break;
 				case ZERO_FRAME_GLOBAL_ID:
+				case ZERO_FRAME_GLOBAL_ID_BIN:
 					glid_index = idx;
 					break;
 				}
@@ -272,7 +274,7 @@ namespace agebull
 				int sec = static_cast<int>((boost::posix_time::second_clock::universal_time() - pre).total_milliseconds());
 				if (sec < 1000)//ִʱ䳬1򲻵ȴ,ִ
 				{
-					thread_sleep(1000 - sec);
+					get_config().wait_state(1000 - sec, [this]() { return !can_do(); });
 				}
 				if (!can_do())
 					break;
@@ -296,14 +298,11 @@ namespace agebull
 			shared_char caller = list[0];
 			list.erase(list.begin());
 
-			shared_char description(16);
-			description.state(ZERO_BYTE_COMMAND_PROXY);
-			shared_char plan_caller(128);
-
 			shared_ptr<plan_message> message = make_shared<plan_message>();
 			message->caller = list[0];
-			message->frames.emplace_back(plan_caller);
-			message->frames.emplace_back(description);
+			message->frames.emplace_back(static_cast<size_t>(128));
+			message->frames.emplace_back(static_cast<size_t>(16));
+			message->frames[1].state(ZERO_BYTE_COMMAND_PROXY);
 
 			size_t plan = 0, rqid = 0, glid = 0, reqer = 0, cmdid = 0;
 			for (size_t idx = 2; idx <= static_cast<size_t>(list[1][0] + 2); idx++)
@@ -324,6 +323,7 @@ namespace agebull
 					reqer = idx;
 					break;
 				case ZERO_FRAME_GLOBAL_ID:
+				case ZERO_FRAME_GLOBAL_ID_BIN:
 					glid = idx;
 					break;
 				case ZERO_FRAME_COMMAND:
@@ -331,39 +331,48 @@ namespace agebull
 					cmdid = idx;
 					break;
 				}
-				description.append_frame(list[1][idx]);
+				message->frames[1].append_frame(list[1][idx]);
 				message->frames.emplace_back(list[idx]);
 			}
 			auto config = station_warehouse::get_config(message->station);
 			if (plan == 0 || !config || message->station.empty() || cmdid == 0)
 			{
-				send_request_status(socket, *caller, ZERO_STATUS_ARG_INVALID_ID, list, glid, rqid, reqer);
+				send_request_status(socket, caller, ZERO_STATUS_ARG_INVALID_ID, list, glid, rqid, reqer);
 				return false;
 			}
 
-			description.append_frame(ZERO_FRAME_PLAN);
+			message->frames[1].append_frame(ZERO_FRAME_PLAN);
 			message->frames.emplace_back("");
 
 			shared_char global_id;
 			if (glid == 0)
 			{
-				global_id.set_int64x(message->plan_id = station_warehouse::get_glogal_id());
-				description.append_frame(ZERO_FRAME_GLOBAL_ID);
+				message->plan_id = station_warehouse::get_glogal_id();
+				if (json_config::binary_global_id)
+				{
+					global_id.set_int64b(message->plan_id);
+					message->frames[1].append_frame(ZERO_FRAME_GLOBAL_ID_BIN);
+				}
+				else
+				{
+					global_id.set_int64x(message->plan_id);
+					message->frames[1].append_frame(ZERO_FRAME_GLOBAL_ID);
+				}
 				message->frames.emplace_back(global_id);
 			}
 			else
 			{
 				global_id = list[glid];
-				message->plan_id = atoll(*list[glid]);
+				message->plan_id = read_global_id(list[glid], list[1][glid]);
 			}
-			sprintf(plan_caller.get_buffer(), "*:msg:%s:%llx", *message->station, message->plan_id); //ƻ()
+			id_codec::make_key(message->frames[0].get_buffer(), "*:msg:", *message->station, static_cast<uint64_t>(message->plan_id)); //ƻ()
 
 			message->station_type = config->station_type_;
 			message->read_plan(*list[plan]);
 
 			if (message->plan_repet == 0 || (message->skip_set > 0 && message->plan_repet > 0 && message->plan_repet <= message->skip_set))
 			{
-				send_request_status(socket, *caller, ZERO_STATUS_ARG_INVALID_ID, list, glid, rqid, reqer);
+				send_request_status(socket, caller, ZERO_STATUS_ARG_INVALID_ID, list, glid, rqid, reqer);
 				return false;
 			}
 			if (message->plan_time <= 0)
@@ -372,7 +381,7 @@ namespace agebull
 			}
 			message->next();
 			plan_message::add_local(message);
-			send_request_status(socket, *caller, ZERO_STATUS_PLAN_ID, list, glid, rqid, reqer);
+			send_request_status(socket, caller, ZERO_STATUS_PLAN_ID, list, glid, rqid, reqer);
 			return true;
 		}
 
@@ -385,6 +394,8 @@ namespace agebull
 				return;
 			message->plan_state = plan_message_state::execute;
 			message->exec_time = time(nullptr);
+			if (message->plan_time > 0)
+				exec_lag.record((message->exec_time - message->plan_time) * 1000000LL);
 			auto ptr = sockets_.find(*message->station);
 			shared_ptr<inner_socket> socket;
 			if (ptr == sockets_.end())
@@ -533,7 +544,7 @@ namespace agebull
 			{
 				if (result[0][idx] == ZERO_FRAME_END)
 					break;
-				description.append_frame(result[0][idx]);
+				datas[1].append_frame(result[0][idx]);
 				datas.emplace_back(result[idx - 1]);
 			}
 			return send_response(datas);
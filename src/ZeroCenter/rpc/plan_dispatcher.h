@@ -23,6 +23,11 @@ namespace agebull
 			*/
 			static plan_dispatcher* instance;
 
+			/**
+			* \brief ƻִͺ(ʵִʱƻʱ֮,΢)
+			*/
+			static latency_histogram exec_lag;
+
 			/**
 			* \brief 
 			*/
@@ -0,0 +1,273 @@
+#pragma once
+#ifndef _ZERO_PUBLISH_BATCH_H_
+#define _ZERO_PUBLISH_BATCH_H_
+#include "../stdinc.h"
+#include "../ext/shared_char.h"
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		* \brief 广播合批:同一主题在停留时间内的多条消息合并为一帧发送
+		* \remark
+		* 合批消息在独立的端口(zero_config::batch_port_)发送,帧结构为 [主题][说明帧(ZERO_FRAME_BATCH)][记录集],
+		* 记录集由多条记录顺序拼接,每条记录为 uint16 帧数量 + 若干(uint32 长度 + 内容),
+		* 帧为原消息主题之后的全部帧(说明帧在前),整数为小端.
+		* 原端口与合批端口的订阅分别记录:只有合批端口有匹配的订阅时才合批,
+		* 原端口的订阅者(包括订阅全部主题的)始终只收到原格式.
+		* 本身不加锁,只由站点的轮询线程访问.
+		*/
+		class publish_batch
+		{
+			/**
+			* \brief 一个主题的合批缓冲
+			*/
+			struct batch_buffer
+			{
+				/**
+				* \brief 第一条记录的写入时间(微秒)
+				*/
+				int64 first_time;
+				/**
+				* \brief 记录数量
+				*/
+				size_t count;
+				/**
+				* \brief 记录集
+				*/
+				string data;
+
+				/**
+				* \brief 构造
+				*/
+				batch_buffer()
+					: first_time(0)
+					, count(0)
+				{
+				}
+			};
+			/**
+			* \brief 停留时间(微秒)
+			*/
+			int64 linger_;
+			/**
+			* \brief 记录数量阈值(0 只按停留时间)
+			*/
+			size_t size_;
+			/**
+			* \brief 合批缓冲(主题 => 缓冲)
+			*/
+			map<string, batch_buffer> buffers_;
+			/**
+			* \brief 原端口当前的订阅前缀(XPUB上报)
+			*/
+			set<string> legacy_subscribes_;
+			/**
+			* \brief 合批端口当前的订阅前缀(XPUB上报)
+			*/
+			set<string> batch_subscribes_;
+		public:
+			/**
+			* \brief 构造
+			*/
+			publish_batch()
+				: linger_(0)
+				, size_(0)
+			{
+			}
+
+			/**
+			* \brief 设置停留时间与数量阈值,返回是否启用
+			*/
+			bool set_limit(int linger, int size)
+			{
+				linger_ = linger > 0 ? linger : 0;
+				size_ = size > 0 ? static_cast<size_t>(size) : 0;
+				buffers_.clear();
+				legacy_subscribes_.clear();
+				batch_subscribes_.clear();
+				return enable();
+			}
+
+			/**
+			* \brief 是否启用
+			*/
+			bool enable() const
+			{
+				return linger_ > 0;
+			}
+
+			/**
+			* \brief 是否有未发送的记录
+			*/
+			bool empty() const
+			{
+				return buffers_.empty();
+			}
+
+			/**
+			* \brief 轮询超时(毫秒):有待发送记录时按停留时间计算
+			*/
+			int poll_timeout(int def) const
+			{
+				if (buffers_.empty())
+					return def;
+				const int ms = static_cast<int>(linger_ / 1000);
+				return ms < 1 ? 1 : (ms > def ? def : ms);
+			}
+
+			/**
+			* \brief 订阅或退订(XPUB上报)
+			* \param batch 是否为合批端口的订阅
+			*/
+			void subscribe(const char* topic, size_t len, bool sub, bool batch)
+			{
+				set<string>& subscribes = batch ? batch_subscribes_ : legacy_subscribes_;
+				if (sub)
+					subscribes.insert(string(topic, len));
+				else
+					subscribes.erase(string(topic, len));
+			}
+
+			/**
+			* \brief 是否有原格式的订阅者
+			*/
+			bool legacy_wanted(const shared_char& title) const
+			{
+				return matched(legacy_subscribes_, title);
+			}
+
+			/**
+			* \brief 是否有合批格式的订阅者
+			*/
+			bool batch_wanted(const shared_char& title) const
+			{
+				return matched(batch_subscribes_, title);
+			}
+
+			/**
+			* \brief 写入一条记录
+			* \param datas 广播帧
+			* \param first_index 主题帧的下标
+			* \param now 当前时间(微秒)
+			* \return 该主题是否已达到数量阈值
+			*/
+			bool push(const vector<shared_char>& datas, size_t first_index, int64 now)
+			{
+				if (first_index >= datas.size())
+					return false;
+				const shared_char& title = datas[first_index];
+				batch_buffer& buffer = buffers_[string(*title, title.size())];
+				if (buffer.count == 0)
+				{
+					buffer.first_time = now;
+					buffer.data.clear();
+				}
+				append_record(buffer.data, datas, first_index + 1);
+				++buffer.count;
+				return size_ > 0 && buffer.count >= size_;
+			}
+
+			/**
+			* \brief 发送到期(或全部)的合批
+			* \param now 当前时间(微秒)
+			* \param all 是否忽略停留时间全部发送
+			* \param func 发送方法,参数为合批消息的帧
+			* \return 发送的合批数量
+			*/
+			template<class TFunc>
+			size_t flush(int64 now, bool all, TFunc func)
+			{
+				size_t cnt = 0;
+				for (auto iter = buffers_.begin(); iter != buffers_.end();)
+				{
+					if (!all && now - iter->second.first_time < linger_)
+					{
+						++iter;
+						continue;
+					}
+					send(iter->first, iter->second, func);
+					iter = buffers_.erase(iter);
+					++cnt;
+				}
+				return cnt;
+			}
+
+			/**
+			* \brief 发送一个主题的合批
+			*/
+			template<class TFunc>
+			void flush(const shared_char& title, TFunc func)
+			{
+				auto iter = buffers_.find(string(*title, title.size()));
+				if (iter == buffers_.end())
+					return;
+				send(iter->first, iter->second, func);
+				buffers_.erase(iter);
+			}
+
+			/**
+			* \brief 写入一条记录:uint16 帧数量 + 若干(uint32 长度 + 内容)
+			* \param data 记录集
+			* \param datas 帧
+			* \param first_index 记录的第一帧
+			*/
+			static void append_record(string& data, const vector<shared_char>& datas, size_t first_index)
+			{
+				append(data, static_cast<uint16_t>(datas.size() - first_index));
+				for (size_t idx = first_index; idx < datas.size(); idx++)
+				{
+					append(data, static_cast<uint32_t>(datas[idx].size()));
+					data.append(*datas[idx], datas[idx].size());
+				}
+			}
+		private:
+			/**
+			* \brief 主题是否匹配某个订阅前缀
+			*/
+			static bool matched(const set<string>& subscribes, const shared_char& title)
+			{
+				for (auto& sub : subscribes)
+				{
+					if (sub.length() <= title.size() && memcmp(sub.c_str(), *title, sub.length()) == 0)
+						return true;
+				}
+				return false;
+			}
+
+			/**
+			* \brief 组装并发送合批消息
+			*/
+			template<class TFunc>
+			static void send(const string& title, batch_buffer& buffer, TFunc func)
+			{
+				vector<shared_char> frames;
+				frames.reserve(3);
+				shared_char topic(title.length());
+				memcpy(topic.get_buffer(), title.c_str(), title.length());
+				frames.emplace_back(topic);
+				shared_char description;
+				description.alloc_frame_1(ZERO_BYTE_COMMAND_NONE, ZERO_FRAME_BATCH);
+				frames.emplace_back(description);
+				shared_char data(buffer.data.length());
+				memcpy(data.get_buffer(), buffer.data.c_str(), buffer.data.length());
+				frames.emplace_back(data);
+				func(frames);
+			}
+
+			/**
+			* \brief 写入小端整数
+			*/
+			template<class TInt>
+			static void append(string& data, TInt value)
+			{
+				char buf[sizeof(TInt)];
+				for (size_t i = 0; i < sizeof(TInt); i++)
+					buf[i] = static_cast<char>((value >> (i * 8)) & 0xFF);
+				data.append(buf, sizeof(TInt));
+			}
+		};
+	}
+}
+#endif //!_ZERO_PUBLISH_BATCH_H_
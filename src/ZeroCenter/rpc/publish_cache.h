@@ -0,0 +1,378 @@
+#pragma once
+#ifndef _ZERO_PUBLISH_CACHE_H_
+#define _ZERO_PUBLISH_CACHE_H_
+#include "../stdinc.h"
+#include "../ext/shared_char.h"
+#include <deque>
+#include <list>
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		* \brief 广播缓存:每个主题的最后值与有界的重放环
+		* \remark
+		* 新订阅触发的最后值重发会发给全部订阅者,同一订阅前缀在重发间隔内只重发一次,
+		* 间隔内再有订阅时延到间隔结束后合并重发,重连风暴时不至于每个连接都重发整个缓存.
+		* 本身不加锁,只由站点的轮询线程访问
+		*/
+		class publish_cache
+		{
+			/**
+			* \brief 缓存的一条广播(帧为深拷贝,与发布线程的缓冲区无关)
+			*/
+			struct cache_item
+			{
+				/**
+				* \brief 写入序号
+				*/
+				int64 seq;
+				/**
+				* \brief 占用字节数
+				*/
+				size_t bytes;
+				/**
+				* \brief 广播帧(第一帧为主题)
+				*/
+				vector<shared_char> frames;
+			};
+			/**
+			* \brief 最后值的主题数量上限
+			*/
+			size_t max_topics_;
+			/**
+			* \brief 重放环的消息数量上限
+			*/
+			size_t max_replay_;
+			/**
+			* \brief 总字节数上限(0 不限制)
+			*/
+			size_t max_bytes_;
+			/**
+			* \brief 当前字节数
+			*/
+			size_t bytes_;
+			/**
+			* \brief 写入序号
+			*/
+			int64 seq_;
+			/**
+			* \brief 最后值(主题[+副题],消息),按更新顺序排列,最久未更新的在前
+			*/
+			std::list<std::pair<string, cache_item>> lru_;
+			/**
+			* \brief 最后值的索引(主题[+副题] => lru_中的位置)
+			*/
+			boost::unordered_map<string, std::list<std::pair<string, cache_item>>::iterator> last_values_;
+			/**
+			* \brief 重放环
+			*/
+			std::deque<cache_item> replay_;
+			/**
+			* \brief 同一订阅前缀的最小重发间隔(微秒,0 不限制)
+			*/
+			int64 republish_ivl_;
+			/**
+			* \brief 各订阅前缀最后重发的时间(微秒)
+			*/
+			boost::unordered_map<string, int64> republish_times_;
+			/**
+			* \brief 间隔内等待合并重发的订阅前缀
+			*/
+			set<string> republish_pending_;
+		public:
+			/**
+			* \brief 构造
+			*/
+			publish_cache()
+				: max_topics_(0)
+				, max_replay_(0)
+				, max_bytes_(0)
+				, bytes_(0)
+				, seq_(0)
+				, republish_ivl_(0)
+			{
+			}
+
+			/**
+			* \brief 设置同一订阅前缀的最小重发间隔(毫秒,小于等于0不限制)
+			*/
+			void set_republish_interval(int ms)
+			{
+				republish_ivl_ = ms > 0 ? static_cast<int64>(ms) * 1000 : 0;
+			}
+
+			/**
+			* \brief 设置容量(小于等于0表示不启用),返回是否启用
+			*/
+			bool set_limit(int topics, int replay, int bytes)
+			{
+				max_topics_ = topics > 0 ? static_cast<size_t>(topics) : 0;
+				max_replay_ = replay > 0 ? static_cast<size_t>(replay) : 0;
+				max_bytes_ = bytes > 0 ? static_cast<size_t>(bytes) : 0;
+				clear();
+				return enable();
+			}
+
+			/**
+			* \brief 是否启用
+			*/
+			bool enable() const
+			{
+				return max_topics_ > 0 || max_replay_ > 0;
+			}
+
+			/**
+			* \brief 缓存的主题数量
+			*/
+			size_t topics() const
+			{
+				return last_values_.size();
+			}
+
+			/**
+			* \brief 重放环中的消息数量
+			*/
+			size_t replays() const
+			{
+				return replay_.size();
+			}
+
+			/**
+			* \brief 当前字节数
+			*/
+			size_t bytes() const
+			{
+				return bytes_;
+			}
+
+			/**
+			* \brief 清空
+			*/
+			void clear()
+			{
+				last_values_.clear();
+				lru_.clear();
+				replay_.clear();
+				bytes_ = 0;
+				republish_times_.clear();
+				republish_pending_.clear();
+			}
+
+			/**
+			* \brief 新订阅时能否立即重发最后值,不能时登记为延后重发
+			* \param prefix 订阅前缀
+			* \param len 前缀长度
+			* \param now 当前时间(微秒)
+			*/
+			bool republish_due(const char* prefix, size_t len, int64 now)
+			{
+				if (republish_ivl_ <= 0)
+					return true;
+				string key(prefix, len);
+				auto iter = republish_times_.find(key);
+				if (iter != republish_times_.end() && now - iter->second < republish_ivl_)
+				{
+					republish_pending_.insert(std::move(key));
+					return false;
+				}
+				//前缀数量由订阅者决定,过多时清掉已过间隔的记录
+				if (republish_times_.size() >= 1024)
+				{
+					for (auto it = republish_times_.begin(); it != republish_times_.end();)
+					{
+						if (now - it->second >= republish_ivl_ && republish_pending_.count(it->first) == 0)
+							it = republish_times_.erase(it);
+						else
+							++it;
+					}
+				}
+				republish_times_[key] = now;
+				return true;
+			}
+
+			/**
+			* \brief 重发间隔已到的延后订阅前缀
+			* \param now 当前时间(微秒)
+			* \param func 重发方法,参数为订阅前缀
+			*/
+			template<class TFunc>
+			void flush_republish(int64 now, TFunc func)
+			{
+				for (auto iter = republish_pending_.begin(); iter != republish_pending_.end();)
+				{
+					int64& last = republish_times_[*iter];
+					if (now - last < republish_ivl_)
+					{
+						++iter;
+						continue;
+					}
+					last = now;
+					func(*iter);
+					iter = republish_pending_.erase(iter);
+				}
+			}
+
+			/**
+			* \brief 有延后重发时的轮询超时(毫秒)
+			*/
+			int poll_timeout(int def) const
+			{
+				if (republish_pending_.empty())
+					return def;
+				const int ms = static_cast<int>(republish_ivl_ / 1000);
+				return ms < 1 ? 1 : (ms > def ? def : ms);
+			}
+
+			/**
+			* \brief 写入一条广播
+			* \param datas 广播帧
+			* \param first_index 主题帧的下标,其后一帧为说明帧
+			*/
+			void push(const vector<shared_char>& datas, size_t first_index)
+			{
+				if (!enable() || first_index + 1 >= datas.size())
+					return;
+				cache_item item;
+				item.seq = ++seq_;
+				item.bytes = 0;
+				item.frames.reserve(datas.size() - first_index);
+				for (size_t idx = first_index; idx < datas.size(); idx++)
+				{
+					item.bytes += datas[idx].size();
+					item.frames.emplace_back(clone(datas[idx]));
+				}
+				if (max_replay_ > 0)
+				{
+					while (replay_.size() >= max_replay_)
+						pop_replay();
+					bytes_ += item.bytes;
+					replay_.emplace_back(item);
+				}
+				if (max_topics_ > 0)
+				{
+					string key = topic_key(item.frames);
+					auto iter = last_values_.find(key);
+					if (iter != last_values_.end())
+					{
+						//更新后移到队尾,淘汰与遍历都不必再按序号查找
+						auto& node = iter->second;
+						bytes_ -= node->second.bytes;
+						bytes_ += item.bytes;
+						node->second = std::move(item);
+						lru_.splice(lru_.end(), lru_, node);
+					}
+					else
+					{
+						if (last_values_.size() >= max_topics_)
+							pop_last_value();
+						bytes_ += item.bytes;
+						lru_.emplace_back(key, std::move(item));
+						last_values_.emplace(std::move(key), std::prev(lru_.end()));
+					}
+				}
+				while (max_bytes_ > 0 && bytes_ > max_bytes_ && (!replay_.empty() || !last_values_.empty()))
+				{
+					if (!replay_.empty())
+						pop_replay();
+					else
+						pop_last_value();
+				}
+			}
+
+			/**
+			* \brief 按写入顺序遍历与主题前缀匹配的缓存
+			* \param prefix 主题前缀(与ZMQ订阅规则一致,空表示全部)
+			* \param len 前缀长度
+			* \param replay true 遍历重放环 false 遍历最后值
+			* \param func 处理方法
+			*/
+			template<class TFunc>
+			size_t foreach(const char* prefix, size_t len, bool replay, TFunc func) const
+			{
+				size_t cnt = 0;
+				if (replay)
+				{
+					for (auto& item : replay_)
+					{
+						if (!match(item.frames[0], prefix, len))
+							continue;
+						func(item.frames);
+						++cnt;
+					}
+					return cnt;
+				}
+				//lru_已按更新顺序排列
+				for (auto& kv : lru_)
+				{
+					if (!match(kv.second.frames[0], prefix, len))
+						continue;
+					func(kv.second.frames);
+					++cnt;
+				}
+				return cnt;
+			}
+		private:
+			/**
+			* \brief 移除最早的重放消息
+			*/
+			void pop_replay()
+			{
+				bytes_ -= replay_.front().bytes;
+				replay_.pop_front();
+			}
+
+			/**
+			* \brief 移除最久未更新的主题
+			*/
+			void pop_last_value()
+			{
+				auto& oldest = lru_.front();
+				bytes_ -= oldest.second.bytes;
+				last_values_.erase(oldest.first);
+				lru_.pop_front();
+			}
+
+			/**
+			* \brief 主题前缀匹配
+			*/
+			static bool match(const shared_char& title, const char* prefix, size_t len)
+			{
+				return len == 0 || (title.size() >= len && memcmp(*title, prefix, len) == 0);
+			}
+
+			/**
+			* \brief 最后值的键:主题,如有副题则为 主题\n副题
+			*/
+			static string topic_key(const vector<shared_char>& frames)
+			{
+				string key(*frames[0], frames[0].size());
+				const shared_char& description = frames[1];
+				const size_t size = description.frame_size();
+				for (size_t idx = 2; idx < size + 2 && idx < frames.size(); idx++)
+				{
+					if (description[idx] != ZERO_FRAME_SUBTITLE)
+						continue;
+					key.append(1, '\n');
+					key.append(*frames[idx], frames[idx].size());
+					break;
+				}
+				return key;
+			}
+
+			/**
+			* \brief 深拷贝一帧
+			*/
+			static shared_char clone(const shared_char& src)
+			{
+				if (src.empty())
+					return shared_char();
+				shared_char dest(src.size());
+				memcpy(dest.get_buffer(), *src, src.size());
+				return dest;
+			}
+		};
+	}
+}
+#endif //!_ZERO_PUBLISH_CACHE_H_
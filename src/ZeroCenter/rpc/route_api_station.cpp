@@ -1,6 +1,7 @@
 #include "../stdafx.h"
 #include "route_api_station.h"
 #include "inner_socket.h"
+#include "station_reactor.h"
 
 namespace agebull
 {
@@ -18,14 +19,32 @@ namespace agebull
 				set_command_thread_bad(config.station_name_.c_str());
 				return;
 			}
-			if (!station_warehouse::join(station.get()))
+			if (!station_warehouse::join(station))
 			{
 				config.failed("join warehouse");
 				set_command_thread_bad(config.station_name_.c_str());
 				return;
 			}
 			station->task_semaphore_.post();
+			//低流量站点交给共享的反应器线程轮询,本线程结束
+			if (config.is_use_reactor())
+			{
+				station_reactor::attach(station, [station]()
+				{
+					finish(station);
+				});
+				return;
+			}
 			station->poll();
+			finish(station);
+		}
+
+		/**
+		* \brief 轮询结束后的清理与重启
+		*/
+		void route_api_station::finish(const shared_ptr<route_api_station>& station)
+		{
+			zero_config& config = station->get_config();
 			station_warehouse::left(station.get());
 			station->destruct();
 			if (!config.is_state(station_state::Stop) && get_net_state() == NET_STATE_RUNING)
@@ -64,13 +83,14 @@ namespace agebull
 					reqid = i;
 					break;
 				case ZERO_FRAME_GLOBAL_ID:
+				case ZERO_FRAME_GLOBAL_ID_BIN:
 					glid_index = i;
 					break;
 				}
 			}
 			if (glid_index == 0)
 			{
-				send_request_status(socket, *caller, ZERO_STATUS_FRAME_INVALID_ID, list, 0, reqid, reqer);
+				send_request_status(socket, caller, ZERO_STATUS_FRAME_INVALID_ID, list, 0, reqid, reqer);
 				return;
 			}
 			switch (description[1])
@@ -85,7 +105,7 @@ namespace agebull
 				//	send_request_result(iter->second);
 				//}
 				//else
-				send_request_status(socket, *caller, ZERO_STATUS_NOT_WORKER_ID, list, glid_index, reqid, reqer);
+				send_request_status(socket, caller, ZERO_STATUS_NOT_WORKER_ID, list, glid_index, reqid, reqer);
 			}break;
 			case ZERO_BYTE_COMMAND_CLOSE_REQUEST:
 			{
@@ -93,17 +113,32 @@ namespace agebull
 				const auto iter = results.find(atoll(*list[glid_index]));
 				if (iter != results.end())
 					results.erase(iter);*/
-				send_request_status(socket, *caller, ZERO_STATUS_OK_ID, list, glid_index, reqid, reqer);
+				send_request_status(socket, caller, ZERO_STATUS_OK_ID, list, glid_index, reqid, reqer);
 			}break;
 			default:
+				//单个调用者超过配额时拒绝,不占用其他调用者的容量
+				if (!take_quota(caller, list, reqer))
+				{
+					send_request_status(socket, caller, ZERO_STATUS_QUOTA_ID, list, glid_index, reqid, reqer);
+					break;
+				}
+				//工作者已饱和时立即拒绝,不再堆进工作者的队列
+				if (!admit())
+				{
+					send_request_status(socket, caller, ZERO_STATUS_OVERLOAD_ID, list, glid_index, reqid, reqer);
+					break;
+				}
 				socket_ex::send_addr(socket, *list[worker]);
 				if (!send_response(list))
 				{
-					send_request_status(socket, *caller, ZERO_STATUS_NOT_WORKER_ID, list, glid_index, reqid, reqer);
+					breaker_result(true);
+					send_request_status(socket, caller, ZERO_STATUS_NOT_WORKER_ID, list, glid_index, reqid, reqer);
+					break;
 				}
-				else if (description[1] == ZERO_BYTE_COMMAND_PROXY)//必须返回信息到代理
+				trace_dispatch(list, glid_index);
+				if (description[1] == ZERO_BYTE_COMMAND_PROXY)//必须返回信息到代理
 				{
-					send_request_status(socket, *caller, ZERO_STATUS_RUNING_ID, list, glid_index, reqid, reqer);
+					send_request_status(socket, caller, ZERO_STATUS_RUNING_ID, list, glid_index, reqid, reqer);
 				}
 				break;
 			}
@@ -54,6 +54,10 @@ namespace agebull
 			* \brief 执行
 			*/
 			static void launch(shared_ptr<route_api_station>& station);
+			/**
+			* \brief 轮询结束后的清理与重启
+			*/
+			static void finish(const shared_ptr<route_api_station>& station);
 		private:
 			/**
 			* \brief 工作开始（发送到工作者）
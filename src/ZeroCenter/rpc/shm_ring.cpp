@@ -0,0 +1,217 @@
+/**
+ * 共享内存传输(中心一侧)
+ */
+#include "../stdafx.h"
+#include "shm_ring.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <grp.h>
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		* \brief 设置段或唤醒管道的权限:默认只允许本用户,配置了组时允许同组读写
+		*/
+		static void set_access(int fd, const char* path, const char* station)
+		{
+			mode_t mode = 0600;
+			gid_t gid = static_cast<gid_t>(-1);
+			if (json_config::shm_group[0] != 0)
+			{
+				struct group* grp = getgrnam(json_config::shm_group);
+				if (grp == nullptr)
+				{
+					log_error2("[%s] : shm > group %s not found", station, json_config::shm_group);
+				}
+				else
+				{
+					gid = grp->gr_gid;
+					mode = 0660;
+				}
+			}
+			int state = 0;
+			if (gid != static_cast<gid_t>(-1))
+				state = fd >= 0 ? fchown(fd, static_cast<uid_t>(-1), gid) : chown(path, static_cast<uid_t>(-1), gid);
+			//显式设置,不受umask影响
+			if (state == 0)
+				state = fd >= 0 ? fchmod(fd, mode) : chmod(path, mode);
+			if (state != 0)
+				log_error3("[%s] : shm > set access of %s failed(%d)", station, path, errno);
+		}
+
+		/**
+		* \brief 创建段与唤醒管道
+		*/
+		bool shm_segment::create(const char* station, uint64_t ring_size)
+		{
+			destroy();
+			detached_ = false;
+			station_ = station;
+			uint64_t size = 4096;
+			while (size < ring_size)
+				size <<= 1;
+			const uint64_t ring_memory = shm_ring::memory_size(size);
+			memory_size_ = static_cast<size_t>(sizeof(shm_segment_header) + ring_memory * 2);
+
+			char name[MAX_PATH];
+			sprintf(name, "/zero_%s", station);
+			shm_unlink(name);
+			const int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+			if (fd < 0)
+			{
+				log_error3("[%s] : shm > open %s failed(%d)", station, name, errno);
+				return false;
+			}
+			set_access(fd, name, station);
+			if (ftruncate(fd, static_cast<off_t>(memory_size_)) < 0)
+			{
+				log_error3("[%s] : shm > truncate %s failed(%d)", station, name, errno);
+				close(fd);
+				shm_unlink(name);
+				return false;
+			}
+			void* memory = mmap(nullptr, memory_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			close(fd);
+			if (memory == MAP_FAILED)
+			{
+				log_error3("[%s] : shm > map %s failed(%d)", station, name, errno);
+				shm_unlink(name);
+				return false;
+			}
+			memory_ = static_cast<char*>(memory);
+			memset(memory_, 0, sizeof(shm_segment_header));
+			header_ = static_cast<shm_segment_header*>(memory);
+			header_->ring_size = size;
+			header_->center_pid = getpid();
+			header_->worker_pid.store(0);
+			strncpy(header_->station, station, sizeof(header_->station) - 1);
+			out_.attach(memory_ + sizeof(shm_segment_header), size);
+			in_.attach(memory_ + sizeof(shm_segment_header) + ring_memory, size);
+			out_.reset();
+			in_.reset();
+
+			acl::string dir;
+			dir.format("%sipc", json_config::root_path.c_str());
+			mkdir(dir.c_str(), 00777);
+			acl::string bell;
+			bell.format("%s/%s_in.bell", dir.c_str(), station);
+			unlink(bell.c_str());
+			mkfifo(bell.c_str(), 0600);
+			set_access(-1, bell.c_str(), station);
+			//读写方式打开,不会因对端未打开而阻塞,也不会因对端关闭而持续可读
+			in_bell_ = open(bell.c_str(), O_RDWR | O_NONBLOCK);
+			bell.format("%s/%s_out.bell", dir.c_str(), station);
+			unlink(bell.c_str());
+			mkfifo(bell.c_str(), 0600);
+			set_access(-1, bell.c_str(), station);
+			out_bell_ = open(bell.c_str(), O_RDWR | O_NONBLOCK);
+			if (in_bell_ < 0 || out_bell_ < 0)
+			{
+				log_error2("[%s] : shm > open bell failed(%d)", station, errno);
+				destroy();
+				return false;
+			}
+			//所有字段写完后才对工作者可见
+			std::atomic_thread_fence(std::memory_order_release);
+			header_->version = ZERO_SHM_VERSION;
+			header_->magic = ZERO_SHM_MAGIC;
+			log_msg3("[%s] : shm > %s (%llu bytes per ring)", station, name, static_cast<unsigned long long>(size));
+			return true;
+		}
+
+		/**
+		* \brief 释放并删除段与唤醒管道
+		*/
+		void shm_segment::destroy()
+		{
+			if (in_bell_ >= 0)
+			{
+				close(in_bell_);
+				in_bell_ = -1;
+			}
+			if (out_bell_ >= 0)
+			{
+				close(out_bell_);
+				out_bell_ = -1;
+			}
+			if (memory_ == nullptr)
+				return;
+			header_->magic = 0;
+			munmap(memory_, memory_size_);
+			memory_ = nullptr;
+			header_ = nullptr;
+			char name[MAX_PATH];
+			sprintf(name, "/zero_%s", station_.c_str());
+			shm_unlink(name);
+			acl::string bell;
+			bell.format("%sipc/%s_in.bell", json_config::root_path.c_str(), station_.c_str());
+			unlink(bell.c_str());
+			bell.format("%sipc/%s_out.bell", json_config::root_path.c_str(), station_.c_str());
+			unlink(bell.c_str());
+		}
+
+		/**
+		* \brief 检查工作者进程是否仍存活,已退出则清空环以便重新连接
+		*/
+		void shm_segment::check_peer()
+		{
+			if (header_ == nullptr)
+				return;
+			const int32_t pid = header_->worker_pid.load();
+			if (pid == 0 || kill(pid, 0) == 0 || errno != ESRCH)
+				return;
+			log_msg2("[%s] : shm > worker %d left", station_.c_str(), pid);
+			out_.reset();
+			in_.reset();
+			header_->worker_pid.store(0);
+		}
+
+		/**
+		* \brief 环损坏时停用共享内存,断开工作者,此后只走TCP
+		*/
+		void shm_segment::detach()
+		{
+			if (header_ == nullptr || detached_)
+				return;
+			log_error2("[%s] : shm > ring corrupt, worker %d detached, fall back to tcp", station_.c_str(), header_->worker_pid.load());
+			detached_ = true;
+			//清除标识,工作者不能再连接
+			header_->magic = 0;
+			header_->worker_pid.store(0);
+			out_.reset();
+			in_.reset();
+		}
+
+		/**
+		* \brief 发送到工作者(出环),工作者休眠时唤醒
+		*/
+		bool shm_segment::send(const vector<shared_char>& datas, size_t first_index)
+		{
+			if (!attached() || !out_.push(datas, first_index))
+				return false;
+			if (out_.is_parked())
+			{
+				const char bell = 1;
+				//管道已满说明唤醒已在途,忽略
+				if (write(out_bell_, &bell, 1) < 0 && errno != EAGAIN)
+					log_error2("[%s] : shm > ring bell failed(%d)", station_.c_str(), errno);
+			}
+			return true;
+		}
+
+		/**
+		* \brief 读空入环的唤醒管道
+		*/
+		void shm_segment::drain_bell() const
+		{
+			char buf[64];
+			while (read(in_bell_, buf, sizeof(buf)) > 0)
+			{
+			}
+		}
+	}
+}
@@ -0,0 +1,442 @@
+#pragma once
+#ifndef _ZERO_SHM_RING_H_
+#define _ZERO_SHM_RING_H_
+#include "../stdinc.h"
+#include "../ext/shared_char.h"
+#include <atomic>
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		* \brief 共享内存段的标识("ZSHM")
+		*/
+#define ZERO_SHM_MAGIC 0x5A53484DU
+		/**
+		* \brief 共享内存段的版本
+		*/
+#define ZERO_SHM_VERSION 1U
+		/**
+		* \brief 环中的回绕填充标记
+		*/
+#define ZERO_SHM_PAD 0xFFFFFFFFU
+
+		/**
+		* \brief 共享内存段头
+		* \remark
+		* 段文件为 /dev/shm/zero_<站点>,布局为 [段头][出环头][出环数据][入环头][入环数据],
+		* 出环由中心写入、工作者读取,入环由工作者写入、中心读取.
+		* 唤醒使用同目录下的命名管道 zero_<站点>_out.bell / zero_<站点>_in.bell,
+		* 只有消费方声明已休眠(parked)时生产方才写入一个字节.
+		*/
+		struct shm_segment_header
+		{
+			/**
+			* \brief 标识
+			*/
+			uint32_t magic;
+			/**
+			* \brief 版本
+			*/
+			uint32_t version;
+			/**
+			* \brief 每个环的数据容量(2的幂)
+			*/
+			uint64_t ring_size;
+			/**
+			* \brief 中心的进程号
+			*/
+			int32_t center_pid;
+			/**
+			* \brief 已连接的工作者进程号(0 表示未连接,工作者以CAS抢占)
+			*/
+			std::atomic<int32_t> worker_pid;
+			/**
+			* \brief 站点名称
+			*/
+			char station[64];
+		};
+
+		/**
+		* \brief 单生产者单消费者环的头(读写位置分处不同的缓存行)
+		*/
+		struct shm_ring_header
+		{
+			/**
+			* \brief 写入位置(只增)
+			*/
+			alignas(64) std::atomic<uint64_t> head;
+			/**
+			* \brief 读取位置(只增)
+			*/
+			alignas(64) std::atomic<uint64_t> tail;
+			/**
+			* \brief 消费方是否已休眠等待唤醒
+			*/
+			alignas(64) std::atomic<uint32_t> parked;
+		};
+
+		/**
+		* \brief 共享内存中的单生产者单消费者环
+		* \remark
+		* 每条记录为 uint32 长度 + 内容,按8字节对齐;内容与 socket_ex::send 的帧序列一致:
+		* uint32 帧数量 + 若干(uint32 长度 + 帧内容).尾部放不下时写入填充标记并回绕到开头.
+		*/
+		class shm_ring
+		{
+			/**
+			* \brief 环头
+			*/
+			shm_ring_header* header_;
+			/**
+			* \brief 数据区
+			*/
+			char* data_;
+			/**
+			* \brief 容量
+			*/
+			uint64_t size_;
+		public:
+			/**
+			* \brief 构造
+			*/
+			shm_ring()
+				: header_(nullptr)
+				, data_(nullptr)
+				, size_(0)
+			{
+			}
+
+			/**
+			* \brief 绑定到共享内存
+			*/
+			void attach(void* memory, uint64_t size)
+			{
+				header_ = static_cast<shm_ring_header*>(memory);
+				data_ = static_cast<char*>(memory) + sizeof(shm_ring_header);
+				size_ = size;
+			}
+
+			/**
+			* \brief 初始化(仅创建方在无人连接时调用)
+			*/
+			void reset() const
+			{
+				header_->head.store(0);
+				header_->tail.store(0);
+				header_->parked.store(0);
+			}
+
+			/**
+			* \brief 是否为空
+			*/
+			bool empty() const
+			{
+				return header_->tail.load(std::memory_order_relaxed) == header_->head.load(std::memory_order_acquire);
+			}
+
+			/**
+			* \brief 消费方声明休眠,返回false表示环中已有数据,不应休眠
+			*/
+			bool park() const
+			{
+				header_->parked.store(1);
+				return header_->tail.load(std::memory_order_relaxed) == header_->head.load();
+			}
+
+			/**
+			* \brief 消费方结束休眠
+			*/
+			void unpark() const
+			{
+				header_->parked.store(0, std::memory_order_relaxed);
+			}
+
+			/**
+			* \brief 消费方是否在休眠(生产方写入后检查,决定是否唤醒)
+			*/
+			bool is_parked() const
+			{
+				return header_->parked.load() != 0;
+			}
+
+			/**
+			* \brief 写入一条消息
+			* \return 空间不足时返回false
+			*/
+			bool push(const vector<shared_char>& frames, size_t first_index = 0) const
+			{
+				if (first_index >= frames.size())
+					return false;
+				uint64_t payload = sizeof(uint32_t);
+				for (size_t idx = first_index; idx < frames.size(); idx++)
+					payload += sizeof(uint32_t) + frames[idx].size();
+				const uint64_t need = align(sizeof(uint32_t) + payload);
+				if (need > size_ / 2)
+					return false;
+				uint64_t head = header_->head.load(std::memory_order_relaxed);
+				const uint64_t tail = header_->tail.load(std::memory_order_acquire);
+				uint64_t offset = head & (size_ - 1);
+				const uint64_t contiguous = size_ - offset;
+				const uint64_t pad = contiguous < need ? contiguous : 0;
+				if (size_ - (head - tail) < need + pad)
+					return false;
+				if (pad > 0)
+				{
+					write_u32(data_ + offset, ZERO_SHM_PAD);
+					head += pad;
+					offset = 0;
+				}
+				char* ptr = data_ + offset;
+				write_u32(ptr, static_cast<uint32_t>(payload));
+				ptr += sizeof(uint32_t);
+				write_u32(ptr, static_cast<uint32_t>(frames.size() - first_index));
+				ptr += sizeof(uint32_t);
+				for (size_t idx = first_index; idx < frames.size(); idx++)
+				{
+					const uint32_t len = static_cast<uint32_t>(frames[idx].size());
+					write_u32(ptr, len);
+					ptr += sizeof(uint32_t);
+					if (len > 0)
+						memcpy(ptr, *frames[idx], len);
+					ptr += len;
+				}
+				header_->head.store(head + need);
+				return true;
+			}
+
+			/**
+			* \brief 读取一条消息(覆盖frames,与socket_ex::recv一致复用其中的存储)
+			* \param frames 消息帧
+			* \param corrupt 记录的长度或位置越界(对端写坏了环)时置为true,此时不读取也不移动读位置
+			* \return 环为空或记录损坏时返回false
+			*/
+			bool pop(vector<shared_char>& frames, bool& corrupt) const
+			{
+				corrupt = false;
+				uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+				const uint64_t head = header_->head.load(std::memory_order_acquire);
+				if (tail == head)
+					return false;
+				if (head - tail > size_)
+				{
+					corrupt = true;
+					return false;
+				}
+				uint64_t offset = tail & (size_ - 1);
+				uint32_t payload = read_u32(data_ + offset);
+				if (payload == ZERO_SHM_PAD)
+				{
+					tail += size_ - offset;
+					offset = 0;
+					if (head - tail > size_)
+					{
+						corrupt = true;
+						return false;
+					}
+					if (tail == head)
+					{
+						header_->tail.store(tail, std::memory_order_release);
+						return false;
+					}
+					payload = read_u32(data_);
+				}
+				//记录不跨越环尾,不超过push的上限,也不超过已写入的范围
+				const uint64_t need = align(sizeof(uint32_t) + static_cast<uint64_t>(payload));
+				if (payload < sizeof(uint32_t) || need > size_ / 2 || need > size_ - offset || need > head - tail)
+				{
+					corrupt = true;
+					return false;
+				}
+				const char* ptr = data_ + offset + sizeof(uint32_t);
+				const uint32_t count = read_u32(ptr);
+				//先校验全部帧长度,再构造帧
+				uint64_t left = payload - sizeof(uint32_t);
+				if (count > left / sizeof(uint32_t))
+				{
+					corrupt = true;
+					return false;
+				}
+				const char* check = ptr + sizeof(uint32_t);
+				for (uint32_t idx = 0; idx < count; idx++)
+				{
+					const uint64_t len = read_u32(check);
+					if (left < sizeof(uint32_t) + len)
+					{
+						corrupt = true;
+						return false;
+					}
+					left -= sizeof(uint32_t) + len;
+					check += sizeof(uint32_t) + len;
+				}
+				ptr += sizeof(uint32_t);
+				for (uint32_t idx = 0; idx < count; idx++)
+				{
+					const uint32_t len = read_u32(ptr);
+					ptr += sizeof(uint32_t);
+					if (idx < frames.size())
+						frames[idx].assign(ptr, len);
+					else if (len == 0)
+						frames.emplace_back();
+					else
+					{
+						frames.emplace_back();
+						frames.back().assign(ptr, len);
+					}
+					ptr += len;
+				}
+				frames.resize(count);
+				header_->tail.store(tail + need, std::memory_order_release);
+				return true;
+			}
+
+			/**
+			* \brief 一个环占用的共享内存大小
+			*/
+			static uint64_t memory_size(uint64_t size)
+			{
+				return sizeof(shm_ring_header) + size;
+			}
+		private:
+			static uint64_t align(uint64_t size)
+			{
+				return (size + 7) & ~static_cast<uint64_t>(7);
+			}
+
+			static void write_u32(char* ptr, uint32_t value)
+			{
+				memcpy(ptr, &value, sizeof(uint32_t));
+			}
+
+			static uint32_t read_u32(const char* ptr)
+			{
+				uint32_t value;
+				memcpy(&value, ptr, sizeof(uint32_t));
+				return value;
+			}
+		};
+
+		/**
+		* \brief 站点的共享内存端点(中心一侧)
+		*/
+		class shm_segment
+		{
+			/**
+			* \brief 站点名称
+			*/
+			string station_;
+			/**
+			* \brief 映射的内存
+			*/
+			char* memory_;
+			/**
+			* \brief 映射大小
+			*/
+			size_t memory_size_;
+			/**
+			* \brief 段头
+			*/
+			shm_segment_header* header_;
+			/**
+			* \brief 出环(中心 => 工作者)
+			*/
+			shm_ring out_;
+			/**
+			* \brief 入环(工作者 => 中心)
+			*/
+			shm_ring in_;
+			/**
+			* \brief 入环的唤醒管道(读)
+			*/
+			int in_bell_;
+			/**
+			* \brief 出环的唤醒管道(写)
+			*/
+			int out_bell_;
+			/**
+			* \brief 是否因环损坏而停用(停用后不再接受工作者连接,全部走TCP)
+			*/
+			bool detached_;
+		public:
+			/**
+			* \brief 构造
+			*/
+			shm_segment()
+				: memory_(nullptr)
+				, memory_size_(0)
+				, header_(nullptr)
+				, in_bell_(-1)
+				, out_bell_(-1)
+				, detached_(false)
+			{
+			}
+
+			/**
+			* \brief 析构
+			*/
+			~shm_segment()
+			{
+				destroy();
+			}
+
+			/**
+			* \brief 创建段与唤醒管道
+			* \param station 站点名称
+			* \param ring_size 每个环的容量(向上取2的幂)
+			*/
+			bool create(const char* station, uint64_t ring_size);
+
+			/**
+			* \brief 释放并删除段与唤醒管道
+			*/
+			void destroy();
+
+			/**
+			* \brief 是否已有工作者连接
+			*/
+			bool attached() const
+			{
+				return header_ != nullptr && !detached_ && header_->worker_pid.load(std::memory_order_relaxed) != 0;
+			}
+
+			/**
+			* \brief 检查工作者进程是否仍存活,已退出则清空环以便重新连接
+			*/
+			void check_peer();
+
+			/**
+			* \brief 环损坏时停用共享内存,断开工作者,此后只走TCP
+			*/
+			void detach();
+
+			/**
+			* \brief 入环的唤醒管道,用于加入轮询
+			*/
+			int in_bell() const
+			{
+				return in_bell_;
+			}
+
+			/**
+			* \brief 入环
+			*/
+			shm_ring& in()
+			{
+				return in_;
+			}
+
+			/**
+			* \brief 发送到工作者(出环),工作者休眠时唤醒
+			* \return 未连接或空间不足时返回false
+			*/
+			bool send(const vector<shared_char>& datas, size_t first_index);
+
+			/**
+			* \brief 读空入环的唤醒管道
+			*/
+			void drain_bell() const;
+		};
+	}
+}
+#endif //!_ZERO_SHM_RING_H_
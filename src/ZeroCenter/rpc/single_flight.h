@@ -0,0 +1,316 @@
+#pragma once
+#ifndef _ZERO_SINGLE_FLIGHT_H_
+#define _ZERO_SINGLE_FLIGHT_H_
+#include "../stdinc.h"
+#include "../ext/shared_char.h"
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		* \brief 等待合并结果的请求
+		*/
+		struct flight_waiter
+		{
+			/**
+			* \brief 调用者地址
+			*/
+			shared_char caller;
+			/**
+			* \brief 请求者
+			*/
+			shared_char requester;
+			/**
+			* \brief 请求标识
+			*/
+			shared_char request_id;
+			/**
+			* \brief 全局标识
+			*/
+			shared_char global_id;
+			/**
+			* \brief 全局标识是否为二进制
+			*/
+			bool global_id_bin;
+		};
+
+		/**
+		* \brief 一个正在执行的请求及等待它结果的相同请求
+		*/
+		struct flight
+		{
+			/**
+			* \brief 命令与参数(用于排除哈希冲突)
+			*/
+			string key;
+			/**
+			* \brief 发往工作者的请求的标识(inflight_key)
+			*/
+			string leader;
+			/**
+			* \brief 发往工作者的时间(微秒)
+			*/
+			int64 start_time;
+			/**
+			* \brief 等待的请求
+			*/
+			vector<flight_waiter> waiters;
+		};
+
+		/**
+		* \brief 相同请求的合并(single-flight)
+		* \remark
+		* 只对配置为幂等的命令(zero_config::single_flight)启用.命令帧、参数帧与内容帧相同的请求
+		* 只有第一个发往工作者,其余的暂存,工作者返回时把同一个结果分发给全部等待者.
+		* 命令与参数以FNV-1a哈希查找,命中后再比较原文.上下文帧不参与比较,配置的命令须与调用者无关.
+		* 超过超时时间仍未返回的合并不再接受新的请求,由站点以超时状态回复其等待者.
+		* 本身不加锁,只由站点的轮询线程访问.
+		*/
+		class single_flight
+		{
+			/**
+			* \brief 是否所有命令都合并
+			*/
+			bool all_;
+			/**
+			* \brief 合并的命令
+			*/
+			set<string> commands_;
+			/**
+			* \brief 超时(微秒)
+			*/
+			int64 timeout_;
+			/**
+			* \brief 每个合并的等待数量上限
+			*/
+			size_t max_waiters_;
+			/**
+			* \brief 哈希 => 合并
+			*/
+			boost::unordered_map<uint64_t, flight> flights_;
+			/**
+			* \brief 发往工作者的请求的标识 => 哈希
+			*/
+			boost::unordered_map<string, uint64_t> leaders_;
+			/**
+			* \brief 上次检查超时的时间(微秒)
+			*/
+			int64 check_time_;
+		public:
+			/**
+			* \brief 构造
+			*/
+			single_flight()
+				: all_(false)
+				, timeout_(0)
+				, max_waiters_(0)
+				, check_time_(0)
+			{
+			}
+
+			/**
+			* \brief 初始化
+			* \param commands 合并的命令("*" 表示全部)
+			* \param timeout 超时(毫秒)
+			* \param max_waiters 每个合并的等待数量上限
+			*/
+			void initialize(const vector<string>& commands, int timeout, int max_waiters)
+			{
+				all_ = false;
+				commands_.clear();
+				for (auto& command : commands)
+				{
+					if (command == "*")
+						all_ = true;
+					else if (!command.empty())
+						commands_.insert(command);
+				}
+				timeout_ = (timeout > 0 ? timeout : 3000) * 1000LL;
+				max_waiters_ = max_waiters > 0 ? static_cast<size_t>(max_waiters) : 1;
+				flights_.clear();
+				leaders_.clear();
+				check_time_ = 0;
+			}
+
+			/**
+			* \brief 是否启用
+			*/
+			bool enable() const
+			{
+				return all_ || !commands_.empty();
+			}
+
+			/**
+			* \brief 是否有正在执行的合并
+			*/
+			bool empty() const
+			{
+				return flights_.empty();
+			}
+
+			/**
+			* \brief 取得可合并请求的命令与参数
+			* \param list 请求帧(说明帧为list[1])
+			* \param key 命令与参数
+			* \return 命令不需合并时返回false
+			*/
+			bool make_key(const vector<shared_char>& list, string& key) const
+			{
+				const shared_char& description = list[1];
+				bool matched = false;
+				key.clear();
+				for (size_t idx = 2; idx < description.frame_size() + 2 && idx < list.size(); idx++)
+				{
+					const char type = description[idx];
+					switch (type)
+					{
+					case ZERO_FRAME_COMMAND:
+						if (!all_ && commands_.find(string(*list[idx], list[idx].size())) == commands_.end())
+							return false;
+						matched = true;
+						break;
+					case ZERO_FRAME_ARG:
+					case ZERO_FRAME_CONTENT_TEXT:
+					case ZERO_FRAME_CONTENT_JSON:
+					case ZERO_FRAME_CONTENT_BIN:
+					case ZERO_FRAME_CONTENT_XML:
+						break;
+					default:
+						continue;
+					}
+					//类型与长度作为分隔,避免帧边界不同而内容拼接相同
+					const uint32_t size = static_cast<uint32_t>(list[idx].size());
+					key.append(1, type);
+					key.append(reinterpret_cast<const char*>(&size), sizeof(size));
+					key.append(*list[idx], list[idx].size());
+				}
+				return matched;
+			}
+
+			/**
+			* \brief FNV-1a 哈希
+			*/
+			static uint64_t hash(const string& key)
+			{
+				uint64_t value = 14695981039346656037ULL;
+				for (char ch : key)
+				{
+					value ^= static_cast<uchar>(ch);
+					value *= 1099511628211ULL;
+				}
+				return value;
+			}
+
+			/**
+			* \brief 相同的请求正在执行时加入等待
+			* \param code 命令与参数的哈希
+			* \param key 命令与参数
+			* \param waiter 等待者
+			* \param now 当前时间(微秒)
+			* \return 加入等待时返回true,否则调用者应发往工作者并调用lead
+			*/
+			bool join(uint64_t code, const string& key, flight_waiter& waiter, int64 now)
+			{
+				const auto iter = flights_.find(code);
+				if (iter == flights_.end())
+					return false;
+				flight& item = iter->second;
+				//哈希冲突、已超时或等待者过多时单独执行
+				if (item.key != key || now - item.start_time >= timeout_ || item.waiters.size() >= max_waiters_)
+					return false;
+				item.waiters.push_back(std::move(waiter));
+				return true;
+			}
+
+			/**
+			* \brief 记录已发往工作者的请求,此后相同的请求等待其结果
+			* \param code 命令与参数的哈希
+			* \param key 命令与参数
+			* \param leader 发往工作者的请求的标识(inflight_key)
+			* \param now 当前时间(微秒)
+			* \param expired 被替换的超时合并的等待者
+			*/
+			void lead(uint64_t code, string& key, string&& leader, int64 now, vector<flight_waiter>& expired)
+			{
+				const auto iter = flights_.find(code);
+				if (iter != flights_.end())
+				{
+					//哈希冲突或等待者已满时保留原有的合并
+					if (now - iter->second.start_time < timeout_)
+						return;
+					for (auto& waiter : iter->second.waiters)
+						expired.push_back(std::move(waiter));
+					leaders_.erase(iter->second.leader);
+					flights_.erase(iter);
+				}
+				flight& item = flights_[code];
+				item.key.swap(key);
+				item.leader = leader;
+				item.start_time = now;
+				leaders_.emplace(std::move(leader), code);
+			}
+
+			/**
+			* \brief 工作者返回时取出等待者
+			* \param leader 返回对应的请求标识(inflight_key)
+			* \param waiters 等待者
+			* \return 是否为合并的请求
+			*/
+			bool finish(const string& leader, vector<flight_waiter>& waiters)
+			{
+				const auto iter = leaders_.find(leader);
+				if (iter == leaders_.end())
+					return false;
+				const auto item = flights_.find(iter->second);
+				leaders_.erase(iter);
+				if (item == flights_.end())
+					return false;
+				waiters.swap(item->second.waiters);
+				flights_.erase(item);
+				return true;
+			}
+
+			/**
+			* \brief 取出全部等待者并清空(站点关闭或重启时)
+			* \param waiters 等待者
+			*/
+			void clear(vector<flight_waiter>& waiters)
+			{
+				for (auto& item : flights_)
+				{
+					for (auto& waiter : item.second.waiters)
+						waiters.push_back(std::move(waiter));
+				}
+				flights_.clear();
+				leaders_.clear();
+				check_time_ = 0;
+			}
+
+			/**
+			* \brief 取出超时的合并的等待者(每秒至多检查一次)
+			* \param now 当前时间(微秒)
+			* \param waiters 等待者
+			*/
+			void expire(int64 now, vector<flight_waiter>& waiters)
+			{
+				if (flights_.empty() || now - check_time_ < 1000000LL)
+					return;
+				check_time_ = now;
+				for (auto iter = flights_.begin(); iter != flights_.end();)
+				{
+					if (now - iter->second.start_time < timeout_)
+					{
+						++iter;
+						continue;
+					}
+					for (auto& waiter : iter->second.waiters)
+						waiters.push_back(std::move(waiter));
+					leaders_.erase(iter->second.leader);
+					iter = flights_.erase(iter);
+				}
+			}
+		};
+	}
+}
+#endif //!_ZERO_SINGLE_FLIGHT_H_
@@ -6,6 +6,7 @@
 #include "station_dispatcher.h"
 #include <utility>
 #include "broadcasting_station.h"
+#include "zero_bench.h"
 
 namespace agebull
 {
@@ -43,15 +44,14 @@ namespace agebull
 			shared_char description;
 
 			description.alloc_frame_1(static_cast<char>(event_name), ZERO_FRAME_SUBTITLE);
+			if (content != nullptr)
+				description.append_frame(ZERO_FRAME_CONTENT);
 			vector<shared_char> datas;
 			datas.emplace_back(title);
-			datas.emplace_back(description);
+			datas.emplace_back(std::move(description));
 			datas.emplace_back(sub);
 			if (content != nullptr)
-			{
-				description.append_frame(ZERO_FRAME_CONTENT);
 				datas.emplace_back(content);
-			}
 			return instance->send_response(datas);
 		}
 		char frames[] = {
@@ -76,19 +76,19 @@ namespace agebull
 			datas.emplace_back(arg.c_str());
 
 			shared_char global_id;
-			global_id.set_int64x(station_warehouse::get_glogal_id());
+			datas[1].frame_type(sizeof(frames) - 1, write_global_id(global_id, station_warehouse::get_glogal_id()));
 			datas.emplace_back(global_id);
 			return send_response(datas);
 		}
 
 		const char* station_commands_1[] =
 		{
-			"pause", "resume", "start", "close", "host", "install", "stop","recover", "update","remove", "doc"
+			"pause", "resume", "start", "close", "host", "install", "stop","recover", "update","remove", "doc", "bench", "latency", "quota"
 		};
 
 		enum class station_commands_2
 		{
-			pause, resume, start, close, host, install, stop, recover, update, remove, doc
+			pause, resume, start, close, host, install, stop, recover, update, remove, doc, bench, latency, quota
 		};
 		/**
 		* \brief 执行命令
@@ -164,6 +164,30 @@ namespace agebull
 			{
 				return station_warehouse::host_info(arguments.empty() ? "*" : arguments[0], json);
 			}
+			case station_commands_2::bench:
+			{
+				return zero_bench::start(arguments, json);
+			}
+			case station_commands_2::latency:
+			{
+				if (arguments.empty())
+					return ZERO_STATUS_ARG_INVALID_ID;
+				const shared_ptr<zero_config> config = station_warehouse::get_config(*arguments[0], false);
+				if (!config)
+					return ZERO_STATUS_NOT_FIND_ID;
+				json = config->to_latency_json();
+				return ZERO_STATUS_OK_ID;
+			}
+			case station_commands_2::quota:
+			{
+				if (arguments.empty())
+					return ZERO_STATUS_ARG_INVALID_ID;
+				const shared_ptr<zero_config> config = station_warehouse::get_config(*arguments[0], false);
+				if (!config)
+					return ZERO_STATUS_NOT_FIND_ID;
+				json = config->to_quota_json();
+				return ZERO_STATUS_OK_ID;
+			}
 			default:
 				return ZERO_STATUS_NOT_SUPPORT_ID;
 			}
@@ -179,14 +203,14 @@ namespace agebull
 			switch (state)
 			{
 			case ZERO_BYTE_COMMAND_PING:
-				send_request_status(socket, *list[0], ZERO_STATUS_OK_ID);
+				send_request_status(socket, list[0], ZERO_STATUS_OK_ID);
 				return;
 			case ZERO_BYTE_COMMAND_HEART_JOIN:
 			case ZERO_BYTE_COMMAND_HEART_READY:
 			case ZERO_BYTE_COMMAND_HEART_PITPAT:
 			case ZERO_BYTE_COMMAND_HEART_LEFT:
 				const bool success = list.size() > 2 && station_warehouse::heartbeat(state, list);
-				send_request_status(socket, *list[0], success ? ZERO_STATUS_OK_ID : ZERO_STATUS_FAILED_ID);
+				send_request_status(socket, list[0], success ? ZERO_STATUS_OK_ID : ZERO_STATUS_FAILED_ID);
 				return;
 			}
 			const char* cmd = nullptr;
@@ -211,6 +235,7 @@ namespace agebull
 					arg.emplace_back(list[idx]);
 					break;
 				case ZERO_FRAME_GLOBAL_ID:
+				case ZERO_FRAME_GLOBAL_ID_BIN:
 					glid_index = idx;
 					break;
 				}
@@ -223,7 +248,7 @@ namespace agebull
 			string json;
 			const char code = exec_command(cmd, arg, json);
 
-			send_request_status(socket, *list[0], code, list, glid_index, rqid_index, reqer_index,
+			send_request_status(socket, list[0], code, list, glid_index, rqid_index, reqer_index,
 				code == ZERO_STATUS_OK_ID && json.length() > 0 ? json.c_str() : nullptr);
 		}
 
@@ -237,7 +262,7 @@ namespace agebull
 				set_command_thread_bad(config.station_name_.c_str());
 				return;
 			}
-			if (!station_warehouse::join(station.get()))
+			if (!station_warehouse::join(station))
 			{
 				instance = nullptr;
 				config.failed("join warehouse");
@@ -277,22 +302,47 @@ namespace agebull
 			zero_config& config = instance->get_config();
 			config.log("monitor poll start");
 			instance->task_semaphore_.post();
+			map<string, station_status> snapshots;//上次发布的状态
+			int64 cycle = 0;
 			while (get_net_state() < NET_STATE_CLOSING)
 			{
-				thread_sleep(json_config::worker_sound_ivl);
+				if (wait_net_closing(json_config::worker_sound_ivl))
+					break;
+				//只发布有变化的字段,每隔worker_state_full_ivl个周期发布一次全量以便订阅者重新同步
+				const bool full = json_config::worker_state_full_ivl <= 1 || cycle++ % json_config::worker_state_full_ivl == 0;
 				vector<string> cfgs;//复制避免锁定时间过长
 				vector<string> names;//复制避免锁定时间过长
-				station_warehouse::foreach_configs([&cfgs, &names](shared_ptr<zero_config>& cfg)
+				vector<bool> fulls;
+				set<string> lives;
+				station_warehouse::foreach_configs([&](const shared_ptr<zero_config>& cfg)
 				{
 					cfg->check_works();
+					lives.insert(cfg->station_name_);
+					station_status& last = snapshots[cfg->station_name_];
+					const bool first = !last.has_value;
+					acl::string json = cfg->to_delta_json(last, full);
+					if (json.empty())
+						return;
 					names.emplace_back(cfg->station_name_);
-					cfgs.emplace_back(cfg->to_status_json().c_str());
+					fulls.push_back(full || first);
+					cfgs.emplace_back(json.c_str());
 				});
+				if (snapshots.size() > lives.size())
+				{
+					for (auto iter = snapshots.begin(); iter != snapshots.end();)
+					{
+						if (lives.find(iter->first) == lives.end())
+							iter = snapshots.erase(iter);
+						else
+							++iter;
+					}
+				}
 				instance->publish_event(zero_net_event::event_worker_sound_off, "worker", nullptr, nullptr);
 
 				for (size_t i = 0; i < names.size(); i++)
 				{
-					instance->publish_event(zero_net_event::event_station_state, "station", names[i].c_str(), cfgs[i].c_str());
+					instance->publish_event(fulls[i] ? zero_net_event::event_station_state : zero_net_event::event_station_delta,
+						"station", names[i].c_str(), cfgs[i].c_str());
 				}
 			}
 			instance->task_semaphore_.post();
@@ -0,0 +1,239 @@
+/**
+ * 共享的站点反应器
+ */
+#include "../stdafx.h"
+#include "station_reactor.h"
+#include "../ext/frame_pool.h"
+#include <sys/eventfd.h>
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		vector<shared_ptr<station_reactor>> station_reactor::pool_;
+		boost::mutex station_reactor::pool_mutex_;
+		/**
+		* \brief 反应器序号
+		*/
+		static std::atomic<int> reactor_sequence(0);
+
+		/**
+		* \brief 构造
+		*/
+		station_reactor::station_reactor()
+			: stopped_(false)
+			, bell_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+			, count_(0)
+			, name_("reactor:" + std::to_string(++reactor_sequence))
+		{
+		}
+
+		/**
+		* \brief 析构
+		*/
+		station_reactor::~station_reactor()
+		{
+			if (bell_ >= 0)
+				close(bell_);
+		}
+
+		/**
+		* \brief 把已初始化的站点交给站点数最少的反应器
+		*/
+		void station_reactor::attach(shared_ptr<zero_station> station, std::function<void()> closed)
+		{
+			entry item{ std::move(station), std::move(closed) };
+			while (true)
+			{
+				shared_ptr<station_reactor> reactor;
+				{
+					boost::lock_guard<boost::mutex> guard(pool_mutex_);
+					const size_t size = json_config::reactor_threads > 0 ? static_cast<size_t>(json_config::reactor_threads) : 1;
+					if (pool_.size() < size)
+					{
+						reactor = make_shared<station_reactor>();
+						pool_.push_back(reactor);
+						boost::thread(boost::bind(&station_reactor::run, reactor));
+					}
+					else
+					{
+						for (auto& iter : pool_)
+						{
+							if (!reactor || iter->count_.load() < reactor->count_.load())
+								reactor = iter;
+						}
+					}
+				}
+				if (reactor->add(item))
+					return;
+				//反应器已停止,换一个
+				boost::lock_guard<boost::mutex> guard(pool_mutex_);
+				pool_.erase(std::remove(pool_.begin(), pool_.end(), reactor), pool_.end());
+			}
+		}
+
+		/**
+		* \brief 加入站点
+		*/
+		bool station_reactor::add(entry& item)
+		{
+			{
+				boost::lock_guard<boost::mutex> guard(mutex_);
+				if (stopped_)
+					return false;
+				//套接字在加锁后交给反应器线程,锁保证了ZMQ跨线程移交套接字所需的内存屏障
+				joining_.push_back(std::move(item));
+				count_++;
+			}
+			ring();
+			return true;
+		}
+
+		/**
+		* \brief 唤醒反应器线程
+		*/
+		void station_reactor::ring() const
+		{
+			const uint64_t one = 1;
+			if (bell_ >= 0 && write(bell_, &one, sizeof(one)) < 0 && errno != EAGAIN)
+				log_error1("[reactor] > bell > %s", strerror(errno));
+		}
+
+		/**
+		* \brief 唤醒全部反应器
+		*/
+		void station_reactor::wake_all()
+		{
+			boost::lock_guard<boost::mutex> guard(pool_mutex_);
+			for (auto& reactor : pool_)
+				reactor->ring();
+		}
+
+		/**
+		* \brief 取出待加入的站点并开始轮询
+		*/
+		bool station_reactor::accept()
+		{
+			vector<entry> joining;
+			{
+				boost::lock_guard<boost::mutex> guard(mutex_);
+				joining.swap(joining_);
+			}
+			for (auto& item : joining)
+			{
+				item.station->get_config().set_poll_thread(name_);
+				zero_station::set_polling(item.station.get());
+				item.station->poll_start();
+				zero_station::set_polling(nullptr);
+				stations_.push_back(std::move(item));
+			}
+			return !joining.empty();
+		}
+
+		/**
+		* \brief 反应器线程
+		*/
+		void station_reactor::run()
+		{
+			frame_pool::set_thread_name(name_.c_str());
+			log_msg1("[%s] > runing", name_.c_str());
+			vector<zmq_pollitem_t> items;
+			//各站点在items中的起始位置
+			vector<size_t> offsets;
+			bool changed = true;
+			while (true)
+			{
+				changed |= accept();
+				if (stations_.empty() && get_net_state() >= NET_STATE_CLOSING)
+				{
+					boost::lock_guard<boost::mutex> guard(mutex_);
+					if (joining_.empty())
+					{
+						stopped_ = true;
+						break;
+					}
+					continue;
+				}
+				if (changed)
+				{
+					items.clear();
+					offsets.clear();
+					items.push_back({ nullptr, bell_, ZMQ_POLLIN, 0 });
+					for (auto& item : stations_)
+					{
+						offsets.push_back(items.size());
+						items.insert(items.end(), item.station->poll_items_, item.station->poll_items_ + item.station->poll_count_);
+					}
+					changed = false;
+				}
+				//状态变化经eventfd立即唤醒,超时只是兜底
+				int timeout = 1000;
+				for (auto& item : stations_)
+				{
+					if (!item.station->poll_prepare())
+						timeout = 0;
+					else if (timeout > 0)
+						timeout = std::min(timeout, item.station->poll_timeout());
+				}
+				const int state = zmq_poll(items.data(), static_cast<int>(items.size()), timeout);
+				if (state > 0 && (items[0].revents & ZMQ_POLLIN))
+				{
+					uint64_t count;
+					while (read(bell_, &count, sizeof(count)) > 0)
+					{
+					}
+				}
+				for (size_t idx = 0; idx < stations_.size();)
+				{
+					zero_station* station = stations_[idx].station.get();
+					zmq_pollitem_t* slice = items.data() + offsets[idx];
+					int ready = state;
+					if (state > 0)
+					{
+						ready = 0;
+						for (int sub = 0; sub < station->poll_count_; sub++)
+						{
+							if (slice[sub].revents != 0)
+								++ready;
+						}
+					}
+					zero_station::set_polling(station);
+					bool keep;
+					if (!station->can_do())
+					{
+						station->zmq_state_ = zmq_socket_state::Intr;
+						keep = false;
+					}
+					else
+					{
+						keep = station->on_poll(ready, slice);
+					}
+					if (keep)
+					{
+						zero_station::set_polling(nullptr);
+						++idx;
+						continue;
+					}
+					station->poll_end();
+					if (station->hot_restart())
+					{
+						//套接字与轮询节点不变,继续在本反应器中轮询
+						station->poll_start();
+						zero_station::set_polling(nullptr);
+						++idx;
+						continue;
+					}
+					zero_station::set_polling(nullptr);
+					entry item = std::move(stations_[idx]);
+					stations_.erase(stations_.begin() + idx);
+					offsets.erase(offsets.begin() + idx);
+					changed = true;
+					count_--;
+					//清理与重启,重启的站点在新线程中初始化后再次加入
+					item.closed();
+				}
+			}
+			log_msg1("[%s] > closed", name_.c_str());
+		}
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+#ifndef _ZERO_STATION_REACTOR_H_
+#define _ZERO_STATION_REACTOR_H_
+#include "../stdinc.h"
+#include "zero_station.h"
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		* \brief 共享的站点反应器
+		* \remark
+		* 低流量的业务站点(zero_config::is_use_reactor)不再各占一个线程,
+		* 由固定数量(json_config::reactor_threads)的反应器线程把多个站点的套接字放在同一个zmq_poll中轮询.
+		* 站点在启动线程中完成初始化后交给站点数最少的反应器,此后其套接字只由该反应器线程使用;
+		* 轮询结束时在反应器线程中执行站点的清理与重启回调.
+		*/
+		class station_reactor
+		{
+			/**
+			* \brief 反应器中的站点
+			*/
+			struct entry
+			{
+				shared_ptr<zero_station> station;
+				std::function<void()> closed;
+			};
+			/**
+			* \brief 待加入的站点与停止标记的访问锁
+			*/
+			boost::mutex mutex_;
+			/**
+			* \brief 待加入的站点
+			*/
+			vector<entry> joining_;
+			/**
+			* \brief 是否已停止(停止后不再接受站点)
+			*/
+			bool stopped_;
+			/**
+			* \brief 有站点加入或网络状态变化时的唤醒(eventfd,加入轮询)
+			*/
+			int bell_;
+			/**
+			* \brief 站点数量(含待加入)
+			*/
+			std::atomic<int> count_;
+			/**
+			* \brief 正在轮询的站点(仅反应器线程使用)
+			*/
+			vector<entry> stations_;
+			/**
+			* \brief 反应器名称(线程名称,用于帧内存池的线程统计)
+			*/
+			string name_;
+
+			/**
+			* \brief 反应器池
+			*/
+			static vector<shared_ptr<station_reactor>> pool_;
+			/**
+			* \brief 反应器池的访问锁
+			*/
+			static boost::mutex pool_mutex_;
+		public:
+			/**
+			* \brief 构造
+			*/
+			station_reactor();
+
+			/**
+			* \brief 析构
+			*/
+			~station_reactor();
+
+			station_reactor(const station_reactor&) = delete;
+			station_reactor& operator=(const station_reactor&) = delete;
+
+			/**
+			* \brief 把已初始化的站点交给站点数最少的反应器
+			* \param station 站点
+			* \param closed 轮询结束后在反应器线程中调用(清理与重启)
+			*/
+			static void attach(shared_ptr<zero_station> station, std::function<void()> closed);
+
+			/**
+			* \brief 唤醒全部反应器(网络状态变化后调用,没有站点的反应器也能立即结束)
+			*/
+			static void wake_all();
+		private:
+			/**
+			* \brief 加入站点
+			* \return 反应器已停止时返回false
+			*/
+			bool add(entry& item);
+
+			/**
+			* \brief 唤醒反应器线程
+			*/
+			void ring() const;
+
+			/**
+			* \brief 反应器线程
+			*/
+			void run();
+
+			/**
+			* \brief 取出待加入的站点并开始轮询
+			* \return 是否有站点加入
+			*/
+			bool accept();
+		};
+	}
+}
+#endif //!_ZERO_STATION_REACTOR_H_
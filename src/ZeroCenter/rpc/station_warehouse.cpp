@@ -17,24 +17,24 @@ namespace agebull
 		/**
 		 * \brief 活动实例集合
 		 */
-		map<string, zero_station*> station_warehouse::examples_;
+		cow_map<string, weak_ptr<zero_station>> station_warehouse::examples_;
 		/**
 		* \brief 配置集合
 		*/
-		map<string, shared_ptr<zero_config>> station_warehouse::configs_;
+		cow_map<string, shared_ptr<zero_config>> station_warehouse::configs_;
 		/**
-		* \brief 实例队列访问锁
+		* \brief 配置写入与主机信息缓存锁
 		*/
-		boost::mutex station_warehouse::examples_mutex_;
+		boost::mutex station_warehouse::config_mutex_;
 		/**
-		* \brief 实例队列访问锁
+		* \brief 全部站点信息的缓存(由config_mutex_保护)
 		*/
-		boost::mutex station_warehouse::config_mutex_;
+		string host_json;
 
 		/**
 		* \brief 全局ID
 		*/
-		int64 station_warehouse::glogal_id_ = 0;
+		std::atomic<int64> station_warehouse::glogal_id_(0);
 		/**
 		* \brief 启动次数
 		*/
@@ -49,22 +49,34 @@ namespace agebull
 			acl::string val;
 			if (redis->get(port_redis_key, val) && atol(val.c_str()) >= json_config::base_tcp_port)
 			{
+				const int64 start = latency_histogram::now();
 				int cursor = 0;
+				size_t loaded = 0;
 				do
 				{
-					size_t count = 10;
+					//每批键用一次MGET读取,启动时间不再随站点数量成倍增加Redis往返
+					size_t count = 1000;
 					vector<acl::string> keys;
 					cursor = redis->scan(cursor, keys, "net:host:*", &count);
-					for (const acl::string& key : keys)
+					if (keys.empty())
+						continue;
+					vector<acl::string> values;
+					if (!redis->mget(keys, &values))
 					{
-						if (redis->get(key, val) && !val.empty())
-						{
-							shared_ptr<zero_config> config = make_shared<zero_config>();
-							config->read_json(val);
-							insert_config(config);
-						}
+						log_error1("[station_warehouse] > mget failed(%d keys)", static_cast<int>(keys.size()));
+						continue;
+					}
+					for (const acl::string& json : values)
+					{
+						if (json.empty())
+							continue;
+						shared_ptr<zero_config> config = make_shared<zero_config>();
+						config->read_json(json);
+						insert_config(config);
+						loaded++;
 					}
 				} while (cursor > 0);
+				log_msg2("[station_warehouse] > %d configs loaded(%lldms)", static_cast<int>(loaded), (latency_histogram::now() - start) / 1000);
 			}
 			else
 			{
@@ -86,12 +98,12 @@ namespace agebull
 		{
 			glogal_id_ = 0LL;
 			int cnt = 0;
-			boost::lock_guard<boost::mutex> guard(config_mutex_);
-			for (auto& kv : configs_)
+			for (auto& kv : *configs_.snapshot())
 			{
 				if (kv.second->station_type_ <= STATION_TYPE_DISPATCHER || kv.second->station_type_ > STATION_TYPE_SPECIAL)
 					continue;
-				if (restore(kv.second))
+				shared_ptr<zero_config> config = kv.second;
+				if (restore(config))
 					cnt++;
 			}
 			return cnt;
@@ -135,6 +147,7 @@ namespace agebull
 			}
 			{
 				boost::lock_guard<boost::mutex> guard(config_mutex_);
+				host_json.clear();
 				configs_.clear();
 			}
 			initialize();
@@ -142,16 +155,15 @@ namespace agebull
 		/**
 		* \brief 遍历配置
 		*/
-		void station_warehouse::foreach_configs(std::function<void(shared_ptr<zero_config>&)> look)
+		void station_warehouse::foreach_configs(std::function<void(const shared_ptr<zero_config>&)> look)
 		{
-			boost::lock_guard<boost::mutex> guard(config_mutex_);
-			for (auto & config : configs_)
+			//遍历的是快照,回调中可以安装或删除站点
+			const auto configs = configs_.snapshot();
+			for (auto & config : *configs)
 			{
 				look(config.second);
 			}
 		}
-
-		string host_json;
 		/**
 		* \brief 取机器信息
 		*/
@@ -167,7 +179,7 @@ namespace agebull
 				}
 				json = "[";
 				bool first = true;
-				for (auto& config : configs_)
+				for (auto& config : *configs_.snapshot())
 				{
 					if (first)
 						first = false;
@@ -179,12 +191,12 @@ namespace agebull
 				host_json = json;
 				return ZERO_STATUS_OK_ID;
 			}
-			const auto iter = configs_.find(station_name);
-			if (iter == configs_.end())
+			shared_ptr<zero_config> config;
+			if (!configs_.find(station_name, config))
 			{
 				return ZERO_STATUS_NOT_FIND_ID;
 			}
-			json = iter->second->to_full_json().c_str();
+			json = config->to_full_json().c_str();
 			return ZERO_STATUS_OK_ID;
 		}
 
@@ -193,12 +205,12 @@ namespace agebull
 		*/
 		void station_warehouse::insert_config(shared_ptr<zero_config> config)
 		{
-			host_json.clear();
 			config->check_type_name();
 			{
 				boost::lock_guard<boost::mutex> guard(config_mutex_);
-				assert(configs_.find(config->station_name_) == configs_.end());
-				configs_[config->station_name_] = config;
+				host_json.clear();
+				assert(!configs_.contains(config->station_name_));
+				configs_.set(config->station_name_, config);
 			}
 		}
 
@@ -207,29 +219,22 @@ namespace agebull
 		*/
 		void station_warehouse::save_configs()
 		{
-			boost::lock_guard<boost::mutex> guard(config_mutex_);
 			redis_live_scope redis(json_config::redis_defdb);
-			for (auto& iter : configs_)
+			for (auto& iter : *configs_.snapshot())
 			{
 				boost::format fmt("net:host:%1%");
 				fmt % iter.first;
 				redis->set(fmt.str().c_str(), iter.second->to_full_json());
 			}
 		}
-		shared_ptr<zero_config> empty_config;
 		/**
 		* \brief 取得配置
 		*/
-		shared_ptr<zero_config>& station_warehouse::get_config(const string& station_name, bool find_redis)
+		shared_ptr<zero_config> station_warehouse::get_config(const string& station_name, bool find_redis)
 		{
-			boost::lock_guard<boost::mutex> guard(config_mutex_);
-			const auto iter = configs_.find(station_name);
-			if (iter != configs_.end())
-			{
-				return iter->second;
-			}
-			if (!find_redis)
-				return empty_config;
+			shared_ptr<zero_config> config;
+			if (configs_.find(station_name, config) || !find_redis)
+				return config;
 			boost::format fmt("net:host:%1%");
 			fmt % station_name;
 			auto key = fmt.str();
@@ -237,20 +242,27 @@ namespace agebull
 			acl::string json;
 			if (redis->get(key.c_str(), json) && !json.empty())
 			{
-				shared_ptr<zero_config> config = make_shared<zero_config>();
-
-				config->read_json(json);
-				configs_.insert(make_pair(station_name, config));
-				return configs_[station_name];
+				shared_ptr<zero_config> loaded = make_shared<zero_config>();
+				loaded->read_json(json);
+				boost::lock_guard<boost::mutex> guard(config_mutex_);
+				//并发加载时以先加入的为准
+				if (!configs_.find(station_name, config))
+				{
+					configs_.set(station_name, loaded);
+					config = loaded;
+				}
 			}
-			return empty_config;
+			return config;
 		}
 		/**
 		* \brief 保存站点
 		*/
 		acl::string station_warehouse::save(shared_ptr<zero_config>& config)
 		{
-			host_json.clear();
+			{
+				boost::lock_guard<boost::mutex> guard(config_mutex_);
+				host_json.clear();
+			}
 			var json = config->to_full_json();
 			boost::format fmt("net:host:%1%");
 			fmt % config->station_name_;
@@ -306,6 +318,23 @@ namespace agebull
 			return install(station_name, type, short_name, desc, false);
 		}
 
+		/**
+		* \brief 为启用合批的站点分配合批端口(已分配时直接返回)
+		*/
+		bool station_warehouse::alloc_batch_port(shared_ptr<zero_config>& config)
+		{
+			if (config->batch_port_ > 0)
+				return true;
+			redis_live_scope redis(json_config::redis_defdb);
+			int64 port;
+			if (!redis->incr(port_redis_key, &port))
+				return false;
+			config->batch_port_ = static_cast<int>(port);
+			save(config);
+			config->log("batch port", std::to_string(port).c_str());
+			return true;
+		}
+
 		/**
 		* \brief 安装站点
 		*/
@@ -317,7 +346,7 @@ namespace agebull
 			if (old)
 				return false;
 			bool failed = false;
-			foreach_configs([&config, &failed](shared_ptr<zero_config>& cfg)
+			foreach_configs([&config, &failed](const shared_ptr<zero_config>& cfg)
 			{
 				if (!failed)
 				{
@@ -379,6 +408,14 @@ namespace agebull
 			{
 				config->alias_ = new_cfg->alias_;
 			}
+			//IPC,共享内存与广播缓存,合批,站点重启后生效
+			config->use_ipc_ = new_cfg->use_ipc_;
+			config->use_shm_ = new_cfg->use_shm_;
+			config->pub_cache_size_ = new_cfg->pub_cache_size_;
+			config->pub_replay_size_ = new_cfg->pub_replay_size_;
+			config->pub_cache_bytes_ = new_cfg->pub_cache_bytes_;
+			config->pub_batch_linger_ = new_cfg->pub_batch_linger_;
+			config->pub_batch_size_ = new_cfg->pub_batch_size_;
 			acl::string json = save(config);
 			zero_event(zero_net_event::event_station_update, "station", config->station_name_.c_str(), json.c_str());
 			config->log("update");
@@ -407,7 +444,6 @@ namespace agebull
 			shared_ptr<zero_config> config = get_config(station_name);
 			if (!config || !config->is_state(station_state::Stop) || config->is_base)
 				return false;
-			host_json.clear();
 			boost::format fmt("net:host:%1%");
 			fmt % config->station_name_;
 			redis_live_scope redis(json_config::redis_defdb);
@@ -415,7 +451,11 @@ namespace agebull
 			config->log("remove");
 			var json = config->to_full_json();
 			zero_event(zero_net_event::event_station_remove, "station", config->station_name_.c_str(), json.c_str());
-			configs_.erase(station_name);
+			{
+				boost::lock_guard<boost::mutex> guard(config_mutex_);
+				host_json.clear();
+				configs_.erase(station_name);
+			}
 			return true;
 		}
 		/**
@@ -441,16 +481,12 @@ namespace agebull
 		/**
 		* \brief 加入站点
 		*/
-		bool station_warehouse::join(zero_station* station)
+		bool station_warehouse::join(const shared_ptr<zero_station>& station)
 		{
 			station->config_->log("join");
-			{
-				boost::lock_guard<boost::mutex> guard(examples_mutex_);
-				if (examples_.find(station->config_->station_name_) != examples_.end())
-					return false;
-				station->config_->runtime_state(station_state::Run);
-				examples_.insert(make_pair(station->config_->station_name_, station));
-			}
+			if (!examples_.insert(station->config_->station_name_, station))
+				return false;
+			station->config_->runtime_state(station_state::Run);
 			acl::string json = station->config_->to_full_json();
 			zero_event(zero_net_event::event_station_join, "station", station->config_->station_name_.c_str(), json.c_str());
 			return true;
@@ -462,18 +498,35 @@ namespace agebull
 		bool station_warehouse::left(zero_station* station)
 		{
 			station->config_->log("left");
+			const bool removed = examples_.update([station](map<string, weak_ptr<zero_station>>& examples)
 			{
-				boost::lock_guard<boost::mutex> guard(examples_mutex_);
-				const auto iter = examples_.find(station->config_->station_name_);
-				if (iter == examples_.end() || iter->second != station)
+				const auto iter = examples.find(station->config_->station_name_);
+				//调用者仍持有站点,lock必然成功
+				if (iter == examples.end() || iter->second.lock().get() != station)
 					return false;
-				station->config_->runtime_state(station_state::Closed);
-				examples_.erase(iter);
-			}
+				examples.erase(iter);
+				return true;
+			});
+			if (!removed)
+				return false;
+			station->config_->runtime_state(station_state::Closed);
 			zero_event(zero_net_event::event_station_left, "station", station->config_->station_name_.c_str(), "");
 			return true;
 		}
 
+		/**
+		* \brief 唤醒全部运行中的站点
+		*/
+		void station_warehouse::wake_all()
+		{
+			for (auto& item : *examples_.snapshot())
+			{
+				const shared_ptr<zero_station> station = item.second.lock();
+				if (station)
+					station->wake();
+			}
+		}
+
 		/**
 		* 当远程调用进入时的处理
 		*/
@@ -489,7 +542,7 @@ namespace agebull
 			//	}
 			//	return ZERO_STATUS_OK_ID;
 			//}
-			zero_station* station = instance(station_name);
+			const shared_ptr<zero_station> station = instance(station_name);
 			if (station == nullptr || !station->get_config().is_general())
 			{
 				return ZERO_STATUS_NOT_SUPPORT_ID;
@@ -512,7 +565,7 @@ namespace agebull
 			//	}
 			//	return ZERO_STATUS_OK_ID;
 			//}
-			zero_station* station = instance(arg);
+			const shared_ptr<zero_station> station = instance(arg);
 			if (station == nullptr || !station->get_config().is_general())
 			{
 				return ZERO_STATUS_NOT_SUPPORT_ID;
@@ -527,14 +580,15 @@ namespace agebull
 		{
 			if (arg == "*")
 			{
-				boost::lock_guard<boost::mutex> guard(examples_mutex_);
-				for (map<string, zero_station*>::value_type& station : examples_)
+				for (auto& item : *examples_.snapshot())
 				{
-					station.second->resume(true);
+					const shared_ptr<zero_station> station = item.second.lock();
+					if (station)
+						station->resume(true);
 				}
 				return ZERO_STATUS_OK_ID;
 			}
-			zero_station* station = instance(arg);
+			const shared_ptr<zero_station> station = instance(arg);
 			if (station != nullptr)
 				return station->resume(true) ? ZERO_STATUS_OK_ID : ZERO_STATUS_FAILED_ID;
 			shared_ptr<zero_config> config = get_config(arg);
@@ -548,7 +602,7 @@ namespace agebull
 		*/
 		char station_warehouse::start_station(string station_name)
 		{
-			zero_station* station = instance(station_name);
+			const shared_ptr<zero_station> station = instance(station_name);
 			if (station != nullptr)
 			{
 				return ZERO_STATUS_RUNING_ID;
@@ -561,13 +615,11 @@ namespace agebull
 		/**
 		* \brief 查找已运行站点
 		*/
-		zero_station* station_warehouse::instance(const string& name)
+		shared_ptr<zero_station> station_warehouse::instance(const string& name)
 		{
-			boost::lock_guard<boost::mutex> guard(examples_mutex_);
-			const auto iter = examples_.find(name);
-			if (iter == examples_.end())
-				return nullptr;
-			return iter->second;
+			weak_ptr<zero_station> station;
+			examples_.find(name, station);
+			return station.lock();
 		}
 
 
@@ -605,7 +657,7 @@ namespace agebull
 		*/
 		void station_warehouse::set_all_destroy()
 		{
-			foreach_configs([](shared_ptr<zero_config>& config)
+			foreach_configs([](const shared_ptr<zero_config>& config)
 			{
 				boost::lock_guard<boost::mutex> guard(config->mutex_);
 				config->runtime_state(station_state::Destroy);
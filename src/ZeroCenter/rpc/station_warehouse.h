@@ -2,6 +2,7 @@
 #ifndef  _AGEBULL_STATION_WAREHOUSE_H_
 #define _AGEBULL_STATION_WAREHOUSE_H_
 #include "zero_config.h"
+#include "../ext/cow_map.h"
 namespace agebull
 {
 	namespace zmq_net
@@ -18,23 +19,24 @@ namespace agebull
 			/**
 			* \brief 全局ID
 			*/
-			static int64 glogal_id_, reboot_num_;
+			static std::atomic<int64> glogal_id_;
 			/**
-			* \brief 实例队列访问锁
+			* \brief 启动次数
 			*/
-			static boost::mutex config_mutex_;
+			static int64 reboot_num_;
 			/**
-			* \brief 实例队列访问锁
+			* \brief 配置写入与主机信息缓存锁(读取配置不需要)
 			*/
-			static boost::mutex examples_mutex_;
+			static boost::mutex config_mutex_;
 			/**
-			* \brief 配置集合
+			* \brief 配置集合(写时复制,读取无锁)
 			*/
-			static map<string, shared_ptr<zero_config>> configs_;
+			static cow_map<string, shared_ptr<zero_config>> configs_;
 			/**
-			* \brief 实例集合
+			* \brief 实例集合(写时复制,读取无锁)
+			* \remark 只保存弱引用,使用前lock,站点在使用期间不会被销毁,快照也不延长站点的生命周期
 			*/
-			static map<string, zero_station*> examples_;
+			static cow_map<string, weak_ptr<zero_station>> examples_;
 		public:
 
 			/**
@@ -52,10 +54,9 @@ namespace agebull
 						redis->set("sys:gid", "1");
 					}
 				}
-				boost::lock_guard<boost::mutex> grard(examples_mutex_);
-				if (glogal_id_ >= 0xFFFFFFFFFFFFF)
-					glogal_id_ = 0;
-				return (reboot_num_) | (++glogal_id_) << 12;
+				//序号只占52位,溢出后回绕
+				const int64 id = (glogal_id_.fetch_add(1, std::memory_order_relaxed) + 1) & 0xFFFFFFFFFFFFFLL;
+				return (reboot_num_) | id << 12;
 			}
 			/**
 			* \brief 清除所有站点
@@ -86,7 +87,7 @@ namespace agebull
 			static size_t get_station_count()
 			{
 				int cnt = 0;
-				for (auto& kv : configs_)
+				for (auto& kv : *configs_.snapshot())
 				{
 					if (kv.second->is_state(station_state::Stop))
 						continue;
@@ -98,16 +99,20 @@ namespace agebull
 			/**
 			* \brief 取得配置
 			*/
-			static shared_ptr<zero_config>& get_config(const string& station_name, bool find_redis = true);
+			static shared_ptr<zero_config> get_config(const string& station_name, bool find_redis = true);
 
 			/**
 			* \brief 加入站点
 			*/
-			static bool join(zero_station* station_name);
+			static bool join(const shared_ptr<zero_station>& station);
 			/**
-			* \brief 加入站点
+			* \brief 退出站点
 			*/
-			static bool left(zero_station* station_name);
+			static bool left(zero_station* station);
+			/**
+			* \brief 唤醒全部运行中的站点(网络状态变化后调用)
+			*/
+			static void wake_all();
 			/**
 			* \brief 设置关闭
 			*/
@@ -116,7 +121,7 @@ namespace agebull
 			/**
 			* \brief 遍历配置
 			*/
-			static void foreach_configs(std::function<void(shared_ptr<zero_config>&)> look);
+			static void foreach_configs(std::function<void(const shared_ptr<zero_config>&)> look);
 
 			/**
 			* \brief 取机器信息
@@ -189,7 +194,11 @@ namespace agebull
 			/**
 			* \brief 查找已运行站点
 			*/
-			static zero_station* instance(const string& name);
+			static shared_ptr<zero_station> instance(const string& name);
+			/**
+			* \brief 为启用合批的站点分配合批端口(已分配时直接返回)
+			*/
+			static bool alloc_batch_port(shared_ptr<zero_config>& config);
 			/**
 			*  \brief 启动站点
 			*/
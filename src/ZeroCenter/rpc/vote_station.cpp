@@ -37,7 +37,7 @@ namespace agebull
 		void vote_station::launch(const shared_ptr<vote_station>& station)
 		{
 			station->config_->log_start();
-			if (!station_warehouse::join(station.get()))
+			if (!station_warehouse::join(station))
 			{
 				station->config_->log_failed();
 				return;
@@ -89,7 +89,7 @@ namespace agebull
 			if (list[2][0] == '@')//计划类型
 			{
 				save_plan(socket, list);
-				send_request_status(socket, *list[0], ZERO_STATUS_PLAN);
+				send_request_status(socket, list[0], ZERO_STATUS_PLAN);
 				return;
 			}
 
@@ -0,0 +1,430 @@
+/**
+ * 内置基准测试
+ */
+#include "../stdafx.h"
+#include "zero_bench.h"
+#include "../ext/frame_pool.h"
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		const char* bench_types_1[] =
+		{
+			"transport", "pool", "status"
+		};
+
+		enum class bench_types_2
+		{
+			transport, pool, status
+		};
+
+		std::atomic<bool> zero_bench::running_(false);
+
+		/**
+		* \brief 开始基准测试
+		*/
+		char zero_bench::start(vector<shared_char>& arguments, string& json)
+		{
+			if (arguments.empty())
+				return ZERO_STATUS_ARG_INVALID_ID;
+			const int count = arguments.size() > 1 ? atoi(*arguments[1]) : 10000;
+			const int size = arguments.size() > 2 ? atoi(*arguments[2]) : 64;
+			if (count <= 0 || count > max_count || size <= 0 || size > 1024 * 1024)
+				return ZERO_STATUS_ARG_INVALID_ID;
+			const int type = strmatchi(*arguments[0], bench_types_1);
+			if (type < 0)
+				return ZERO_STATUS_NOT_SUPPORT_ID;
+			bool idle = false;
+			if (!running_.compare_exchange_strong(idle, true))
+				return ZERO_STATUS_OVERLOAD_ID;
+			boost::thread(boost::bind(run, type, count, size));
+			char buf[128];
+			sprintf(buf, R"({"type":"%s","count":%d,"size":%d})", bench_types_1[type], count, size);
+			json = buf;
+			return ZERO_STATUS_RUNING_ID;
+		}
+
+		/**
+		* \brief 执行基准测试(测试线程)
+		*/
+		void zero_bench::run(int type, int count, int size)
+		{
+			string json;
+			char state;
+			switch (static_cast<bench_types_2>(type))
+			{
+			case bench_types_2::transport:
+				state = transport(count, size, json);
+				break;
+			case bench_types_2::pool:
+				state = pool(count, size, json);
+				break;
+			default:
+				state = status(count, json);
+				break;
+			}
+			if (state != ZERO_STATUS_OK_ID && json.empty())
+				json = R"({"error":"failed"})";
+			if (get_net_state() < NET_STATE_CLOSING)
+				zero_event(zero_net_event::event_bench_result, "bench", bench_types_1[type], json.c_str());
+			running_.store(false);
+		}
+
+		/**
+		* \brief 传输对比:回环TCP与IPC的往返延迟和吞吐
+		*/
+		char zero_bench::transport(int count, int size, string& json)
+		{
+			acl::json result;
+			acl::json_node& root = result.create_node();
+			bool success = true;
+			{
+				ZMQ_HANDLE server = zmq_socket(get_zmq_context(), ZMQ_ROUTER);
+				if (zmq_bind(server, "tcp://127.0.0.1:*") >= 0)
+				{
+					char endpoint[MAX_PATH];
+					size_t len = sizeof(endpoint);
+					zmq_getsockopt(server, ZMQ_LAST_ENDPOINT, endpoint, &len);
+					acl::json_node& node = result.create_node();
+					success = transport(server, endpoint, count, size, node) && success;
+					root.add_child("tcp", node);
+				}
+				else
+				{
+					success = false;
+				}
+				zmq_close(server);
+			}
+			{
+				ZMQ_HANDLE server = zmq_socket(get_zmq_context(), ZMQ_ROUTER);
+				if (socket_ex::bind_ipc(server, "bench", "transport"))
+				{
+					make_ipc_address(endpoint, "bench", "transport");
+					acl::json_node& node = result.create_node();
+					success = transport(server, endpoint, count, size, node) && success;
+					root.add_child("ipc", node);
+					zmq_unbind(server, endpoint);
+				}
+				else
+				{
+					success = false;
+				}
+				zmq_close(server);
+			}
+			json = root.to_string().c_str();
+			return success ? ZERO_STATUS_OK_ID : ZERO_STATUS_FAILED_ID;
+		}
+
+		/**
+		* \brief 帧内存:原分配方式(计数与缓冲两次new加清零),malloc单块与帧内存池的对比
+		*/
+		char zero_bench::pool(int count, int size, string& json)
+		{
+			const int batch = 16;//一条消息的帧数量级
+			const size_t capacity = static_cast<size_t>(size) + 8;
+			vector<void*> ptrs(static_cast<size_t>(count));
+			acl::json result;
+			acl::json_node& root = result.create_node();
+			const auto run = [&](const char* name, std::function<void*()> alloc, std::function<void(void*)> release)
+			{
+				acl::json_node& node = result.create_node();
+				//同一线程分配与释放
+				int64 start = time_us();
+				for (int i = 0; i < count; i += batch)
+				{
+					const int end = i + batch < count ? i + batch : count;
+					for (int j = i; j < end; j++)
+						ptrs[j] = alloc();
+					for (int j = i; j < end; j++)
+						release(ptrs[j]);
+				}
+				int64 elapsed = time_us() - start;
+				node.add_number("local_ns", elapsed * 1000 / count);
+				//分配后由其它线程释放(轮询线程收到后交给计划或监控线程)
+				start = time_us();
+				for (int j = 0; j < count; j++)
+					ptrs[j] = alloc();
+				boost::thread other([&]()
+				{
+					for (int j = 0; j < count; j++)
+						release(ptrs[j]);
+				});
+				other.join();
+				for (int j = 0; j < count; j++)
+					release(alloc());
+				elapsed = time_us() - start;
+				node.add_number("remote_ns", elapsed * 1000 / count);
+				root.add_child(name, node);
+			};
+			run("legacy", [capacity]()
+			{
+				int* cnt = new int(1);
+				char* buffer = new char[capacity];
+				memset(buffer, 0, capacity);
+				*reinterpret_cast<int**>(buffer) = cnt;
+				return static_cast<void*>(buffer);
+			}, [](void* ptr)
+			{
+				char* buffer = static_cast<char*>(ptr);
+				delete *reinterpret_cast<int**>(buffer);
+				delete[] buffer;
+			});
+			run("malloc", [capacity]()
+			{
+				void* ptr = malloc(sizeof(shared_block) + capacity);
+				memset(ptr, 0, sizeof(shared_block) + capacity);
+				return ptr;
+			}, [](void* ptr)
+			{
+				free(ptr);
+			});
+			run("pool", [capacity]()
+			{
+				shared_block* block = frame_pool::alloc(capacity);
+				memset(reinterpret_cast<char*>(block + 1), 0, capacity);
+				return static_cast<void*>(block);
+			}, [](void* ptr)
+			{
+				frame_pool::release(static_cast<shared_block*>(ptr));
+			});
+			const frame_pool_stats stats = frame_pool::get_stats();
+			acl::json_node& node = result.create_node();
+			node.add_number("allocs", stats.allocs);
+			node.add_number("hits", stats.hits);
+			node.add_number("remote_frees", stats.remote_frees);
+			node.add_number("outstanding", stats.outstanding);
+			node.add_number("cached", stats.cached);
+			root.add_child("stats", node);
+			root.add_number("count", count);
+			root.add_number("size", size);
+			json = root.to_string().c_str();
+			return ZERO_STATUS_OK_ID;
+		}
+
+		/**
+		* \brief 原状态回复的发送方式(逐项判断标志,以strlen计算长度),仅用于对比
+		*/
+		static zmq_socket_state legacy_send_status(ZMQ_HANDLE socket, const char* addr, uchar state, const char* global_id, const char* req_id, const char* reqer, const char* msg)
+		{
+			uchar descirpt[8];
+			descirpt[1] = state;
+			int idx = 2;
+			if (reqer != nullptr)
+				descirpt[idx++] = ZERO_FRAME_REQUESTER;
+			if (msg != nullptr)
+				descirpt[idx++] = ZERO_FRAME_STATUS;
+			if (req_id != nullptr)
+				descirpt[idx++] = ZERO_FRAME_REQUEST_ID;
+			if (global_id != nullptr)
+				descirpt[idx++] = ZERO_FRAME_GLOBAL_ID;
+			descirpt[0] = static_cast<char>(idx - 2);
+			descirpt[idx] = ZERO_FRAME_END;
+			int reqer_flags = ZMQ_SNDMORE;
+			int reqId_flags = ZMQ_SNDMORE;
+			int descirpt_flags = ZMQ_SNDMORE;
+			int msg_flags = ZMQ_SNDMORE;
+			if (global_id == nullptr)
+			{
+				if (req_id != nullptr)
+					reqId_flags = ZMQ_DONTWAIT;
+				else if (msg != nullptr)
+					msg_flags = ZMQ_DONTWAIT;
+				else if (reqer != nullptr)
+					reqer_flags = ZMQ_DONTWAIT;
+				else
+					descirpt_flags = ZMQ_DONTWAIT;
+			}
+			if (zmq_send(socket, addr, strlen(addr), ZMQ_SNDMORE) < 0
+				|| zmq_send(socket, descirpt, idx + 1, descirpt_flags) < 0
+				|| (reqer != nullptr && zmq_send(socket, reqer, strlen(reqer), reqer_flags) < 0)
+				|| (msg != nullptr && zmq_send(socket, msg, strlen(msg), msg_flags) < 0)
+				|| (req_id != nullptr && zmq_send(socket, req_id, strlen(req_id), reqId_flags) < 0)
+				|| (global_id != nullptr && zmq_send(socket, global_id, strlen(global_id), ZMQ_DONTWAIT) < 0))
+				return socket_ex::check_zmq_error();
+			return zmq_socket_state::Succeed;
+		}
+
+		/**
+		* \brief 状态回复:原发送方式与预生成说明帧的每秒回复数
+		*/
+		char zero_bench::status(int count, string& json)
+		{
+			acl::json result;
+			acl::json_node& root = result.create_node();
+			const char* identity = "bench_status";
+			const char* reqer = "bench_caller";
+			const char* req_id = "0123456789abcdef";
+			const char* global_id = "1a2b3c4d5e6f7a8b";
+			vector<shared_char> frames;
+			frames.emplace_back(identity);
+			frames.emplace_back(reqer);
+			frames.emplace_back(req_id);
+			frames.emplace_back(global_id);
+			bool success = true;
+			const auto run = [&](const char* name, std::function<zmq_socket_state(ZMQ_HANDLE)> send)
+			{
+				ZMQ_HANDLE server = zmq_socket(get_zmq_context(), ZMQ_ROUTER);
+				ZMQ_HANDLE client = zmq_socket(get_zmq_context(), ZMQ_DEALER);
+				char endpoint[MAX_PATH];
+				sprintf(endpoint, "inproc://bench_status_%s", name);
+				//不限制队列长度,ROUTER达到上限时会静默丢弃
+				socket_ex::setsockopt(server, ZMQ_SNDHWM, 0);
+				socket_ex::setsockopt(client, ZMQ_RCVHWM, 0);
+				socket_ex::setsockopt(server, ZMQ_LINGER, 0);
+				socket_ex::setsockopt(client, ZMQ_LINGER, 0);
+				socket_ex::setsockopt(client, ZMQ_RCVTIMEO, 3000);
+				zmq_setsockopt(client, ZMQ_IDENTITY, identity, strlen(identity));
+				zmq_bind(server, endpoint);
+				zmq_connect(client, endpoint);
+				//ROUTER在收到对方消息后才能按标识路由
+				zmq_send(client, "", 0, 0);
+				zmq_msg_t msg;
+				zmq_msg_init(&msg);
+				zmq_msg_recv(&msg, server, 0);
+				zmq_msg_recv(&msg, server, 0);
+				zmq_msg_close(&msg);
+				int received = 0;
+				boost::thread reader([client, count, &received]()
+				{
+					char buffer[256];
+					while (received < count)
+					{
+						int more = 0;
+						size_t size = sizeof(int);
+						do
+						{
+							if (zmq_recv(client, buffer, sizeof(buffer), 0) < 0)
+								return;
+							zmq_getsockopt(client, ZMQ_RCVMORE, &more, &size);
+						} while (more != 0);
+						++received;
+					}
+				});
+				const int64 start = time_us();
+				for (int i = 0; i < count; i++)
+				{
+					if (send(server) != zmq_socket_state::Succeed)
+						break;
+				}
+				reader.join();
+				const int64 elapsed = time_us() - start;
+				zmq_close(client);
+				zmq_close(server);
+				acl::json_node& node = result.create_node();
+				node.add_number("replies", received);
+				node.add_number("reply_per_sec", elapsed <= 0 ? 0 : static_cast<int64>(received) * 1000000 / elapsed);
+				root.add_child(name, node);
+				success = success && received == count;
+			};
+			run("legacy", [&](ZMQ_HANDLE socket)
+			{
+				return legacy_send_status(socket, identity, ZERO_STATUS_OK_ID, global_id, req_id, reqer, nullptr);
+			});
+			run("prebuilt", [&](ZMQ_HANDLE socket)
+			{
+				return socket_ex::send_status(socket, frames[0], ZERO_STATUS_OK_ID, frames[3], frames[2], frames[1], frame_span());
+			});
+			root.add_number("count", count);
+			json = root.to_string().c_str();
+			return success ? ZERO_STATUS_OK_ID : ZERO_STATUS_FAILED_ID;
+		}
+
+		/**
+		* \brief 测试一个已绑定的地址
+		*/
+		bool zero_bench::transport(ZMQ_HANDLE server, const char* endpoint, int count, int size, acl::json_node& node)
+		{
+			const int warm = 100;
+			const int window = 1000;
+			socket_ex::setsockopt(server, ZMQ_RCVTIMEO, 3000);
+			socket_ex::setsockopt(server, ZMQ_LINGER, 0);
+			//回显线程:原样返回(含路由标识)
+			boost::thread echo([server, warm, count]()
+			{
+				const int total = warm + count * 2;
+				for (int i = 0; i < total; i++)
+				{
+					zmq_msg_t id, msg;
+					zmq_msg_init(&id);
+					zmq_msg_init(&msg);
+					if (zmq_msg_recv(&id, server, 0) < 0 || zmq_msg_recv(&msg, server, 0) < 0)
+					{
+						zmq_msg_close(&id);
+						zmq_msg_close(&msg);
+						return;
+					}
+					zmq_msg_send(&id, server, ZMQ_SNDMORE);
+					zmq_msg_send(&msg, server, 0);
+				}
+			});
+			ZMQ_HANDLE client = zmq_socket(get_zmq_context(), ZMQ_DEALER);
+			socket_ex::setsockopt(client, ZMQ_RCVTIMEO, 3000);
+			socket_ex::setsockopt(client, ZMQ_LINGER, 0);
+			zmq_connect(client, endpoint);
+			vector<char> payload(static_cast<size_t>(size), 'x');
+			vector<char> buffer(static_cast<size_t>(size));
+			bool success = true;
+			//预热,等待连接建立
+			for (int i = 0; i < warm && success; i++)
+			{
+				success = zmq_send(client, payload.data(), payload.size(), 0) >= 0
+					&& zmq_recv(client, buffer.data(), buffer.size(), 0) >= 0;
+			}
+			//往返延迟
+			vector<int64> rtts;
+			rtts.reserve(static_cast<size_t>(count));
+			for (int i = 0; i < count && success; i++)
+			{
+				const int64 start = time_us();
+				success = zmq_send(client, payload.data(), payload.size(), 0) >= 0
+					&& zmq_recv(client, buffer.data(), buffer.size(), 0) >= 0;
+				rtts.push_back(time_us() - start);
+			}
+			//吞吐:限定在途数量的流水线
+			int sent = 0, received = 0;
+			const int64 start = time_us();
+			while (success && received < count)
+			{
+				while (sent < count && sent - received < window)
+				{
+					if (zmq_send(client, payload.data(), payload.size(), 0) < 0)
+					{
+						success = false;
+						break;
+					}
+					++sent;
+				}
+				if (!success || zmq_recv(client, buffer.data(), buffer.size(), 0) < 0)
+				{
+					success = false;
+					break;
+				}
+				++received;
+			}
+			const int64 elapsed = time_us() - start;
+			zmq_disconnect(client, endpoint);
+			zmq_close(client);
+			echo.join();
+
+			node.add_text("endpoint", endpoint);
+			node.add_number("count", count);
+			node.add_number("size", size);
+			if (!success)
+			{
+				node.add_text("error", zmq_strerror(zmq_errno()));
+				return false;
+			}
+			std::sort(rtts.begin(), rtts.end());
+			int64 total = 0;
+			for (auto rtt : rtts)
+				total += rtt;
+			node.add_number("rtt_avg_us", total / static_cast<int64>(rtts.size()));
+			node.add_number("rtt_p50_us", rtts[rtts.size() / 2]);
+			node.add_number("rtt_p99_us", rtts[rtts.size() * 99 / 100]);
+			node.add_number("rtt_p999_us", rtts[rtts.size() * 999 / 1000]);
+			node.add_number("msg_per_sec", elapsed <= 0 ? 0 : static_cast<int64>(count) * 1000000 / elapsed);
+			return true;
+		}
+	}
+}
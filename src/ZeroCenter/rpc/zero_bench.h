@@ -0,0 +1,68 @@
+#pragma once
+#ifndef _ZERO_BENCH_H_
+#define _ZERO_BENCH_H_
+#include "../stdinc.h"
+#include "../ext/shared_char.h"
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		* \brief 内置基准测试(SystemManage的bench命令)
+		* \remark
+		* 在独立线程中执行,命令立即回复已开始,结果以event_bench_result事件发布(主题bench,副题为类型).
+		* 同一时间只执行一个,管理站点的轮询线程不被占用.
+		*/
+		class zero_bench
+		{
+			/**
+			* \brief 是否有正在执行的测试
+			*/
+			static std::atomic<bool> running_;
+		public:
+			/**
+			* \brief 次数的上限
+			*/
+			static const int max_count = 100000;
+
+			/**
+			* \brief 开始基准测试
+			* \param arguments [类型] [次数] [消息大小]
+			* \param json 回复(测试的参数)
+			*/
+			static char start(vector<shared_char>& arguments, string& json);
+		private:
+			/**
+			* \brief 执行基准测试(测试线程)
+			*/
+			static void run(int type, int count, int size);
+
+			/**
+			* \brief 传输对比:回环TCP与IPC的往返延迟和吞吐
+			*/
+			static char transport(int count, int size, string& json);
+
+			/**
+			* \brief 帧内存:原分配方式,malloc单块与帧内存池的对比
+			*/
+			static char pool(int count, int size, string& json);
+
+			/**
+			* \brief 状态回复:原发送方式与预生成说明帧的每秒回复数
+			*/
+			static char status(int count, string& json);
+
+			/**
+			* \brief 测试一个已绑定的地址
+			* \param server 服务端(ROUTER,已绑定)
+			* \param endpoint 连接地址
+			* \param count 次数
+			* \param size 消息大小
+			* \param node 结果节点
+			*/
+			static bool transport(ZMQ_HANDLE server, const char* endpoint, int count, int size, acl::json_node& node);
+		};
+	}
+}
+#endif //!_ZERO_BENCH_H_
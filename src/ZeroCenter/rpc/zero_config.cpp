@@ -1,6 +1,7 @@
 #include "../stdinc.h"
 #include "zero_config.h"
 #include "../cfg/json_config.h"
+#include "../ext/frame_pool.h"
 
 namespace agebull
 {
@@ -134,6 +135,7 @@ namespace agebull
 			, "request_port"
 			, "worker_out_port"
 			, "worker_in_port"
+			, "batch_port"
 			, "description"
 			, "caption"
 			, "station_alias"
@@ -146,6 +148,26 @@ namespace agebull
 			, "worker_err"
 			, "short_name"
 			,"is_base"
+			, "use_ipc"
+			, "use_shm"
+			, "pub_cache_size"
+			, "pub_replay_size"
+			, "pub_cache_bytes"
+			, "pub_batch_linger"
+			, "pub_batch_size"
+			, "reactor"
+			, "quota_rate"
+			, "quota_burst"
+			, "admit_max_inflight"
+			, "admit_min_inflight"
+			, "admit_adaptive"
+			, "breaker"
+			, "breaker_error_rate"
+			, "breaker_min_requests"
+			, "breaker_window"
+			, "breaker_open_time"
+			, "breaker_probes"
+			, "single_flight"
 		};
 		enum class config_fields
 		{
@@ -154,6 +176,7 @@ namespace agebull
 			, request_port
 			, worker_out_port
 			, worker_in_port
+			, batch_port
 			, description
 			, caption
 			, station_alias
@@ -166,6 +189,26 @@ namespace agebull
 			, worker_err
 			, short_name
 			, is_base
+			, use_ipc
+			, use_shm
+			, pub_cache_size
+			, pub_replay_size
+			, pub_cache_bytes
+			, pub_batch_linger
+			, pub_batch_size
+			, reactor
+			, quota_rate
+			, quota_burst
+			, admit_max_inflight
+			, admit_min_inflight
+			, admit_adaptive
+			, breaker
+			, breaker_error_rate
+			, breaker_min_requests
+			, breaker_window
+			, breaker_open_time
+			, breaker_probes
+			, single_flight
 		};
 		void zero_config::read_json(const char* val)
 		{
@@ -226,6 +269,80 @@ namespace agebull
 				case config_fields::worker_in_port:
 					worker_in_port_ = json_read_int(iter);
 					break;
+				case config_fields::batch_port:
+					batch_port_ = json_read_int(iter);
+					break;
+				case config_fields::use_ipc:
+					use_ipc_ = json_read_int(iter);
+					break;
+				case config_fields::use_shm:
+					use_shm_ = json_read_int(iter);
+					break;
+				case config_fields::reactor:
+					reactor_ = json_read_int(iter);
+					break;
+				case config_fields::pub_cache_size:
+					pub_cache_size_ = json_read_int(iter);
+					break;
+				case config_fields::pub_replay_size:
+					pub_replay_size_ = json_read_int(iter);
+					break;
+				case config_fields::pub_cache_bytes:
+					pub_cache_bytes_ = json_read_int(iter);
+					break;
+				case config_fields::pub_batch_linger:
+					pub_batch_linger_ = json_read_int(iter);
+					break;
+				case config_fields::pub_batch_size:
+					pub_batch_size_ = json_read_int(iter);
+					break;
+				case config_fields::quota_rate:
+					quota_rate_ = json_read_int(iter);
+					break;
+				case config_fields::quota_burst:
+					quota_burst_ = json_read_int(iter);
+					break;
+				case config_fields::admit_max_inflight:
+					admit_max_inflight_ = json_read_int(iter);
+					break;
+				case config_fields::admit_min_inflight:
+					admit_min_inflight_ = json_read_int(iter);
+					break;
+				case config_fields::admit_adaptive:
+					admit_adaptive_ = json_read_int(iter);
+					break;
+				case config_fields::breaker:
+					breaker_ = json_read_int(iter);
+					break;
+				case config_fields::breaker_error_rate:
+					breaker_error_rate_ = json_read_int(iter);
+					break;
+				case config_fields::breaker_min_requests:
+					breaker_min_requests_ = json_read_int(iter);
+					break;
+				case config_fields::breaker_window:
+					breaker_window_ = json_read_int(iter);
+					break;
+				case config_fields::breaker_open_time:
+					breaker_open_time_ = json_read_int(iter);
+					break;
+				case config_fields::breaker_probes:
+					breaker_probes_ = json_read_int(iter);
+					break;
+				case config_fields::single_flight:
+					single_flight_.clear();
+					{
+						var ch = iter->first_child();
+						var iter_arr = ch->first_child();
+						while (iter_arr)
+						{
+							auto txt = iter_arr->get_text();
+							if (txt != nullptr)
+								single_flight_.emplace_back(txt);
+							iter_arr = ch->next_child();
+						}
+					}
+					break;
 				case config_fields::station_state:
 					station_state_ = static_cast<station_state>(json_read_num(iter));
 					break;
@@ -254,6 +371,233 @@ namespace agebull
 			check_type_name();
 		}
 
+		std::atomic<int64> zero_config::restart_count(0);
+		std::atomic<int64> zero_config::restart_max(0);
+
+		const char* zero_config::counter_names[counter_count] =
+		{
+			"request_in", "request_out", "request_err", "worker_in", "worker_out", "worker_err"
+		};
+
+		/**
+		* \brief д1,10,60봰ڵ(/)
+		*/
+		void zero_config::add_rates(acl::json& json, acl::json_node& node, const int64(&values)[counter_count], int64 now)
+		{
+			acl::json_node& rates = json.create_node();
+			for (size_t idx = 0; idx < counter_count; idx++)
+			{
+				acl::json_node& rate = json.create_node();
+				rate.add_double("1s", rates_.rate(now, values, idx, 1000));
+				rate.add_double("10s", rates_.rate(now, values, idx, 10000));
+				rate.add_double("60s", rates_.rate(now, values, idx, 60000));
+				rates.add_child(counter_names[idx], rate);
+			}
+			node.add_child("rates", rates);
+		}
+
+		/**
+		* \brief дһʱķλ(΢)
+		*/
+		void zero_config::add_latency(acl::json& json, acl::json_node& node, const char* name, const latency_set& set)
+		{
+			const latency_histogram* histograms[3] = { &set.queue, &set.worker, &set.total };
+			const char* names[3] = { "queue", "worker", "total" };
+			acl::json_node& stages = json.create_node();
+			for (size_t idx = 0; idx < 3; idx++)
+			{
+				const latency_summary summary = histograms[idx]->summary();
+				acl::json_node& stage = json.create_node();
+				stage.add_number("count", summary.count);
+				stage.add_number("p50", summary.p50);
+				stage.add_number("p99", summary.p99);
+				stage.add_number("p999", summary.p999);
+				stage.add_number("max", summary.max);
+				stages.add_child(names[idx], stage);
+			}
+			node.add_child(name, stages);
+		}
+
+		/**
+		* \brief ȡʱͳ,ʱ½(޻δʱؿ)
+		*/
+		shared_ptr<latency_set> zero_config::get_command_latency(const char* command, size_t len)
+		{
+			shared_ptr<latency_set> set;
+			if (command == nullptr || len == 0 || json_config::latency_commands <= 0)
+				return set;
+			const string name(command, len);
+			if (command_latency.find(name, set))
+				return set;
+			if (command_latency.size() >= static_cast<size_t>(json_config::latency_commands))
+				return set;
+			command_latency.update([&name, &set](map<string, shared_ptr<latency_set>>& commands)
+			{
+				auto& item = commands[name];
+				if (!item)
+					item = make_shared<latency_set>();
+				set = item;
+				return true;
+			});
+			return set;
+		}
+
+		/**
+		* \brief дվʱλJSON
+		*/
+		acl::string zero_config::to_latency_json()
+		{
+			acl::json json;
+			acl::json_node& node = json.create_node();
+			json_add_str(node, "name", station_name_);
+			add_latency(json, node, "latency", latency);
+			acl::json_node& commands = json.create_node();
+			for (auto& command : *command_latency.snapshot())
+			{
+				add_latency(json, commands, command.first.c_str(), *command.second);
+			}
+			node.add_child("commands", commands);
+			return node.to_string();
+		}
+
+		/**
+		* \brief ȡõߵܾ,ʱ½(ʱؿ)
+		*/
+		shared_ptr<std::atomic<int64>> zero_config::get_quota_rejects(const string& caller)
+		{
+			shared_ptr<std::atomic<int64>> count;
+			if (quota_rejects.find(caller, count))
+				return count;
+			if (quota_rejects.size() >= static_cast<size_t>(std::max(json_config::quota_callers, 0)))
+				return count;
+			quota_rejects.update([&caller, &count](map<string, shared_ptr<std::atomic<int64>>>& rejects)
+			{
+				auto& item = rejects[caller];
+				if (!item)
+					item = make_shared<std::atomic<int64>>(0);
+				count = item;
+				return true;
+			});
+			return count;
+		}
+
+		/**
+		* \brief д밴ߵľܾJSON
+		*/
+		acl::string zero_config::to_quota_json()
+		{
+			acl::json json;
+			acl::json_node& node = json.create_node();
+			json_add_str(node, "name", station_name_);
+			node.add_number("rate", get_quota_rate());
+			node.add_number("burst", get_quota_burst());
+			node.add_number("rejected", request_quota.load());
+			acl::json_node& callers = json.create_node();
+			for (auto& caller : *quota_rejects.snapshot())
+			{
+				callers.add_number(caller.first.c_str(), caller.second->load());
+			}
+			node.add_child("callers", callers);
+			return node.to_string();
+		}
+
+		/**
+		* \brief дϴηȵ״̬JSON
+		*/
+		acl::string zero_config::to_delta_json(station_status& last, bool full)
+		{
+			acl::string result;
+			{
+				boost::lock_guard<boost::mutex> guard(mutex_);
+				string works;
+				for (auto& worker : workers)
+				{
+					works.append(worker.second.real_name);
+					works.append(1, ':');
+					works.append(std::to_string(worker.second.level));
+					works.append(1, ':');
+					works.append(std::to_string(worker.second.state));
+					works.append(1, ';');
+				}
+				const bool first = !last.has_value;
+				int64 counts[counter_count];
+				load_counters(counts);
+				//ÿڶ,ʲܸĴ
+				const int64 now = counter_rates<counter_count>::now();
+				rates_.add_sample(now, counts);
+				acl::json rates_json;
+				acl::json_node& rates_node = rates_json.create_node();
+				add_rates(rates_json, rates_node, counts, now);
+				string rates = rates_node.to_string().c_str();
+				acl::json latency_json;
+				acl::json_node& latency_node = latency_json.create_node();
+				add_latency(latency_json, latency_node, "latency", latency);
+				string latency_str = latency_node.to_string().c_str();
+				if (!full && !first)
+				{
+					acl::json json;
+					acl::json_node& node = json.create_node();
+					bool changed = false;
+					//0ֵ,ʹjson_add_num
+#define delta_num(key, field, value) if (last.field != (value)) { node.add_number(key, static_cast<int64>(value)); changed = true; }
+					delta_num("station_state", state, station_state_);
+					delta_num("request_in", request_in, counts[0]);
+					delta_num("request_out", request_out, counts[1]);
+					delta_num("request_err", request_err, counts[2]);
+					delta_num("worker_in", worker_in, counts[3]);
+					delta_num("worker_out", worker_out, counts[4]);
+					delta_num("worker_err", worker_err, counts[5]);
+#undef delta_num
+					//ʽΪ0Ҫٷһ
+					if (last.rates != rates)
+					{
+						add_rates(json, node, counts, now);
+						changed = true;
+					}
+					if (last.latency != latency_str)
+					{
+						add_latency(json, node, "latency", latency);
+						changed = true;
+					}
+					if (last.workers != works)
+					{
+						acl::json_node& array = json.create_array();
+						for (auto& worker : workers)
+						{
+							acl::json_node& work = json.create_node();
+							json_add_num(work, "level", worker.second.level);
+							json_add_num(work, "state", worker.second.state);
+							json_add_num(work, "pre_time", worker.second.pre_time);
+							json_add_str(work, "real_name", worker.second.real_name);
+							json_add_str(work, "ip_address", worker.second.ip_address);
+							array.add_child(work);
+						}
+						node.add_child("workers", array);
+						changed = true;
+					}
+					if (changed)
+					{
+						json_add_str(node, "name", station_name_);
+						result = node.to_string();
+					}
+				}
+				last.has_value = true;
+				last.state = station_state_;
+				last.request_in = counts[0];
+				last.request_out = counts[1];
+				last.request_err = counts[2];
+				last.worker_in = counts[3];
+				last.worker_out = counts[4];
+				last.worker_err = counts[5];
+				last.workers.swap(works);
+				last.rates.swap(rates);
+				last.latency.swap(latency_str);
+				if (!full && !first)
+					return result;
+			}
+			return to_json(2);
+		}
+
 		/**
 		* \brief дJSON
 		* \param type ¼ 0 ȫ 1 ̬Ϣ 2 Ϣ
@@ -275,6 +619,26 @@ namespace agebull
 				json_add_num(node, "request_port", request_port_);
 				json_add_num(node, "worker_in_port", worker_in_port_);
 				json_add_num(node, "worker_out_port", worker_out_port_);
+				json_add_num(node, "batch_port", batch_port_);
+				json_add_num(node, "use_ipc", use_ipc_);
+				json_add_num(node, "use_shm", use_shm_);
+				json_add_num(node, "reactor", reactor_);
+				json_add_num(node, "pub_cache_size", pub_cache_size_);
+				json_add_num(node, "pub_replay_size", pub_replay_size_);
+				json_add_num(node, "pub_cache_bytes", pub_cache_bytes_);
+				json_add_num(node, "pub_batch_linger", pub_batch_linger_);
+				json_add_num(node, "pub_batch_size", pub_batch_size_);
+				json_add_num(node, "quota_rate", quota_rate_);
+				json_add_num(node, "quota_burst", quota_burst_);
+				json_add_num(node, "admit_max_inflight", admit_max_inflight_);
+				json_add_num(node, "admit_min_inflight", admit_min_inflight_);
+				json_add_num(node, "admit_adaptive", admit_adaptive_);
+				json_add_num(node, "breaker", breaker_);
+				json_add_num(node, "breaker_error_rate", breaker_error_rate_);
+				json_add_num(node, "breaker_min_requests", breaker_min_requests_);
+				json_add_num(node, "breaker_window", breaker_window_);
+				json_add_num(node, "breaker_open_time", breaker_open_time_);
+				json_add_num(node, "breaker_probes", breaker_probes_);
 				if (alias_.size() > 0)
 				{
 					acl::json_node& array = json.create_array();
@@ -284,16 +648,33 @@ namespace agebull
 					}
 					node.add_child("station_alias", array);
 				}
+				if (single_flight_.size() > 0)
+				{
+					acl::json_node& array = json.create_array();
+					for (auto command : single_flight_)
+					{
+						json_add_array_str(array, command);
+					}
+					node.add_child("single_flight", array);
+				}
 			}
 			//վ,ڻϢ
+			int64 counts[counter_count];
+			load_counters(counts);
 			if (type != 1)
 			{
-				json_add_num(node, "request_in", request_in);
-				json_add_num(node, "request_out", request_out);
-				json_add_num(node, "request_err", request_err);
-				json_add_num(node, "worker_in", worker_in);
-				json_add_num(node, "worker_out", worker_out);
-				json_add_num(node, "worker_err", worker_err);
+				for (size_t idx = 0; idx < counter_count; idx++)
+				{
+					json_add_num(node, counter_names[idx], counts[idx]);
+				}
+			}
+			//,״̬
+			if (type == 2)
+			{
+				const int64 now = counter_rates<counter_count>::now();
+				rates_.add_sample(now, counts);
+				add_rates(json, node, counts, now);
+				add_latency(json, node, "latency", latency);
 			}
 			//ĹվϢ,״̬
 			if (type >= 2 && workers.size() > 0)
@@ -311,6 +692,22 @@ namespace agebull
 				}
 				node.add_child("workers", array);
 			}
+			//֡ڴ:ֻƱվ(ۼ),Ϊѯ߳(ӦʱΪӦ)Ļ,״̬
+			if (type == 2)
+			{
+				const int64_t allocs = pool_counters.allocs.load(std::memory_order_relaxed);
+				const int64_t hits = pool_counters.hits.load(std::memory_order_relaxed);
+				const frame_pool_stats stats = frame_pool::get_stats(poll_thread_.c_str());
+				acl::json_node& pool = json.create_node();
+				pool.add_number("allocs", allocs);
+				pool.add_number("hits", hits);
+				pool.add_number("hit_rate", allocs == 0 ? 0 : hits * 100 / allocs);
+				json_add_str(pool, "thread", poll_thread_);
+				pool.add_number("remote_frees", stats.remote_frees);
+				pool.add_number("outstanding", stats.outstanding);
+				pool.add_number("cached", stats.cached);
+				node.add_child("pool", pool);
+			}
 
 			return node.to_string();
 		}
@@ -5,6 +5,11 @@
 #include "zero_net.h"
 #include <utility>
 #include "../log/mylogger.h"
+#include "../cfg/json_config.h"
+#include "../ext/sharded_counter.h"
+#include "../ext/latency_histogram.h"
+#include "../ext/cow_map.h"
+#include "../ext/frame_pool.h"
 
 #include<boost/unordered_map.hpp>
 namespace agebull
@@ -64,6 +69,52 @@ namespace agebull
 			int check();
 		};
 
+		/**
+		* \brief 最近一次发布的站点状态(用于计算增量)
+		*/
+		struct station_status
+		{
+			/**
+			* \brief 是否已有快照
+			*/
+			bool has_value;
+			/**
+			* \brief 站点状态
+			*/
+			station_state state;
+			/**
+			* \brief 计数
+			*/
+			int64 request_in, request_out, request_err, worker_in, worker_out, worker_err;
+			/**
+			* \brief 工作站特征(名称,等级,状态),不含心跳时间
+			*/
+			string workers;
+			/**
+			* \brief 速率
+			*/
+			string rates;
+			/**
+			* \brief 延时分位数
+			*/
+			string latency;
+
+			/**
+			* \brief 构造
+			*/
+			station_status()
+				: has_value(false)
+				, state(station_state::None)
+				, request_in(0)
+				, request_out(0)
+				, request_err(0)
+				, worker_in(0)
+				, worker_out(0)
+				, worker_err(0)
+			{
+			}
+		};
+
 		class zero_station;
 		/**
 		* \brief ZMQ的网络站点配置
@@ -83,6 +134,18 @@ namespace agebull
 			* \brief 当前站点状态
 			*/
 			station_state station_state_;
+			/**
+			* \brief 状态变化的通知锁
+			*/
+			boost::mutex state_mutex_;
+			/**
+			* \brief 状态变化的通知
+			*/
+			boost::condition_variable state_cond_;
+			/**
+			* \brief 开始重启的时间(微秒,0 表示未在重启)
+			*/
+			int64 restart_time_;
 		public:
 			/**
 			* \brief 是否基础站点
@@ -112,6 +175,10 @@ namespace agebull
 			* \brief 站点别名
 			*/
 			vector<string> alias_;
+			/**
+			* \brief 合并相同请求的幂等命令("*" 表示全部,仅API站点)
+			*/
+			vector<string> single_flight_;
 
 			/**
 			* \brief 站点类型
@@ -134,13 +201,190 @@ namespace agebull
 			int worker_in_port_;
 
 			/**
-			* \brief 总请求次数
+			* \brief 广播合批的出站端口(仅启用合批的广播站点,首次启用时分配)
+			*/
+			int batch_port_;
+
+			/**
+			* \brief 是否同时绑定本机IPC地址(0 使用全局配置,大于0 启用,小于0 不启用)
+			*/
+			int use_ipc_;
+
+			/**
+			* \brief 是否启用共享内存环与本机工作者通讯(仅API站点,0 使用全局配置,大于0 启用,小于0 不启用)
+			*/
+			int use_shm_;
+
+			/**
+			* \brief 是否由共享的反应器线程轮询(仅业务站点,0 使用全局配置,大于0 共享,小于0 独占线程)
+			*/
+			int reactor_;
+
+			/**
+			* \brief 广播最后值缓存的主题数量(0 使用全局配置,小于0 不缓存)
+			*/
+			int pub_cache_size_;
+
+			/**
+			* \brief 广播重放环的消息数量(0 使用全局配置,小于0 不缓存)
+			*/
+			int pub_replay_size_;
+
+			/**
+			* \brief 广播缓存的字节上限(0 使用全局配置,小于0 不限制)
+			*/
+			int pub_cache_bytes_;
+
+			/**
+			* \brief 广播合批的停留时间(微秒,0 使用全局配置,小于0 不合批)
+			*/
+			int pub_batch_linger_;
+
+			/**
+			* \brief 广播合批的记录数量阈值(0 使用全局配置,小于0 只按停留时间)
+			*/
+			int pub_batch_size_;
+
+			/**
+			* \brief 每个调用者每秒的请求数(仅API类站点,0 使用全局配置,小于0 不限流)
+			*/
+			int quota_rate_;
+
+			/**
+			* \brief 每个调用者允许的突发数量(0 使用全局配置)
+			*/
+			int quota_burst_;
+
+			/**
+			* \brief 未返回请求数量的上限(仅API类站点,0 使用全局配置,小于0 不限制)
+			*/
+			int admit_max_inflight_;
+
+			/**
+			* \brief 自适应准入时上限的最小值(0 使用全局配置)
+			*/
+			int admit_min_inflight_;
+
+			/**
+			* \brief 是否自适应准入(0 使用全局配置,大于0 启用,小于0 不启用)
+			*/
+			int admit_adaptive_;
+
+			/**
+			* \brief 是否启用断路器(仅API类站点,0 使用全局配置,大于0 启用,小于0 不启用)
+			*/
+			int breaker_;
+
+			/**
+			* \brief 断路器断开的失败比例(百分比,0 使用全局配置,小于0 只按工作者断开)
+			*/
+			int breaker_error_rate_;
+
+			/**
+			* \brief 断路器按失败比例断开所需的最少请求数(0 使用全局配置)
+			*/
+			int breaker_min_requests_;
+
+			/**
+			* \brief 断路器的观察窗口(毫秒,0 使用全局配置)
+			*/
+			int breaker_window_;
+
+			/**
+			* \brief 断路器的断开时间(毫秒,0 使用全局配置)
+			*/
+			int breaker_open_time_;
+
+			/**
+			* \brief 断路器半开时的探测数量(0 使用全局配置)
+			*/
+			int breaker_probes_;
+
+			/**
+			* \brief 总请求次数(多线程累加,按线程分片)
+			*/
+			sharded_counter request_in, request_out, request_err;
+			/**
+			* \brief 总返回次数(多线程累加,按线程分片)
+			*/
+			sharded_counter worker_in, worker_out, worker_err;
+			/**
+			* \brief 计数的数量
+			*/
+			static const size_t counter_count = 6;
+			/**
+			* \brief 计数的名称(与load_counters的顺序一致)
+			*/
+			static const char* counter_names[counter_count];
+
+			/**
+			* \brief 站点重启的次数
+			*/
+			static std::atomic<int64> restart_count;
+			/**
+			* \brief 站点重启的最长用时(微秒,从轮询结束到再次运行)
+			*/
+			static std::atomic<int64> restart_max;
+
+			/**
+			* \brief 请求各阶段的延时
+			*/
+			latency_set latency;
+
+			/**
+			* \brief 按命令(ZERO_FRAME_COMMAND)统计的延时,数量上限为json_config::latency_commands
+			*/
+			cow_map<string, shared_ptr<latency_set>> command_latency;
+
+			/**
+			* \brief 已发往工作者尚未返回的请求数量(由站点轮询线程更新)
 			*/
-			int64 request_in, request_out, request_err;
+			std::atomic<int64> queue_depth;
+
+			/**
+			* \brief 准入控制拒绝的请求数量(由站点轮询线程更新)
+			*/
+			std::atomic<int64> request_shed;
+
+			/**
+			* \brief 超过调用者配额被拒绝的请求数量(由站点轮询线程更新)
+			*/
+			std::atomic<int64> request_quota;
+
+			/**
+			* \brief 按调用者统计的配额拒绝次数,数量上限为json_config::quota_callers
+			*/
+			cow_map<string, shared_ptr<std::atomic<int64>>> quota_rejects;
+
 			/**
-			* \brief 总返回次数
+			* \brief 准入控制的当前上限(0 未启用,由站点轮询线程更新)
 			*/
-			int64 worker_in, worker_out, worker_err;
+			std::atomic<int64> admit_limit;
+
+			/**
+			* \brief 断路器断开时直接拒绝的请求数量(由站点轮询线程更新)
+			*/
+			std::atomic<int64> request_broken;
+
+			/**
+			* \brief 合并到相同请求而未发往工作者的请求数量(由站点轮询线程更新)
+			*/
+			std::atomic<int64> request_coalesced;
+
+			/**
+			* \brief 断路器状态(breaker_state,由站点轮询线程更新)
+			*/
+			std::atomic<int> breaker_state;
+
+			/**
+			* \brief 站点轮询时的帧内存分配计数(共享轮询时也只计本站点)
+			*/
+			frame_pool_counters pool_counters;
+
+			/**
+			* \brief 轮询本站点的线程名称(站点名称或反应器名称,在mutex_中访问)
+			*/
+			string poll_thread_;
 
 			map<string, worker> workers;
 
@@ -151,17 +395,39 @@ namespace agebull
 				: ready_works_(0)
 				, type_name_("ERR")
 				, station_state_(station_state::None)
+				, restart_time_(0)
 				, is_base(false)
 				, station_type_(0)
 				, request_port_(0)
 				, worker_out_port_(0)
 				, worker_in_port_(0)
-				, request_in(0)
-				, request_out(0)
-				, request_err(0)
-				, worker_in(0)
-				, worker_out(0)
-				, worker_err(0)
+				, batch_port_(0)
+				, use_ipc_(0)
+				, use_shm_(0)
+				, reactor_(0)
+				, pub_cache_size_(0)
+				, pub_replay_size_(0)
+				, pub_cache_bytes_(0)
+				, pub_batch_linger_(0)
+				, pub_batch_size_(0)
+				, quota_rate_(0)
+				, quota_burst_(0)
+				, admit_max_inflight_(0)
+				, admit_min_inflight_(0)
+				, admit_adaptive_(0)
+				, breaker_(0)
+				, breaker_error_rate_(0)
+				, breaker_min_requests_(0)
+				, breaker_window_(0)
+				, breaker_open_time_(0)
+				, breaker_probes_(0)
+				, queue_depth(0)
+				, request_shed(0)
+				, request_quota(0)
+				, admit_limit(0)
+				, request_broken(0)
+				, request_coalesced(0)
+				, breaker_state(0)
 			{
 			}
 
@@ -173,18 +439,40 @@ namespace agebull
 			zero_config(const string& name, int type)
 				: ready_works_(0)
 				, station_state_(station_state::None)
+				, restart_time_(0)
 				, is_base(false)
 				, station_name_(std::move(name))
 				, station_type_(type)
 				, request_port_(0)
 				, worker_out_port_(0)
 				, worker_in_port_(0)
-				, request_in(0)
-				, request_out(0)
-				, request_err(0)
-				, worker_in(0)
-				, worker_out(0)
-				, worker_err(0)
+				, batch_port_(0)
+				, use_ipc_(0)
+				, use_shm_(0)
+				, reactor_(0)
+				, pub_cache_size_(0)
+				, pub_replay_size_(0)
+				, pub_cache_bytes_(0)
+				, pub_batch_linger_(0)
+				, pub_batch_size_(0)
+				, quota_rate_(0)
+				, quota_burst_(0)
+				, admit_max_inflight_(0)
+				, admit_min_inflight_(0)
+				, admit_adaptive_(0)
+				, breaker_(0)
+				, breaker_error_rate_(0)
+				, breaker_min_requests_(0)
+				, breaker_window_(0)
+				, breaker_open_time_(0)
+				, breaker_probes_(0)
+				, queue_depth(0)
+				, request_shed(0)
+				, request_quota(0)
+				, admit_limit(0)
+				, request_broken(0)
+				, request_coalesced(0)
+				, breaker_state(0)
 			{
 				check_type_name();
 			}
@@ -225,6 +513,14 @@ namespace agebull
 				return station_type_ <= STATION_TYPE_PUBLISH || station_type_ > STATION_TYPE_SPECIAL || ready_works_ > 0;
 			}
 
+			/**
+			* \brief 已就绪的工作站数量(不加锁读取,可能略有滞后)
+			*/
+			int get_ready_works() const
+			{
+				return ready_works_;
+			}
+
 			/**
 			* \brief 站点名称
 			*/
@@ -249,6 +545,171 @@ namespace agebull
 				return station_name_;
 			}
 
+			/**
+			* \brief 是否同时绑定本机IPC地址
+			*/
+			bool is_use_ipc() const
+			{
+				return use_ipc_ != 0 ? use_ipc_ > 0 : json_config::use_ipc_protocol;
+			}
+
+			/**
+			* \brief 是否启用共享内存环
+			*/
+			bool is_use_shm() const
+			{
+				return use_shm_ != 0 ? use_shm_ > 0 : json_config::use_shm_ring;
+			}
+
+			/**
+			* \brief 是否由共享的反应器线程轮询
+			*/
+			bool is_use_reactor() const
+			{
+				if (station_type_ != STATION_TYPE_API && station_type_ != STATION_TYPE_ROUTE_API && station_type_ != STATION_TYPE_PUBLISH)
+					return false;
+				return reactor_ != 0 ? reactor_ > 0 : json_config::use_reactor;
+			}
+
+			/**
+			* \brief 广播最后值缓存的主题数量
+			*/
+			int get_pub_cache_size() const
+			{
+				return pub_cache_size_ != 0 ? pub_cache_size_ : json_config::pub_cache_size;
+			}
+
+			/**
+			* \brief 广播重放环的消息数量
+			*/
+			int get_pub_replay_size() const
+			{
+				return pub_replay_size_ != 0 ? pub_replay_size_ : json_config::pub_replay_size;
+			}
+
+			/**
+			* \brief 广播缓存的字节上限
+			*/
+			int get_pub_cache_bytes() const
+			{
+				return pub_cache_bytes_ != 0 ? pub_cache_bytes_ : json_config::pub_cache_bytes;
+			}
+
+			/**
+			* \brief 广播合批的停留时间(微秒)
+			*/
+			int get_pub_batch_linger() const
+			{
+				return pub_batch_linger_ != 0 ? pub_batch_linger_ : json_config::pub_batch_linger;
+			}
+
+			/**
+			* \brief 广播合批的记录数量阈值
+			*/
+			int get_pub_batch_size() const
+			{
+				return pub_batch_size_ != 0 ? pub_batch_size_ : json_config::pub_batch_size;
+			}
+
+			/**
+			* \brief 每个调用者每秒的请求数(0 不限流)
+			*/
+			int get_quota_rate() const
+			{
+				const int rate = quota_rate_ != 0 ? quota_rate_ : json_config::quota_rate;
+				return rate > 0 ? rate : 0;
+			}
+
+			/**
+			* \brief 每个调用者允许的突发数量
+			*/
+			int get_quota_burst() const
+			{
+				return quota_burst_ != 0 ? quota_burst_ : json_config::quota_burst;
+			}
+
+			/**
+			* \brief 未返回请求数量的上限(0 不限制)
+			*/
+			int get_admit_max_inflight() const
+			{
+				const int max = admit_max_inflight_ != 0 ? admit_max_inflight_ : json_config::admit_max_inflight;
+				return max > 0 ? max : 0;
+			}
+
+			/**
+			* \brief 自适应准入时上限的最小值
+			*/
+			int get_admit_min_inflight() const
+			{
+				return admit_min_inflight_ != 0 ? admit_min_inflight_ : json_config::admit_min_inflight;
+			}
+
+			/**
+			* \brief 是否自适应准入
+			*/
+			bool is_admit_adaptive() const
+			{
+				return admit_adaptive_ != 0 ? admit_adaptive_ > 0 : json_config::admit_adaptive;
+			}
+
+			/**
+			* \brief 是否启用断路器
+			*/
+			bool is_breaker() const
+			{
+				return breaker_ != 0 ? breaker_ > 0 : json_config::breaker;
+			}
+
+			/**
+			* \brief 断路器断开的失败比例(0 只按工作者断开)
+			*/
+			int get_breaker_error_rate() const
+			{
+				const int rate = breaker_error_rate_ != 0 ? breaker_error_rate_ : json_config::breaker_error_rate;
+				return rate > 0 ? rate : 0;
+			}
+
+			/**
+			* \brief 断路器按失败比例断开所需的最少请求数
+			*/
+			int get_breaker_min_requests() const
+			{
+				return breaker_min_requests_ != 0 ? breaker_min_requests_ : json_config::breaker_min_requests;
+			}
+
+			/**
+			* \brief 断路器的观察窗口(毫秒)
+			*/
+			int get_breaker_window() const
+			{
+				return breaker_window_ != 0 ? breaker_window_ : json_config::breaker_window;
+			}
+
+			/**
+			* \brief 断路器的断开时间(毫秒)
+			*/
+			int get_breaker_open_time() const
+			{
+				return breaker_open_time_ != 0 ? breaker_open_time_ : json_config::breaker_open_time;
+			}
+
+			/**
+			* \brief 断路器半开时的探测数量
+			*/
+			int get_breaker_probes() const
+			{
+				return breaker_probes_ != 0 ? breaker_probes_ : json_config::breaker_probes;
+			}
+
+			/**
+			* \brief 合并相同请求的幂等命令
+			*/
+			const vector<string>& get_single_flight() const
+			{
+				return single_flight_;
+			}
+
 			/**
 			* \brief 调用地址
 			*/
@@ -269,6 +730,16 @@ namespace agebull
 				return addr;
 			}
 
+			/**
+			* \brief 广播合批地址
+			*/
+			string get_batch_address() const
+			{
+				string addr("tcp://*:");
+				addr += std::to_string(batch_port_);
+				return addr;
+			}
+
 			/**
 			* \brief 工作地址
 			*/
@@ -332,14 +803,46 @@ namespace agebull
 			{
 				return station_state_;
 			}
+			/**
+			* \brief 设置轮询本站点的线程名称
+			*/
+			void set_poll_thread(const string& name)
+			{
+				boost::lock_guard<boost::mutex> guard(mutex_);
+				poll_thread_ = name;
+			}
 			void set_state(station_state state)
 			{
+				boost::lock_guard<boost::mutex> guard(state_mutex_);
 				station_state_ = state;
+				state_cond_.notify_all();
 			}
 			void runtime_state(station_state state)
 			{
+				boost::lock_guard<boost::mutex> guard(state_mutex_);
 				if (station_state_ != station_state::Stop)
 					station_state_ = state;
+				state_cond_.notify_all();
+			}
+			/**
+			* \brief 唤醒等待状态变化的线程(状态以外的条件变化时,如网络关闭)
+			*/
+			void notify_state()
+			{
+				boost::lock_guard<boost::mutex> guard(state_mutex_);
+				state_cond_.notify_all();
+			}
+			/**
+			* \brief 等待状态变化
+			* \param ms 最长等待(毫秒)
+			* \param done 结束等待的条件(状态变化或notify_state时检查)
+			* \return 条件是否成立
+			*/
+			template <typename Pred>
+			bool wait_state(int ms, Pred done)
+			{
+				boost::unique_lock<boost::mutex> lock(state_mutex_);
+				return state_cond_.timed_wait(lock, boost::posix_time::milliseconds(ms), done);
 			}
 			/**
 			* \brief 开机日志
@@ -364,7 +867,21 @@ namespace agebull
 			*/
 			void runing()
 			{
-				log("runing");
+				if (restart_time_ > 0)
+				{
+					const int64 elapsed = latency_histogram::now() - restart_time_;
+					restart_time_ = 0;
+					restart_count++;
+					int64 max = restart_max.load();
+					while (elapsed > max && !restart_max.compare_exchange_weak(max, elapsed))
+					{
+					}
+					log_msg2("[%s] > runing (restart %lldms)", station_name_.c_str(), elapsed / 1000);
+				}
+				else
+				{
+					log("runing");
+				}
 				runtime_state(station_state::Run);
 			}
 
@@ -383,6 +900,7 @@ namespace agebull
 			void restart()
 			{
 				full_log("restart");
+				restart_time_ = latency_histogram::now();
 				runtime_state(station_state::ReStart);
 			}
 
@@ -469,7 +987,63 @@ namespace agebull
 			{
 				return to_json(0);
 			}
+
+			/**
+			* \brief 写入与上次发布相比的状态增量JSON
+			* \param last 上次发布的状态,调用后更新为当前状态
+			* \param full 是否写入全量状态(与to_status_json相同)
+			* \return 无变化且非全量时为空
+			*/
+			acl::string to_delta_json(station_status& last, bool full);
+
+			/**
+			* \brief 取得命令的延时统计,不存在时新建(超过上限或未启用时返回空)
+			*/
+			shared_ptr<latency_set> get_command_latency(const char* command, size_t len);
+
+			/**
+			* \brief 写入站点与各命令的延时分位数JSON
+			*/
+			acl::string to_latency_json();
+
+			/**
+			* \brief 取得调用者的配额拒绝计数,不存在时新建(超过上限时返回空)
+			*/
+			shared_ptr<std::atomic<int64>> get_quota_rejects(const string& caller);
+
+			/**
+			* \brief 写入配额设置与按调用者的拒绝次数JSON
+			*/
+			acl::string to_quota_json();
 		private:
+			/**
+			* \brief 计数的速率(由mutex_保护)
+			*/
+			counter_rates<counter_count> rates_;
+
+			/**
+			* \brief 一次读取全部计数
+			*/
+			void load_counters(int64(&values)[counter_count]) const
+			{
+				values[0] = request_in;
+				values[1] = request_out;
+				values[2] = request_err;
+				values[3] = worker_in;
+				values[4] = worker_out;
+				values[5] = worker_err;
+			}
+
+			/**
+			* \brief 写入1秒,10秒,60秒窗口的速率(条/秒)
+			*/
+			void add_rates(acl::json& json, acl::json_node& node, const int64(&values)[counter_count], int64 now);
+
+			/**
+			* \brief 写入一组延时的分位数(微秒)
+			*/
+			static void add_latency(acl::json& json, acl::json_node& node, const char* name, const latency_set& set);
+
 			/**
 			* \brief 写入JSON
 			* \param type 记录类型 0 全量 1 状态信息 2 基本信息
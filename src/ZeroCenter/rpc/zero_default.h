@@ -66,6 +66,8 @@ namespace agebull
 #define ZERO_STATUS_ARG_INVALID  "-invalid argument"
 #define ZERO_STATUS_TIMEOUT  "-time out"
 #define ZERO_STATUS_NET_ERROR  "-net error"
+#define ZERO_STATUS_OVERLOAD  "-overload"
+#define ZERO_STATUS_QUOTA  "-quota"
 //#define ZERO_STATUS_MANAGE_ARG_ERROR  "-ArgumentError! must like : call[name][command][argument]"
 //#define ZERO_STATUS_MANAGE_INSTALL_ARG_ERROR  "-ArgumentError! must like :install [type] [name]"
 #define ZERO_STATUS_PLAN_INVALID  "-plan invalid"
@@ -86,6 +88,8 @@ namespace agebull
 #define ZERO_FRAME_REQUEST_ID  '\4'
 		//执行计划
 #define ZERO_FRAME_PLAN  '\5'
+		//全局标识(8字节大端二进制)
+#define ZERO_FRAME_GLOBAL_ID_BIN  '\7'
 		//命令
 #define ZERO_FRAME_COMMAND  '$'
 		//参数
@@ -110,6 +114,10 @@ namespace agebull
 #define ZERO_FRAME_CONTENT_JSON  'J'
 #define ZERO_FRAME_CONTENT_BIN  'B'
 #define ZERO_FRAME_CONTENT_XML  'X'
+		//重发标记(新订阅触发的缓存最后值,已收到过该主题的订阅者应丢弃)
+#define ZERO_FRAME_REPLAY  'R'
+		//合批记录集(只在合批端口发送;6在客户端已为计划时间)
+#define ZERO_FRAME_BATCH  '+'
 
 		/*!
 		 * 以下为返回时的快捷状态:说明帧的第二节字([1])
@@ -131,6 +139,8 @@ namespace agebull
 
 #define ZERO_STATUS_FAILED_ID uchar(0x80)
 #define ZERO_STATUS_PAUSE_ID uchar(0x81)
+#define ZERO_STATUS_OVERLOAD_ID uchar(0x82)
+#define ZERO_STATUS_QUOTA_ID uchar(0x83)
 
 #define ZERO_STATUS_BUG_ID uchar(0xD0)
 #define ZERO_STATUS_FRAME_INVALID_ID uchar(0xD1)
@@ -190,6 +200,11 @@ namespace agebull
 		  */
 #define ZERO_BYTE_COMMAND_PING '*'
 
+		  /**
+		  * \brief 重放广播
+		  */
+#define ZERO_BYTE_COMMAND_REPLAY '&'
+
 		  /**
 		  * \brief 心跳加入
 		  */
@@ -246,6 +261,9 @@ namespace agebull
 				case ZERO_BYTE_COMMAND_PING: //!* 心跳加入
 					str.append("ping");
 					break;
+				case ZERO_BYTE_COMMAND_REPLAY: //!& 
+					str.append("replay");
+					break;
 				case ZERO_BYTE_COMMAND_HEART_JOIN: //!J  心跳已就绪
 					str.append("heart join");
 					break;
@@ -307,6 +325,12 @@ namespace agebull
 				case ZERO_STATUS_FAILED_ID: //!(0x82)
 					str.append(ZERO_STATUS_FAILED);
 					break;
+				case ZERO_STATUS_OVERLOAD_ID: //!(0x82)
+					str.append(ZERO_STATUS_OVERLOAD);
+					break;
+				case ZERO_STATUS_QUOTA_ID: //!(0x83)
+					str.append(ZERO_STATUS_QUOTA);
+					break;
 				case ZERO_STATUS_NOT_FIND_ID: //!(0x83)
 					str.append(ZERO_STATUS_NOT_FIND);
 					break;
@@ -347,6 +371,10 @@ namespace agebull
 				case ZERO_FRAME_GLOBAL_ID:
 					str.append(",\"GLOBAL_ID\"");
 					break;
+					//全局标识(二进制)
+				case ZERO_FRAME_GLOBAL_ID_BIN:
+					str.append(",\"GLOBAL_ID_BIN\"");
+					break;
 					//站点
 				case ZERO_FRAME_STATION_ID:
 					str.append(",\"STATION_ID\"");
@@ -355,6 +383,10 @@ namespace agebull
 				case ZERO_FRAME_PLAN:
 					str.append(",\"PLAN\"");
 					break;
+					//合批记录集
+				case ZERO_FRAME_BATCH:
+					str.append(",\"BATCH\"");
+					break;
 					//参数
 				case ZERO_FRAME_ARG:
 					str.append(",\"ARG\"");
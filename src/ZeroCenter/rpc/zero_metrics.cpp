@@ -0,0 +1,334 @@
+/**
+ * 指标导出
+ */
+#include "../stdafx.h"
+#include "zero_metrics.h"
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		/**
+		* \brief 启动导出线程(未配置端口时不启动)
+		*/
+		void zero_metrics::run()
+		{
+			if (json_config::metrics_port <= 0)
+				return;
+			boost::thread(boost::bind(poll));
+		}
+
+		/**
+		* \brief 线程过程
+		*/
+		void zero_metrics::poll()
+		{
+			char address[32];
+			sprintf(address, "tcp://*:%d", json_config::metrics_port);
+			ZMQ_HANDLE socket = zmq_socket(get_zmq_context(), ZMQ_STREAM);
+			if (socket == nullptr)
+			{
+				log_error1("[metrics] > con`t create socket > %s", socket_ex::state_str(socket_ex::check_zmq_error()));
+				return;
+			}
+			socket_ex::setsockopt(socket, ZMQ_LINGER, 0);
+			if (zmq_bind(socket, address) < 0)
+			{
+				log_error2("[metrics] > con`t bind %s > %s", address, socket_ex::state_str(socket_ex::check_zmq_error()));
+				zmq_close(socket);
+				return;
+			}
+			log_msg1("[metrics] > runing (%s)", address);
+			//按连接缓存未读完的请求头
+			map<string, string> requests;
+			zmq_pollitem_t item = { socket, 0, ZMQ_POLLIN, 0 };
+			while (get_net_state() < NET_STATE_CLOSING)
+			{
+				if (zmq_poll(&item, 1, 1000) <= 0)
+					continue;
+				zmq_msg_t id, data;
+				zmq_msg_init(&id);
+				zmq_msg_init(&data);
+				if (zmq_msg_recv(&id, socket, ZMQ_DONTWAIT) < 0 || zmq_msg_recv(&data, socket, ZMQ_DONTWAIT) < 0)
+				{
+					zmq_msg_close(&id);
+					zmq_msg_close(&data);
+					continue;
+				}
+				string peer(static_cast<const char*>(zmq_msg_data(&id)), zmq_msg_size(&id));
+				const size_t size = zmq_msg_size(&data);
+				if (size == 0)//连接建立或断开
+				{
+					requests.erase(peer);
+				}
+				else
+				{
+					string& request = requests[peer];
+					request.append(static_cast<const char*>(zmq_msg_data(&data)), size);
+					if (request.find("\r\n\r\n") != string::npos || request.size() > 8192)
+					{
+						const string reply = response(request);
+						requests.erase(peer);
+						zmq_send(socket, peer.c_str(), peer.size(), ZMQ_SNDMORE);
+						zmq_send(socket, reply.c_str(), reply.size(), 0);
+						//发送身份与空帧即关闭连接
+						zmq_send(socket, peer.c_str(), peer.size(), ZMQ_SNDMORE);
+						zmq_send(socket, nullptr, 0, 0);
+					}
+				}
+				zmq_msg_close(&id);
+				zmq_msg_close(&data);
+			}
+			socket_ex::close_res_socket(socket, address);
+			log_msg("[metrics] > closed");
+		}
+
+		/**
+		* \brief 应答一个HTTP请求
+		*/
+		string zero_metrics::response(const string& request)
+		{
+			const char* status;
+			const char* type = "text/plain; charset=utf-8";
+			string body;
+			if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 6, "GET / ") == 0)
+			{
+				const bool open_metrics = request.find("application/openmetrics-text") != string::npos;
+				status = "200 OK";
+				type = open_metrics
+					? "application/openmetrics-text; version=1.0.0; charset=utf-8"
+					: "text/plain; version=0.0.4; charset=utf-8";
+				body = collect(open_metrics);
+			}
+			else if (request.compare(0, 4, "GET ") == 0)
+			{
+				status = "404 Not Found";
+				body = "not found\n";
+			}
+			else
+			{
+				status = "405 Method Not Allowed";
+				body = "method not allowed\n";
+			}
+			char head[256];
+			sprintf(head, "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n", status, type, body.size());
+			return head + body;
+		}
+
+		/**
+		* \brief 生成全部指标
+		*/
+		string zero_metrics::collect(bool open_metrics)
+		{
+			zero_metrics metrics(open_metrics);
+			vector<shared_ptr<zero_config>> configs;
+			station_warehouse::foreach_configs([&configs](const shared_ptr<zero_config>& config)
+			{
+				configs.push_back(config);
+			});
+			metrics.family("zero_station_messages", "counter", "Messages handled by the station");
+			for (auto& config : configs)
+			{
+				int64 values[zero_config::counter_count];
+				values[0] = config->request_in;
+				values[1] = config->request_out;
+				values[2] = config->request_err;
+				values[3] = config->worker_in;
+				values[4] = config->worker_out;
+				values[5] = config->worker_err;
+				for (size_t idx = 0; idx < zero_config::counter_count; idx++)
+				{
+					string labels;
+					label(labels, "station", config->station_name_);
+					label(labels, "counter", zero_config::counter_names[idx]);
+					metrics.sample("zero_station_messages_total", labels, values[idx]);
+				}
+			}
+			metrics.family("zero_station_state", "gauge", "Station state (station_state enum)");
+			for (auto& config : configs)
+			{
+				string labels;
+				label(labels, "station", config->station_name_);
+				metrics.sample("zero_station_state", labels, static_cast<int64>(config->get_station_state()));
+			}
+			metrics.family("zero_station_ready_workers", "gauge", "Workers ready to take requests");
+			for (auto& config : configs)
+			{
+				string labels;
+				label(labels, "station", config->station_name_);
+				metrics.sample("zero_station_ready_workers", labels, config->get_ready_works());
+			}
+			metrics.family("zero_station_queue_depth", "gauge", "Requests sent to workers and not yet answered");
+			for (auto& config : configs)
+			{
+				string labels;
+				label(labels, "station", config->station_name_);
+				metrics.sample("zero_station_queue_depth", labels, config->queue_depth.load(std::memory_order_relaxed));
+			}
+			metrics.family("zero_station_shed", "counter", "Requests rejected by admission control");
+			for (auto& config : configs)
+			{
+				string labels;
+				label(labels, "station", config->station_name_);
+				metrics.sample("zero_station_shed_total", labels, config->request_shed.load(std::memory_order_relaxed));
+			}
+			metrics.family("zero_station_admit_limit", "gauge", "Current admission limit on requests at workers (0 disabled)");
+			for (auto& config : configs)
+			{
+				string labels;
+				label(labels, "station", config->station_name_);
+				metrics.sample("zero_station_admit_limit", labels, config->admit_limit.load(std::memory_order_relaxed));
+			}
+			metrics.family("zero_station_breaker_rejected", "counter", "Requests rejected while the circuit breaker was open");
+			for (auto& config : configs)
+			{
+				string labels;
+				label(labels, "station", config->station_name_);
+				metrics.sample("zero_station_breaker_rejected_total", labels, config->request_broken.load(std::memory_order_relaxed));
+			}
+			metrics.family("zero_station_breaker_state", "gauge", "Circuit breaker state (0 closed, 1 open, 2 half-open)");
+			for (auto& config : configs)
+			{
+				string labels;
+				label(labels, "station", config->station_name_);
+				metrics.sample("zero_station_breaker_state", labels, config->breaker_state.load(std::memory_order_relaxed));
+			}
+			metrics.family("zero_station_coalesced", "counter", "Requests answered with the result of an identical request in flight");
+			for (auto& config : configs)
+			{
+				string labels;
+				label(labels, "station", config->station_name_);
+				metrics.sample("zero_station_coalesced_total", labels, config->request_coalesced.load(std::memory_order_relaxed));
+			}
+			metrics.family("zero_station_quota_rejected", "counter", "Requests rejected by per-caller quotas");
+			for (auto& config : configs)
+			{
+				string labels;
+				label(labels, "station", config->station_name_);
+				metrics.sample("zero_station_quota_rejected_total", labels, config->request_quota.load(std::memory_order_relaxed));
+			}
+			metrics.family("zero_caller_rejected", "counter", "Requests rejected by per-caller quotas, by caller");
+			for (auto& config : configs)
+			{
+				const auto callers = config->quota_rejects.snapshot();
+				for (auto& caller : *callers)
+				{
+					string labels;
+					label(labels, "station", config->station_name_);
+					label(labels, "caller", caller.first);
+					metrics.sample("zero_caller_rejected_total", labels, caller.second->load(std::memory_order_relaxed));
+				}
+			}
+			metrics.family("zero_station_latency_microseconds", "summary", "Request latency by stage");
+			for (auto& config : configs)
+			{
+				const latency_histogram* stages[] = { &config->latency.queue, &config->latency.worker, &config->latency.total };
+				const char* names[] = { "queue", "worker", "total" };
+				for (size_t idx = 0; idx < 3; idx++)
+				{
+					string labels;
+					label(labels, "station", config->station_name_);
+					label(labels, "stage", names[idx]);
+					metrics.summary("zero_station_latency_microseconds", labels, *stages[idx]);
+				}
+			}
+			metrics.family("zero_command_latency_microseconds", "summary", "Request latency by command and stage");
+			for (auto& config : configs)
+			{
+				const auto commands = config->command_latency.snapshot();
+				for (auto& command : *commands)
+				{
+					const latency_histogram* stages[] = { &command.second->queue, &command.second->worker, &command.second->total };
+					const char* names[] = { "queue", "worker", "total" };
+					for (size_t idx = 0; idx < 3; idx++)
+					{
+						string labels;
+						label(labels, "station", config->station_name_);
+						label(labels, "command", command.first);
+						label(labels, "stage", names[idx]);
+						metrics.summary("zero_command_latency_microseconds", labels, *stages[idx]);
+					}
+				}
+			}
+			metrics.family("zero_redis_call_microseconds", "summary", "Redis call latency");
+			metrics.summary("zero_redis_call_microseconds", string(), trans_redis::call_latency);
+			metrics.family("zero_plan_lag_microseconds", "summary", "Delay between planned and actual plan execution");
+			metrics.summary("zero_plan_lag_microseconds", string(), plan_dispatcher::exec_lag);
+			if (open_metrics)
+				metrics.text_.append("# EOF\n");
+			return std::move(metrics.text_);
+		}
+
+		/**
+		* \brief 写入指标族的说明与类型
+		*/
+		void zero_metrics::family(const char* name, const char* type, const char* help)
+		{
+			//Prometheus文本格式中计数器的族名称带_total后缀,OpenMetrics不带
+			const char* suffix = !open_metrics_ && strcmp(type, "counter") == 0 ? "_total" : "";
+			text_.append("# HELP ").append(name).append(suffix).append(" ").append(help).append("\n");
+			text_.append("# TYPE ").append(name).append(suffix).append(" ").append(type).append("\n");
+		}
+
+		/**
+		* \brief 写入一个样本
+		*/
+		void zero_metrics::sample(const char* name, const string& labels, int64 value)
+		{
+			text_.append(name);
+			if (!labels.empty())
+				text_.append("{").append(labels).append("}");
+			text_.append(" ").append(std::to_string(value)).append("\n");
+		}
+
+		/**
+		* \brief 写入一个延时摘要(分位数,总和,次数;微秒)
+		*/
+		void zero_metrics::summary(const char* name, const string& labels, const latency_histogram& histogram)
+		{
+			const latency_summary result = histogram.summary();
+			const char* quantiles[] = { "0.5", "0.99", "0.999" };
+			const int64 values[] = { result.p50, result.p99, result.p999 };
+			for (size_t idx = 0; idx < 3; idx++)
+			{
+				string quantile(labels);
+				label(quantile, "quantile", quantiles[idx]);
+				sample(name, quantile, values[idx]);
+			}
+			string sum_name(name), count_name(name);
+			sum_name.append("_sum");
+			count_name.append("_count");
+			sample(sum_name.c_str(), labels, result.sum);
+			sample(count_name.c_str(), labels, result.count);
+		}
+
+		/**
+		* \brief 追加一个标签(值按格式要求转义)
+		*/
+		void zero_metrics::label(string& labels, const char* name, const string& value)
+		{
+			if (!labels.empty())
+				labels.append(",");
+			labels.append(name).append("=\"");
+			for (char ch : value)
+			{
+				switch (ch)
+				{
+				case '\\':
+					labels.append("\\\\");
+					break;
+				case '"':
+					labels.append("\\\"");
+					break;
+				case '\n':
+					labels.append("\\n");
+					break;
+				default:
+					labels.append(1, ch);
+					break;
+				}
+			}
+			labels.append("\"");
+		}
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+#ifndef _ZERO_METRICS_H_
+#define _ZERO_METRICS_H_
+#include "../stdinc.h"
+#include "../ext/latency_histogram.h"
+
+namespace agebull
+{
+	namespace zmq_net
+	{
+		class zero_config;
+		/**
+		* \brief 指标导出(Prometheus文本格式与OpenMetrics,HTTP GET /metrics)
+		* \remark
+		* 使用ZMQ_STREAM套接字在独立线程中应答HTTP请求,端口为json_config::metrics_port(0 不启用).
+		* 只读取分片计数,原子直方图与站点配置的快照,不获取站点与Redis的锁.
+		*/
+		class zero_metrics
+		{
+			/**
+			* \brief 是否使用OpenMetrics格式
+			*/
+			bool open_metrics_;
+			/**
+			* \brief 输出
+			*/
+			string text_;
+		public:
+			/**
+			* \brief 启动导出线程(未配置端口时不启动)
+			*/
+			static void run();
+
+			/**
+			* \brief 生成全部指标
+			* \param open_metrics 是否使用OpenMetrics格式(否则为Prometheus文本格式0.0.4)
+			*/
+			static string collect(bool open_metrics);
+		private:
+			explicit zero_metrics(bool open_metrics)
+				: open_metrics_(open_metrics)
+			{
+			}
+
+			/**
+			* \brief 线程过程
+			*/
+			static void poll();
+
+			/**
+			* \brief 应答一个HTTP请求
+			* \return 回复的完整报文
+			*/
+			static string response(const string& request);
+
+			/**
+			* \brief 写入指标族的说明与类型
+			*/
+			void family(const char* name, const char* type, const char* help);
+
+			/**
+			* \brief 写入一个样本
+			* \param name 样本名称
+			* \param labels 已格式化的标签(不含大括号,可为空)
+			* \param value 值
+			*/
+			void sample(const char* name, const string& labels, int64 value);
+
+			/**
+			* \brief 写入一个延时摘要(分位数,总和,次数;微秒)
+			*/
+			void summary(const char* name, const string& labels, const latency_histogram& histogram);
+
+			/**
+			* \brief 追加一个标签(值按格式要求转义)
+			*/
+			static void label(string& labels, const char* name, const string& value);
+		};
+	}
+}
+#endif //!_ZERO_METRICS_H_
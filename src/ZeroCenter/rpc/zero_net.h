@@ -69,6 +69,13 @@ namespace agebull
 		*/
 		NET_STATE get_net_state();
 
+		/**
+		*\brief ȴ翪ʼر(,رʱ)
+		*\param ms ȴ()
+		*\return Ƿѿʼر
+		*/
+		bool wait_net_closing(int ms);
+
 		/**
 		*\brief ̼߳
 		*/
@@ -176,6 +183,21 @@ namespace agebull
 			*/
 			event_client_left,
 
+			/**
+			*\brief վ״̬
+			*/
+			event_station_delta,
+
+			/**
+			*\brief վ·״̬仯
+			*/
+			event_station_breaker,
+
+			/**
+			*\brief ׼Խ
+			*/
+			event_bench_result,
+
 			/**
 			*\brief ƻ
 			*/
@@ -224,7 +224,7 @@ namespace agebull
 			plan_time = time;
 
 			char key[256];
-			sprintf(key, "msg:%s:%llx", *station, plan_id);
+			id_codec::make_key(key, "msg:", *station, static_cast<uint64_t>(plan_id));
 			map<acl::string, double> value;
 			value.insert(make_pair(key, static_cast<double>(time)));
 			redis_live_scope redis(json_config::redis_defdb);
@@ -238,7 +238,7 @@ namespace agebull
 		bool plan_message::error()
 		{
 			char key[256];
-			sprintf(key, "msg:%s:%llx", *station, plan_id);
+			id_codec::make_key(key, "msg:", *station, static_cast<uint64_t>(plan_id));
 			plan_state = plan_message_state::error;
 			redis_live_scope redis(json_config::redis_defdb);
 			save_message(false, false, false, false, false, true);
@@ -253,7 +253,7 @@ namespace agebull
 		bool plan_message::reset()
 		{
 			char key[256];
-			sprintf(key, "msg:%s:%llx", *station, plan_id);
+			id_codec::make_key(key, "msg:", *station, static_cast<uint64_t>(plan_id));
 			plan_state = plan_message_state::none;
 			redis_live_scope redis(json_config::redis_defdb);
 			redis.t()->set_hash_val(key, "plan_state", static_cast<int>(plan_state));
@@ -267,7 +267,7 @@ namespace agebull
 		bool plan_message::pause()
 		{
 			char key[256];
-			sprintf(key, "msg:%s:%llx", *station, plan_id);
+			id_codec::make_key(key, "msg:", *station, static_cast<uint64_t>(plan_id));
 			plan_state = plan_message_state::pause;
 			redis_live_scope redis(json_config::redis_defdb);
 			redis.t()->set_hash_val(key, "plan_state", static_cast<int>(plan_state));
@@ -281,7 +281,7 @@ namespace agebull
 		bool plan_message::close()
 		{
 			char key[256];
-			sprintf(key, "msg:%s:%llx", *station, plan_id);
+			id_codec::make_key(key, "msg:", *station, static_cast<uint64_t>(plan_id));
 			plan_state = plan_message_state::close;
 			redis_live_scope redis(json_config::redis_defdb);
 			redis->zrem("plan:time:set", key);
@@ -295,7 +295,7 @@ namespace agebull
 		bool plan_message::remove() const
 		{
 			char key[256];
-			sprintf(key, "msg:%s:%llx", *station, plan_id);
+			id_codec::make_key(key, "msg:", *station, static_cast<uint64_t>(plan_id));
 			redis_live_scope redis(json_config::redis_defdb);
 			redis->del(key);
 			//local_chche.erase(key);
@@ -376,7 +376,7 @@ namespace agebull
 		bool plan_message::save_message(bool full, bool exec, bool plan, bool res, bool skip, bool close)
 		{
 			char key[256];
-			sprintf(key, "msg:%s:%llx", *station, plan_id);
+			id_codec::make_key(key, "msg:", *station, static_cast<uint64_t>(plan_id));
 			redis_live_scope scope(json_config::redis_defdb);
 			trans_redis* redis = scope.t();
 			if (add_time == 0)
@@ -452,7 +452,7 @@ namespace agebull
 				return false;
 			redis_live_scope redis(json_config::redis_defdb);
 			char key[256];
-			sprintf(key, "msg:%s:%llx", *station, plan_id);
+			id_codec::make_key(key, "msg:", *station, static_cast<uint64_t>(plan_id));
 			char skey[64];
 			for (auto iter : workers)
 			{
@@ -475,7 +475,7 @@ namespace agebull
 				redis_live_scope scope(json_config::redis_defdb);
 				trans_redis* redis = scope.t();
 				char key[256];
-				sprintf(key, "msg:%s:%llx", *station, plan_id);
+				id_codec::make_key(key, "msg:", *station, static_cast<uint64_t>(plan_id));
 				char skey[64];
 				sprintf(skey, "wroks:%s:size", worker);
 				size_t size = redis->get_hash_num(key, skey);
@@ -521,7 +521,7 @@ namespace agebull
 			redis_live_scope scope(json_config::redis_defdb);
 			trans_redis* redis = scope.t();
 			char key[256];
-			sprintf(key, "msg:%s:%llx", *station, plan_id);
+			id_codec::make_key(key, "msg:", *station, static_cast<uint64_t>(plan_id));
 			char skey[64];
 			sprintf(skey, "wroks:%s:size", worker);
 			size_t size = redis->get_hash_num(key, skey);
@@ -548,7 +548,7 @@ namespace agebull
 			do
 			{
 				map<acl::string, acl::string> values;
-				sprintf(key, "msg:%s:%llx", *station, plan_id);
+				id_codec::make_key(key, "msg:", *station, static_cast<uint64_t>(plan_id));
 				cursor = scope->hscan(key, cursor, values, "wroks:*:size");
 				for (pair<const acl::string, acl::string>& iter : values)
 				{
@@ -2,6 +2,7 @@
 #include "zero_station.h"
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <sys/eventfd.h>
 
 #define port_redis_key "net:port:next"
 
@@ -13,6 +14,8 @@ namespace agebull
 		//map<int64, vector<shared_char>> zero_station::results;
 		//boost::mutex zero_station::results_mutex_;
 
+		thread_local zero_station* zero_station::polling_station_ = nullptr;
+
 		zero_station::zero_station(const string name, int type, int req_zmq_type, int res_zmq_type)
 			: req_zmq_type_(req_zmq_type)
 			, res_zmq_type_(res_zmq_type)
@@ -23,12 +26,23 @@ namespace agebull
 			, station_name_(name)
 			, config_(station_warehouse::get_config(name))
 			, request_scoket_tcp_(nullptr)
-			//, request_socket_ipc_(nullptr)
 			, request_socket_inproc_(nullptr)
+			, use_ipc_(false)
 			, plan_socket_inproc_(nullptr)
 			, worker_in_socket_tcp_(nullptr)
 			, worker_out_socket_tcp_(nullptr)
-			//, worker_out_socket_ipc_(nullptr)
+			, batch_socket_tcp_(nullptr)
+			, inflight_purge_time_(0)
+			, use_shm_(false)
+			, shm_check_time_(0)
+			, request_time_(0)
+			, outbox_bell_(-1)
+			, outbox_signaled_(false)
+			, outbox_closed_(false)
+			, outbox_users_(0)
+			, drain_until_(0)
+			, polling_(false)
+			, timer_wait_(-1)
 			, zmq_state_(zmq_socket_state::Succeed)
 		{
 			assert(req_zmq_type_ != ZMQ_PUB);
@@ -44,12 +58,23 @@ namespace agebull
 			, station_name_(config->station_name_)
 			, config_(config)
 			, request_scoket_tcp_(nullptr)
-			//, request_socket_ipc_(nullptr)
 			, request_socket_inproc_(nullptr)
+			, use_ipc_(false)
 			, plan_socket_inproc_(nullptr)
 			, worker_in_socket_tcp_(nullptr)
 			, worker_out_socket_tcp_(nullptr)
-			//, worker_out_socket_ipc_(nullptr)
+			, batch_socket_tcp_(nullptr)
+			, inflight_purge_time_(0)
+			, use_shm_(false)
+			, shm_check_time_(0)
+			, request_time_(0)
+			, outbox_bell_(-1)
+			, outbox_signaled_(false)
+			, outbox_closed_(false)
+			, outbox_users_(0)
+			, drain_until_(0)
+			, polling_(false)
+			, timer_wait_(-1)
 			, zmq_state_(zmq_socket_state::Succeed)
 		{
 			assert(req_zmq_type_ != ZMQ_PUB);
@@ -79,17 +104,9 @@ namespace agebull
 				return false;
 			}
 			poll_items_[poll_count_++] = { request_scoket_tcp_, 0, ZMQ_POLLIN, 0 };
-			//if (json_config::use_ipc_protocol)
-			//{
-			//	request_socket_ipc_ = socket_ex::create_res_socket_ipc(station_name, "req", req_zmq_type_);
-			//	if (request_socket_ipc_ == nullptr)
-			//	{
-			//		config_->runtime_state(station_state::Failed);
-			//		config_->error("initialize request ipc", zmq_strerror(zmq_errno()));
-			//		return false;
-			//	}
-			//	poll_items_[poll_count_++] = { request_socket_ipc_, 0, ZMQ_POLLIN, 0 };
-			//}
+			//IPC地址绑定在同一套接字上,与TCP共用轮询与发送
+			use_ipc_ = config_->is_use_ipc();
+			bind_ipc(request_scoket_tcp_, "req");
 
 			request_socket_inproc_ = socket_ex::create_res_socket_inproc(station_name, req_zmq_type_);
 			if (request_socket_inproc_ == nullptr)
@@ -104,25 +121,56 @@ namespace agebull
 			if (station_type_ > STATION_TYPE_DISPATCHER && station_type_ < STATION_TYPE_SPECIAL)
 				plan_socket_inproc_ = socket_ex::create_req_socket_inproc("PlanDispatcher", station_name);
 
+			if (station_type_ == STATION_TYPE_API || station_type_ == STATION_TYPE_ROUTE_API)
+			{
+				admission_.initialize(config_->get_admit_max_inflight(), config_->is_admit_adaptive(), config_->get_admit_min_inflight(),
+					json_config::admit_target, json_config::admit_interval, max_inflight);
+				config_->admit_limit = admission_.enable() ? admission_.limit() : 0;
+				quota_.initialize(config_->get_quota_rate(), config_->get_quota_burst(), json_config::quota_callers);
+				breaker_.initialize(config_->is_breaker(), config_->get_breaker_error_rate(), config_->get_breaker_min_requests(),
+					config_->get_breaker_window(), config_->get_breaker_open_time(), config_->get_breaker_probes());
+				config_->breaker_state = static_cast<int>(breaker_.state());
+			}
+
 			if (station_type_ < STATION_TYPE_API || station_type_ >= STATION_TYPE_SPECIAL)
 			{
-				worker_out_socket_tcp_ = socket_ex::create_res_socket_tcp(station_name, ZMQ_PUB, config_->worker_out_port_);
+				//启用广播缓存或合批时使用XPUB,以便得知订阅情况
+				const bool cached = pub_cache_.set_limit(config_->get_pub_cache_size(), config_->get_pub_replay_size(), config_->get_pub_cache_bytes());
+				pub_cache_.set_republish_interval(json_config::pub_republish_ivl);
+				const bool batched = pub_batch_.set_limit(config_->get_pub_batch_linger(), config_->get_pub_batch_size());
+				worker_out_socket_tcp_ = socket_ex::create_res_socket_tcp(station_name, cached || batched ? ZMQ_XPUB : ZMQ_PUB, config_->worker_out_port_);
 				if (worker_out_socket_tcp_ == nullptr)
 				{
 					config_->runtime_state(station_state::Failed);
 					config_->error("initialize worker out", zmq_strerror(zmq_errno()));
 					return false;
 				}
-				//if (json_config::use_ipc_protocol)
-				//{
-				//	worker_out_socket_ipc_ = socket_ex::create_res_socket_ipc(station_name, "sub", ZMQ_PUB);
-				//	if (worker_out_socket_ipc_ == nullptr)
-				//	{
-				//		config_->runtime_state(station_state::Failed);
-				//		config_->error("initialize worker out", zmq_strerror(zmq_errno()));
-				//		return false;
-				//	}
-				//}
+				bind_ipc(worker_out_socket_tcp_, "out");
+				if (cached || batched)
+				{
+					//每个订阅都上报,否则同一主题的后来者收不到补发
+					socket_ex::setsockopt(worker_out_socket_tcp_, ZMQ_XPUB_VERBOSE, 1);
+					poll_items_[poll_count_++] = { worker_out_socket_tcp_, 0, ZMQ_POLLIN, 0 };
+				}
+				//合批记录集走独立端口,旧客户端的空前缀订阅收不到
+				if (batched)
+				{
+					if (!station_warehouse::alloc_batch_port(config_))
+					{
+						config_->runtime_state(station_state::Failed);
+						config_->error("initialize batch port", "alloc failed");
+						return false;
+					}
+					batch_socket_tcp_ = socket_ex::create_res_socket_tcp(station_name, ZMQ_XPUB, config_->batch_port_);
+					if (batch_socket_tcp_ == nullptr)
+					{
+						config_->runtime_state(station_state::Failed);
+						config_->error("initialize batch out", zmq_strerror(zmq_errno()));
+						return false;
+					}
+					socket_ex::setsockopt(batch_socket_tcp_, ZMQ_XPUB_VERBOSE, 1);
+					poll_items_[poll_count_++] = { batch_socket_tcp_, 0, ZMQ_POLLIN, 0 };
+				}
 			}
 			else if (station_type_ == STATION_TYPE_ROUTE_API)
 			{
@@ -133,6 +181,7 @@ namespace agebull
 					config_->error("initialize worker out", zmq_strerror(zmq_errno()));
 					return false;
 				}
+				bind_ipc(worker_out_socket_tcp_, "out");
 				worker_in_socket_tcp_ = socket_ex::create_res_socket_tcp(station_name, ZMQ_DEALER, config_->worker_in_port_);
 				if (worker_in_socket_tcp_ == nullptr)
 				{
@@ -140,6 +189,7 @@ namespace agebull
 					config_->error("initialize worker in", zmq_strerror(zmq_errno()));
 					return false;
 				}
+				bind_ipc(worker_in_socket_tcp_, "in");
 				poll_items_[poll_count_++] = { worker_in_socket_tcp_, 0, ZMQ_POLLIN, 0 };
 			}
 			else
@@ -151,6 +201,7 @@ namespace agebull
 					config_->error("initialize worker out", zmq_strerror(zmq_errno()));
 					return false;
 				}
+				bind_ipc(worker_out_socket_tcp_, "out");
 				worker_in_socket_tcp_ = socket_ex::create_res_socket_tcp(station_name, ZMQ_DEALER, config_->worker_in_port_);
 				if (worker_in_socket_tcp_ == nullptr)
 				{
@@ -158,9 +209,27 @@ namespace agebull
 					config_->error("initialize worker in", zmq_strerror(zmq_errno()));
 					return false;
 				}
+				bind_ipc(worker_in_socket_tcp_, "in");
 				poll_items_[poll_count_++] = { worker_in_socket_tcp_, 0, ZMQ_POLLIN, 0 };
+				//共享内存环:入环的唤醒管道以文件描述符加入轮询
+				if (station_type_ == STATION_TYPE_API && config_->is_use_shm())
+				{
+					use_shm_ = shm_.create(station_name, static_cast<uint64_t>(json_config::shm_ring_size));
+					if (use_shm_)
+						poll_items_[poll_count_++] = { nullptr, shm_.in_bell(), ZMQ_POLLIN, 0 };
+					else
+						config_->error("initialize shm", "create failed");
+				}
 			}
-			switch (station_type_)
+			//其它线程的发送经发件箱交给轮询线程
+			outbox_bell_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (outbox_bell_ >= 0)
+				poll_items_[poll_count_++] = { nullptr, outbox_bell_, ZMQ_POLLIN, 0 };
+			else
+				config_->error("initialize outbox", strerror(errno));
+			outbox_closed_.store(false);
+			//共享轮询的站点不启动监控线程
+			switch (config_->is_use_reactor() ? 0 : station_type_)
 			{
 			case STATION_TYPE_DISPATCHER:
 				zmq_monitor::set_monitor(station_name, worker_out_socket_tcp_, "disp");
@@ -178,6 +247,26 @@ namespace agebull
 			return true;
 		}
 
+		/**
+		* \brief 追加绑定IPC地址(未启用时忽略)
+		*/
+		void zero_station::bind_ipc(ZMQ_HANDLE socket, const char* name)
+		{
+			if (!use_ipc_ || socket == nullptr)
+				return;
+			if (!socket_ex::bind_ipc(socket, get_station_name(), name))
+				config_->error("bind ipc", zmq_strerror(zmq_errno()));
+		}
+
+		/**
+		* \brief 解除IPC地址的绑定
+		*/
+		void zero_station::unbind_ipc(ZMQ_HANDLE socket, const char* name)
+		{
+			if (use_ipc_ && socket != nullptr)
+				socket_ex::unbind_ipc(socket, get_station_name(), name);
+		}
+
 		/**
 		* \brief 析构
 		*/
@@ -189,13 +278,9 @@ namespace agebull
 				return true;
 			if (request_scoket_tcp_ != nullptr)
 			{
+				unbind_ipc(request_scoket_tcp_, "req");
 				socket_ex::close_res_socket(request_scoket_tcp_, config_->get_request_address().c_str());
 			}
-			//if (request_socket_ipc_ != nullptr)
-			//{
-			//	make_ipc_address(address, get_station_name(), "req");
-			//	socket_ex::close_res_socket(request_socket_ipc_, address);
-			//}
 			if (request_socket_inproc_ != nullptr)
 			{
 				make_inproc_address(address, get_station_name());
@@ -208,17 +293,24 @@ namespace agebull
 			}
 			if (worker_in_socket_tcp_ != nullptr)
 			{
+				unbind_ipc(worker_in_socket_tcp_, "in");
 				socket_ex::close_res_socket(worker_in_socket_tcp_, config_->get_work_in_address().c_str());
 			}
 			if (worker_out_socket_tcp_ != nullptr)
 			{
+				if (pub_batch_.enable())
+					flush_batch(true);
+				unbind_ipc(worker_out_socket_tcp_, "out");
 				socket_ex::close_res_socket(worker_out_socket_tcp_, config_->get_work_out_address().c_str());
 			}
-			//if (worker_out_socket_ipc_ != nullptr)
-			//{
-			//	make_ipc_address(address, get_station_name(), "sub");
-			//	socket_ex::close_res_socket(worker_out_socket_ipc_, address);
-			//}
+			if (batch_socket_tcp_ != nullptr)
+			{
+				socket_ex::close_res_socket(batch_socket_tcp_, config_->get_batch_address().c_str());
+			}
+			//损坏停用后段仍在,一并删除
+			shm_.destroy();
+			use_shm_ = false;
+			close_outbox();
 			delete[]poll_items_;
 			poll_items_ = nullptr;
 			return true;
@@ -229,86 +321,201 @@ namespace agebull
 		*/
 		bool zero_station::poll()
 		{
+			frame_pool::set_thread_name(get_station_name());
+			config_->set_poll_thread(get_station_name());
+			set_polling(this);
+			bool re;
+			do
+			{
+				poll_start();
+				while (true)
+				{
+					if (!can_do())
+					{
+						zmq_state_ = zmq_socket_state::Intr;
+						break;
+					}
+					const int state = zmq_poll(poll_items_, poll_count_, poll_prepare() ? poll_timeout() : 0);
+					if (!on_poll(state, poll_items_))
+						break;
+				}
+				re = poll_end();
+			} while (hot_restart());
+			set_polling(nullptr);
+			return re;
+		}
+
+		/**
+		* \brief 开始轮询(轮询线程调用)
+		*/
+		void zero_station::poll_start()
+		{
+			polling_.store(true);
 			config_->runing();
 			//登记线程开始
 			set_command_thread_run(get_station_name());
-			while (true)
+			//轮询开始前其它线程已放入的消息
+			drain_outbox();
+			//重启前暂存的请求
+			replay_held();
+		}
+
+		/**
+		* \brief 轮询前的准备
+		* \return 能否等待(共享内存入环非空时不能等待)
+		*/
+		bool zero_station::poll_prepare()
+		{
+			//声明休眠后再次确认入环为空,否则不等待,避免漏掉工作者的唤醒
+			return !use_shm_ || shm_.in().park();
+		}
+
+		/**
+		* \brief 处理一次轮询的结果
+		* \param state zmq_poll的返回值(共享轮询时为本站点就绪的数量)
+		* \param items 本站点的轮询节点(与poll_items_顺序一致)
+		* \return 是否继续轮询
+		*/
+		bool zero_station::on_poll(int state, zmq_pollitem_t* items)
+		{
+			if (use_shm_)
 			{
-				if (!can_do())
+				shm_.in().unpark();
+				shm_response();
+				//繁忙时轮询不会超时,按时间检查工作者是否存活
+				const int64 now = latency_histogram::now();
+				if (use_shm_ && now - shm_check_time_ >= 1000000LL)
 				{
-					zmq_state_ = zmq_socket_state::Intr;
-					break;
+					shm_check_time_ = now;
+					shm_.check_peer();
 				}
-				const int state = zmq_poll(poll_items_, poll_count_, 10000);
-				if (state == 0)//超时或需要关闭
-					continue;
-				if (state < 0)
+			}
+			if (outbox_signaled_.load())
+				drain_outbox();
+			if (state >= 0 && pub_batch_.enable())
+				flush_batch(false);
+			if (pub_cache_.enable())
+			{
+				pub_cache_.flush_republish(time_us(), [this](const string& prefix)
 				{
-					zmq_state_ = socket_ex::check_zmq_error();
-					if (zmq_state_ < zmq_socket_state::Again)
-						continue;
-					break;
+					republish(prefix.c_str(), prefix.length());
+				});
+			}
+			check_drain();
+			if (!held_.empty())
+				replay_held();
+			timer_wait_ = job_timer(latency_histogram::now());
+			if (state == 0)//超时或需要关闭
+				return true;
+			if (state < 0)
+			{
+				zmq_state_ = socket_ex::check_zmq_error();
+				return zmq_state_ < zmq_socket_state::Again;
+			}
+			zmq_state_ = zmq_socket_state::Succeed;
+			//#pragma omp parallel  for schedule(dynamic,3)
+			for (int idx = 0; idx < poll_count_; idx++)
+			{
+				if (items[idx].revents & ZMQ_POLLIN)
+				{
+					if (items[idx].socket == nullptr)
+					{
+						//发件箱已在轮询后取出;共享内存唤醒,入环已在轮询后读取
+						if (items[idx].fd != outbox_bell_)
+							shm_.drain_bell();
+					}
+					else if (items[idx].socket == request_scoket_tcp_)
+					{
+						config_->request_in++;
+						request(items[idx].socket, false);
+					}
+					else if (items[idx].socket == request_socket_inproc_)
+					{
+						config_->request_in++;
+						request(items[idx].socket, true);
+					}
+					else if (items[idx].socket == worker_in_socket_tcp_)
+					{
+						config_->worker_in++;
+						response();
+					}
+					else if (items[idx].socket == worker_out_socket_tcp_)
+					{
+						subscribe(false);
+					}
+					else if (items[idx].socket == batch_socket_tcp_)
+					{
+						subscribe(true);
+					}
 				}
-				zmq_state_ = zmq_socket_state::Succeed;
-				//#pragma omp parallel  for schedule(dynamic,3)
-				for (int idx = 0; idx < poll_count_; idx++)
+				/*if (items[idx].revents & ZMQ_POLLOUT)
 				{
-					if (poll_items_[idx].revents & ZMQ_POLLIN)
+					if (items[idx].socket == request_scoket_tcp_)
 					{
-						if (poll_items_[idx].socket == request_scoket_tcp_)
-						{
-							config_->request_in++;
-							request(poll_items_[idx].socket, false);
-						}
-						//else if (poll_items_[idx].socket == request_socket_ipc_)
-						//{
-						//	config_->request_in++;
-						//	request(poll_items_[idx].socket, false);
-						//}
-						else if (poll_items_[idx].socket == request_socket_inproc_)
-						{
-							config_->request_in++;
-							request(poll_items_[idx].socket, true);
-						}
-						else if (poll_items_[idx].socket == worker_in_socket_tcp_)
-						{
-							config_->worker_in++;
-							response();
-						}
+						config_->request_out++;
 					}
-					/*if (poll_items_[idx].revents & ZMQ_POLLOUT)
+					else if (items[idx].socket == request_socket_ipc_)
 					{
-						if (poll_items_[idx].socket == request_scoket_tcp_)
-						{
-							config_->request_out++;
-						}
-						else if (poll_items_[idx].socket == request_socket_ipc_)
-						{
-							config_->request_out++;
-						}
-						else if (poll_items_[idx].socket == worker_out_socket_tcp_)
-						{
-							config_->worker_out++;
-						}
+						config_->request_out++;
 					}
-					if (poll_items_[idx].revents & ZMQ_POLLERR)
+					else if (items[idx].socket == worker_out_socket_tcp_)
 					{
-						const zmq_socket_state err_state = check_zmq_error();
-						config_->error("ZMQ_POLLERR", state_str(err_state));
-					}*/
+						config_->worker_out++;
+					}
 				}
+				if (items[idx].revents & ZMQ_POLLERR)
+				{
+					const zmq_socket_state err_state = check_zmq_error();
+					config_->error("ZMQ_POLLERR", state_str(err_state));
+				}*/
 			}
+			return true;
+		}
+
+		/**
+		* \brief 结束轮询(轮询线程调用)
+		* \return 是否正常结束
+		*/
+		bool zero_station::poll_end()
+		{
+			polling_.store(false);
+			drain_outbox();
+			job_stop();
+			timer_wait_ = -1;
 			const zmq_socket_state state = zmq_state_;
 			config_->closing();
 			return state < zmq_socket_state::Term && state > zmq_socket_state::Empty;
 		}
 
+		/**
+		* \brief 保留套接字重启(轮询线程调用)
+		*/
+		bool zero_station::hot_restart()
+		{
+			//计划与系统站点另有依附于轮询的线程,不在此重启;套接字已失效时须重新绑定
+			if (!json_config::hot_restart || !config_->is_general() ||
+				config_->is_state(station_state::Stop) || get_net_state() != NET_STATE_RUNING ||
+				zmq_state_ >= zmq_socket_state::Term || zmq_state_ <= zmq_socket_state::Empty)
+			{
+				//套接字即将关闭,暂存的请求不能再处理
+				drain_until_.store(0);
+				release_held();
+				return false;
+			}
+			config_->log("hot restart");
+			config_->restart();
+			zmq_state_ = zmq_socket_state::Succeed;
+			//轮询开始时再次登记
+			set_command_thread_end(get_station_name());
+			return true;
+		}
+
 		/**
 		* \brief 工作集合的响应
 		*/
 		void zero_station::response()
 		{
-			vector<shared_char> list;
+			vector<shared_char>& list = response_frames_;
 			zmq_state_ = socket_ex::recv(worker_in_socket_tcp_, list);
 			if (zmq_state_ == zmq_socket_state::TimedOut)
 			{
@@ -321,6 +528,34 @@ namespace agebull
 				config_->error("read work result", socket_ex::state_str(zmq_state_));
 				return;
 			}
+			on_response(list);
+		}
+
+		/**
+		* \brief 共享内存入环的响应
+		*/
+		void zero_station::shm_response()
+		{
+			vector<shared_char>& list = response_frames_;
+			bool corrupt = false;
+			while (shm_.in().pop(list, corrupt))
+			{
+				config_->worker_in++;
+				on_response(list);
+			}
+			if (corrupt)
+			{
+				//不再信任该工作者写入的环,此后只走TCP
+				shm_.detach();
+				use_shm_ = false;
+			}
+		}
+
+		/**
+		* \brief 处理一条工作者返回
+		*/
+		void zero_station::on_response(vector<shared_char>& list)
+		{
 			if (list.size() < 2)
 			{
 				config_->worker_err++;
@@ -332,31 +567,456 @@ namespace agebull
 				plan_end(list);
 			}
 			else {
+				if (!inflight_.empty())
+					trace_response(list);
 				job_end(list);
 			}
 		}
 
+		/**
+		* \brief 断路器检查,断开时计数(轮询线程调用,解析请求之前)
+		*/
+		bool zero_station::breaker_allow()
+		{
+			const breaker_state last = breaker_.state();
+			const bool allow = breaker_.allow(config_->get_ready_works() > 0 || shm_.attached(), latency_histogram::now());
+			if (breaker_.state() != last)
+				breaker_changed();
+			if (!allow)
+				config_->request_broken++;
+			return allow;
+		}
+
+		/**
+		* \brief 向断路器报告一个请求的结果(轮询线程调用)
+		*/
+		void zero_station::breaker_result(bool failed)
+		{
+			if (!breaker_.enable())
+				return;
+			const breaker_state last = breaker_.state();
+			if (failed)
+				breaker_.failure(latency_histogram::now());
+			else
+				breaker_.success(latency_histogram::now());
+			if (breaker_.state() != last)
+				breaker_changed();
+		}
+
+		/**
+		* \brief 断路器状态变化后记录并发布事件
+		*/
+		void zero_station::breaker_changed()
+		{
+			static const char* names[] = { "closed", "open", "half-open" };
+			const int state = static_cast<int>(breaker_.state());
+			config_->breaker_state.store(state, std::memory_order_relaxed);
+			config_->log("breaker", names[state]);
+			char json[96];
+			sprintf(json, R"({"state":"%s","ready_works":%d})", names[state], config_->get_ready_works());
+			//发布经站点调度器的发件箱,不阻塞轮询线程
+			zero_event(zero_net_event::event_station_breaker, "station", config_->station_name_.c_str(), json);
+		}
+
+		/**
+		* \brief 调用者配额检查,拒绝时计数(轮询线程调用,准入检查之前)
+		*/
+		bool zero_station::take_quota(const shared_char& caller, const vector<shared_char>& list, size_t reqer)
+		{
+			if (!quota_.enable())
+				return true;
+			const shared_char& id = reqer > 0 && reqer < list.size() && !list[reqer].empty() ? list[reqer] : caller;
+			const string name(id.get_buffer(), id.size());
+			const int64 now = latency_histogram::now();
+			caller_bucket& bucket = quota_.find(name, now);
+			if (quota_.take(bucket, now))
+				return true;
+			//第一次拒绝时才关联按调用者的计数,正常调用者不产生配置中的条目
+			if (!bucket.rejected)
+			{
+				//ZMQ自动生成的身份是二进制,转为十六进制后才能用于JSON与监控标签
+				bool printable = true;
+				for (char ch : name)
+				{
+					if (ch < 0x20 || ch > 0x7E)
+					{
+						printable = false;
+						break;
+					}
+				}
+				if (printable)
+				{
+					bucket.rejected = config_->get_quota_rejects(name);
+				}
+				else
+				{
+					static const char digits[] = "0123456789ABCDEF";
+					string hex("0x");
+					for (char ch : name)
+					{
+						hex.append(1, digits[(static_cast<uchar>(ch) >> 4) & 0xF]);
+						hex.append(1, digits[static_cast<uchar>(ch) & 0xF]);
+					}
+					bucket.rejected = config_->get_quota_rejects(hex);
+				}
+			}
+			if (bucket.rejected)
+				(*bucket.rejected)++;
+			config_->request_quota++;
+			return false;
+		}
+
+		/**
+		* \brief 准入检查,拒绝时计数(轮询线程调用,发往工作者之前)
+		*/
+		bool zero_station::admit()
+		{
+			if (admission_.admit(inflight_.size()))
+				return true;
+			//已满时清理工作者未返回(丢失)的记录,每秒至多一次,过载时拒绝仍然廉价
+			const int64 now = latency_histogram::now();
+			if (now - inflight_purge_time_ > 1000000LL)
+			{
+				inflight_purge_time_ = now;
+				for (auto iter = inflight_.begin(); iter != inflight_.end();)
+				{
+					if (now - iter->second.request_time > inflight_timeout)
+						iter = inflight_.erase(iter);
+					else
+						++iter;
+				}
+				config_->queue_depth.store(static_cast<int64>(inflight_.size()), std::memory_order_relaxed);
+				if (admission_.admit(inflight_.size()))
+					return true;
+			}
+			config_->request_shed++;
+			return false;
+		}
+
+		/**
+		* \brief 记录请求已发往工作者(轮询线程调用)
+		*/
+		void zero_station::trace_dispatch(vector<shared_char>& list, size_t glid_index)
+		{
+			//断路器半开时,只有真正发往工作者的请求才占用探测名额
+			if (breaker_.enable())
+				breaker_.dispatched(latency_histogram::now());
+			if (glid_index == 0 || glid_index >= list.size() || request_time_ == 0)
+				return;
+			const int64 now = latency_histogram::now();
+			const int64 queue = now - request_time_;
+			config_->latency.queue.record(queue);
+			shared_ptr<latency_set> command;
+			const shared_char& description = list[1];
+			for (size_t idx = 2; idx < description.frame_size() + 2 && idx < list.size(); idx++)
+			{
+				if (description[idx] == ZERO_FRAME_COMMAND)
+				{
+					command = config_->get_command_latency(*list[idx], list[idx].size());
+					break;
+				}
+			}
+			if (command)
+				command->queue.record(queue);
+			if (inflight_.size() >= max_inflight)
+			{
+				//工作者未返回的请求,超时后丢弃;仍然过多时全部丢弃
+				for (auto iter = inflight_.begin(); iter != inflight_.end();)
+				{
+					if (now - iter->second.request_time > inflight_timeout)
+						iter = inflight_.erase(iter);
+					else
+						++iter;
+				}
+				if (inflight_.size() >= max_inflight)
+					inflight_.clear();
+			}
+			inflight_request& item = inflight_[inflight_key(list[0], list[glid_index])];
+			item.request_time = request_time_;
+			item.dispatch_time = now;
+			item.command = command;
+			config_->queue_depth.store(static_cast<int64>(inflight_.size()), std::memory_order_relaxed);
+		}
+
+		/**
+		* \brief 工作者返回时记录延时
+		*/
+		void zero_station::trace_response(vector<shared_char>& list)
+		{
+			const shared_char& description = list[1];
+			size_t glid_index = 0;
+			for (size_t idx = 2; idx < description.frame_size() + 2 && idx < list.size(); idx++)
+			{
+				if (description[idx] == ZERO_FRAME_GLOBAL_ID || description[idx] == ZERO_FRAME_GLOBAL_ID_BIN)
+				{
+					glid_index = idx;
+					break;
+				}
+			}
+			if (glid_index == 0)
+				return;
+			const auto iter = inflight_.find(inflight_key(list[0], list[glid_index]));
+			if (iter == inflight_.end())
+				return;
+			const int64 now = latency_histogram::now();
+			config_->latency.worker.record(now - iter->second.dispatch_time);
+			config_->latency.total.record(now - iter->second.request_time);
+			if (iter->second.command)
+			{
+				iter->second.command->worker.record(now - iter->second.dispatch_time);
+				iter->second.command->total.record(now - iter->second.request_time);
+			}
+			const int64 rtt = now - iter->second.dispatch_time;
+			inflight_.erase(iter);
+			config_->queue_depth.store(static_cast<int64>(inflight_.size()), std::memory_order_relaxed);
+			if (admission_.enable())
+			{
+				//以工作者往返时间调整上限,中心转发的排队只有微秒级,反映不出工作者的积压
+				admission_.sample(rtt, inflight_.size(), now);
+				config_->admit_limit.store(admission_.limit(), std::memory_order_relaxed);
+			}
+			//工作者返回的服务端错误(0xF0以上)计为失败,业务失败不影响断路器
+			breaker_result(description.state() >= ZERO_STATUS_ERROR_ID);
+		}
+
+		/**
+		* \brief 订阅消息的响应(XPUB)
+		* \param batch 是否来自合批端口
+		*/
+		void zero_station::subscribe(bool batch)
+		{
+			vector<shared_char> list;
+			zmq_state_ = socket_ex::recv(batch ? batch_socket_tcp_ : worker_out_socket_tcp_, list);
+			if (zmq_state_ != zmq_socket_state::Succeed)
+			{
+				config_->worker_err++;
+				return;
+			}
+			//订阅消息:首字节1为订阅,0为退订,其后为主题前缀
+			for (auto& frame : list)
+			{
+				if (frame.size() == 0 || (frame[0] != 0 && frame[0] != 1))
+					continue;
+				if (pub_batch_.enable())
+					pub_batch_.subscribe(*frame + 1, frame.size() - 1, frame[0] == 1, batch);
+				//合批端口不补发缓存;同一前缀在间隔内只重发一次,其余延后合并
+				if (frame[0] == 1 && !batch && pub_cache_.enable() && pub_cache_.republish_due(*frame + 1, frame.size() - 1, time_us()))
+					republish(*frame + 1, frame.size() - 1);
+			}
+		}
+
+		/**
+		*\brief 放入发件箱并唤醒轮询线程
+		*/
+		bool zero_station::post_response(const vector<shared_char>& datas, size_t first_index)
+		{
+			//先登记再检查关闭标记,关闭方置标记后等待登记归零,两者不会错过
+			++outbox_users_;
+			if (outbox_closed_.load())
+			{
+				--outbox_users_;
+				return false;
+			}
+			vector<shared_char> frames;
+			frames.reserve(datas.size() - first_index);
+			for (size_t idx = first_index; idx < datas.size(); idx++)
+				frames.push_back(datas[idx]);
+			outbox_.push(std::move(frames));
+			//放入完成后再唤醒
+			wake_poll();
+			--outbox_users_;
+			return true;
+		}
+
+		/**
+		*\brief 唤醒轮询线程(已唤醒而未取出时不重复写入)
+		*/
+		void zero_station::wake_poll()
+		{
+			++outbox_users_;
+			if (!outbox_closed_.load() && !outbox_signaled_.exchange(true) && outbox_bell_ >= 0)
+			{
+				const uint64_t one = 1;
+				if (write(outbox_bell_, &one, sizeof(one)) < 0 && errno != EAGAIN)
+					config_->error("outbox bell", strerror(errno));
+			}
+			--outbox_users_;
+		}
+
+		/**
+		*\brief 关闭发件箱:拒绝新的放入,等待进行中的放入与唤醒结束
+		*/
+		void zero_station::close_outbox()
+		{
+			outbox_closed_.store(true);
+			while (outbox_users_.load() > 0)
+				boost::this_thread::yield();
+			//轮询结束后才放入的消息已无法发送
+			vector<shared_char> datas;
+			size_t dropped = 0;
+			while (outbox_.pop(datas))
+				++dropped;
+			if (dropped > 0)
+				config_->error("outbox closed, dropped", static_cast<int64>(dropped));
+			outbox_signaled_.store(false);
+			if (outbox_bell_ >= 0)
+			{
+				close(outbox_bell_);
+				outbox_bell_ = -1;
+			}
+		}
+
+		/**
+		* \brief 唤醒轮询线程与等待状态的线程(站点或网络状态变化后调用,任意线程)
+		*/
+		void zero_station::wake()
+		{
+			wake_poll();
+			config_->notify_state();
+		}
+
+		/**
+		*\brief 发送发件箱中的全部消息(轮询线程调用)
+		*/
+		void zero_station::drain_outbox()
+		{
+			if (outbox_bell_ >= 0)
+			{
+				uint64_t count;
+				while (read(outbox_bell_, &count, sizeof(count)) > 0)
+				{
+				}
+			}
+			//先清除标记再取出,取出期间的放入会再次唤醒
+			outbox_signaled_.store(false);
+			vector<shared_char> datas;
+			while (outbox_.pop(datas))
+				send_response(datas);
+		}
+
+		/**
+		*\brief 按订阅情况发送原格式或写入合批
+		*/
+		void zero_station::send_batch(const vector<shared_char>& datas, size_t first_index)
+		{
+			zmq_state_ = zmq_socket_state::Succeed;
+			if (first_index >= datas.size())
+				return;
+			const shared_char& title = datas[first_index];
+			if (pub_batch_.legacy_wanted(title))
+				send_response(worker_out_socket_tcp_, datas, first_index);
+			if (pub_batch_.batch_wanted(title) && pub_batch_.push(datas, first_index, time_us()))
+			{
+				pub_batch_.flush(title, [this](const vector<shared_char>& frames)
+				{
+					send_response(batch_socket_tcp_, frames, 0);
+				});
+			}
+		}
+
+		/**
+		*\brief 发送到期(或全部)的合批
+		*/
+		void zero_station::flush_batch(bool all)
+		{
+			pub_batch_.flush(time_us(), all, [this](const vector<shared_char>& frames)
+			{
+				send_response(batch_socket_tcp_, frames, 0);
+			});
+		}
+
+		/**
+		*\brief 轮询超时(毫秒)
+		*/
+		int zero_station::poll_timeout()
+		{
+			int timeout = pub_batch_.enable() ? pub_batch_.poll_timeout(10000) : 10000;
+			if (pub_cache_.enable())
+				timeout = pub_cache_.poll_timeout(timeout);
+			if (timer_wait_ >= 0)
+				timeout = std::min(timeout, timer_wait_);
+			//排空时按截止时间醒来
+			const int64 until = drain_until_.load();
+			if (until > 0)
+			{
+				const int64 left = (until - latency_histogram::now()) / 1000 + 1;
+				timeout = static_cast<int>(std::max<int64>(0, std::min<int64>(timeout, left)));
+			}
+			return timeout;
+		}
+
+		/**
+		*\brief 向订阅者重发缓存的广播
+		*/
+		size_t zero_station::republish(const char* topic, size_t len)
+		{
+			if (!pub_cache_.enable() || worker_out_socket_tcp_ == nullptr)
+				return 0;
+			//XPUB不能只发给新的订阅者,附加重发标记,已收到过该主题的订阅者据此丢弃
+			vector<shared_char> marked;
+			return pub_cache_.foreach(topic, len, false, [this, &marked](const vector<shared_char>& frames)
+			{
+				marked.assign(frames.begin(), frames.end());
+				shared_char description(string(*frames[1], frames[1].size()));
+				description.append_frame(ZERO_FRAME_REPLAY);
+				marked[1] = description;
+				marked.emplace_back("1");
+				config_->worker_out++;
+				send_response(worker_out_socket_tcp_, marked, 0);
+			});
+		}
+
 		/**
 		* \brief 调用集合的响应
 		*/
 		void zero_station::request(ZMQ_HANDLE socket, bool inner)
 		{
-			vector<shared_char> list;
+			vector<shared_char>& list = request_frames_;
 			zmq_state_ = socket_ex::recv(socket, list);
 			if (zmq_state_ != zmq_socket_state::Succeed)
 			{
 				config_->log(socket_ex::state_str(zmq_state_));
 				return;
 			}
-			if (config_->station_state_ == station_state::Pause)
+			request_time_ = latency_histogram::now();
+			//暂停或排空时不再接收新请求,能暂存时恢复后再处理
+			if (config_->station_state_ == station_state::Pause || drain_until_.load() > 0)
 			{
-				send_request_status(socket, *list[0], ZERO_STATUS_PAUSE_ID);
+				if (!hold_request(socket, list, inner))
+					send_request_status(socket, list[0], ZERO_STATUS_PAUSE_ID);
 				return;
 			}
+			if (precheck_request(socket, list, inner))
+				on_request(socket, list, inner);
+		}
+
+		/**
+		* \brief 解析请求之前的检查(断路器),新请求与重放的暂存请求共用
+		*/
+		bool zero_station::precheck_request(ZMQ_HANDLE socket, vector<shared_char>& list, bool inner)
+		{
+			//断路器断开时只看说明帧的命令字节,不再解析帧,以缓存的状态说明帧直接回复
+			if (!breaker_.enable())
+				return true;
+			const size_t descr_index = inner ? 2 : 1;
+			const uchar command = list.size() > descr_index ? list[descr_index].state() : 0;
+			if ((command == ZERO_BYTE_COMMAND_NONE || command == ZERO_BYTE_COMMAND_PROXY) && !breaker_allow())
+			{
+				send_request_status(socket, list[0], ZERO_STATUS_NOT_WORKER_ID);
+				return false;
+			}
+			return true;
+		}
+
+		/**
+		* \brief 处理一个已接收的请求
+		*/
+		void zero_station::on_request(ZMQ_HANDLE socket, vector<shared_char>& list, bool inner)
+		{
 			const size_t list_size = inner ? list.size() - 1 : list.size();
 			if (list_size < 2)
 			{
-				send_request_status(socket, *list[0], ZERO_STATUS_FRAME_INVALID_ID);
+				send_request_status(socket, list[0], ZERO_STATUS_FRAME_INVALID_ID);
 				return;
 			}
 			shared_char description = list[inner ? 2 : 1];
@@ -365,7 +1025,12 @@ namespace agebull
 			const uchar state = description.state();
 			if (state < ZERO_BYTE_COMMAND_NONE || (frame_size + 1) > descr_size || (frame_size + 2) != list_size)
 			{
-				send_request_status(socket, *list[0], ZERO_STATUS_FRAME_INVALID_ID);
+				send_request_status(socket, list[0], ZERO_STATUS_FRAME_INVALID_ID);
+				return;
+			}
+			if (state == ZERO_BYTE_COMMAND_REPLAY)
+			{
+				replay(socket, list, inner);
 				return;
 			}
 			if (station_type_ > STATION_TYPE_DISPATCHER && station_type_ < STATION_TYPE_SPECIAL)
@@ -377,8 +1042,18 @@ namespace agebull
 				}
 				if (state == ZERO_BYTE_COMMAND_GLOBAL_ID)
 				{
-					char global_id[32];
-					sprintf(global_id, "%llx", station_warehouse::get_glogal_id());
+					//开启二进制全局标识时直接回复8字节帧,否则为十六进制文本
+					char global_id[id_codec::hex_size + 1];
+					frame_span id_frame;
+					if (json_config::binary_global_id)
+					{
+						id_codec::to_bin(static_cast<uint64_t>(station_warehouse::get_glogal_id()), global_id);
+						id_frame = frame_span(global_id, id_codec::bin_size);
+					}
+					else
+					{
+						id_frame = frame_span(global_id, id_codec::to_hex(static_cast<uint64_t>(station_warehouse::get_glogal_id()), global_id));
+					}
 
 					size_t reqid = 0, reqer = 0;
 					for (size_t i = 2; i <= frame_size + 2; i++)
@@ -393,16 +1068,153 @@ namespace agebull
 							break;
 						}
 					}
-					send_request_status(socket, *list[0], ZERO_STATUS_OK_ID,
-						global_id,
-						reqid == 0 ? nullptr : *list[reqid],
-						reqer == 0 ? nullptr : *list[reqer]);
+					send_request_status(socket, list[0], ZERO_STATUS_OK_ID,
+						id_frame,
+						reqid == 0 ? frame_span() : frame_span(list[reqid]),
+						reqer == 0 ? frame_span() : frame_span(list[reqer]),
+						frame_span(),
+						json_config::binary_global_id);
 					return;
 				}
 			}
 			job_start(socket, list, inner);
 		}
 
+		/**
+		* \brief 暂存暂停或排空期间的请求
+		*/
+		bool zero_station::hold_request(ZMQ_HANDLE socket, const vector<shared_char>& list, bool inner)
+		{
+			if (held_.size() >= static_cast<size_t>(std::max(json_config::drain_hold_size, 0)))
+				return false;
+			held_.push_back({ socket, inner, request_time_, list });
+			return true;
+		}
+
+		/**
+		* \brief 恢复运行后重新处理暂存的请求
+		*/
+		void zero_station::replay_held()
+		{
+			size_t count = 0;
+			while (!held_.empty() && config_->is_state(station_state::Run) && drain_until_.load() == 0)
+			{
+				held_request item = std::move(held_.front());
+				held_.pop_front();
+				++count;
+				//排队时间包含暂存的时间
+				request_time_ = item.request_time;
+				//与新请求相同的检查,配额与准入在job_start中
+				if (precheck_request(item.socket, item.frames, item.inner))
+					on_request(item.socket, item.frames, item.inner);
+			}
+			if (count > 0)
+				config_->log("replay held requests", std::to_string(count).c_str());
+		}
+
+		/**
+		* \brief 站点不再运行时以暂停状态回复暂存的请求
+		*/
+		void zero_station::release_held()
+		{
+			for (auto& item : held_)
+				send_request_status(item.socket, item.frames[0], ZERO_STATUS_PAUSE_ID);
+			held_.clear();
+		}
+
+		/**
+		* \brief 检查排空是否完成,完成后进入关闭
+		*/
+		void zero_station::check_drain()
+		{
+			const int64 until = drain_until_.load();
+			if (until == 0)
+				return;
+			const bool timeout = latency_histogram::now() >= until;
+			if (!inflight_.empty() && !timeout)
+				return;
+			if (timeout && !inflight_.empty())
+				config_->log("drain timeout", std::to_string(inflight_.size()).c_str());
+			else
+				config_->log("drained");
+			//先清除标记再改变状态,等待关闭的线程以状态变化为准
+			drain_until_.store(0);
+			config_->runtime_state(station_state::Closing);
+		}
+
+		/**
+		* \brief 重放广播的请求
+		*/
+		void zero_station::replay(ZMQ_HANDLE socket, vector<shared_char>& list, bool inner)
+		{
+			if (!pub_cache_.enable())
+			{
+				send_request_status(socket, list[0], ZERO_STATUS_NOT_SUPPORT_ID);
+				return;
+			}
+			const size_t offset = inner ? 1 : 0;
+			shared_char& description = list[offset + 1];
+			size_t rid = 0, gid = 0, cid = 0, tid = 0;
+			for (size_t idx = 2; idx < description.frame_size() + 2; idx++)
+			{
+				switch (description[idx])
+				{
+				case ZERO_FRAME_REQUEST_ID:
+					rid = idx + offset;
+					break;
+				case ZERO_FRAME_REQUESTER:
+					cid = idx + offset;
+					break;
+				case ZERO_FRAME_GLOBAL_ID:
+				case ZERO_FRAME_GLOBAL_ID_BIN:
+					gid = idx + offset;
+					break;
+				case ZERO_FRAME_PUB_TITLE:
+					tid = idx + offset;
+					break;
+				}
+			}
+			//重放记录只回给请求者(不经广播),无主题帧时为全部,数量受重放环容量限制
+			string records;
+			const size_t cnt = pub_cache_.foreach(tid == 0 ? nullptr : *list[tid], tid == 0 ? 0 : list[tid].size(), true,
+				[&records](const vector<shared_char>& frames)
+			{
+				publish_batch::append_record(records, frames, 0);
+			});
+			char msg[32];
+			sprintf(msg, "%zu", cnt);
+			//回复:[地址][说明帧][状态][请求ID][全局ID][请求者][记录集],内部调用时说明帧不在list[1],逐帧组装
+			vector<shared_char> reply;
+			reply.reserve(7);
+			reply.emplace_back(list[0]);
+			shared_char result_description;
+			result_description.alloc_frame_1(ZERO_STATUS_OK_ID, ZERO_FRAME_STATUS);
+			reply.emplace_back();
+			reply.emplace_back(msg);
+			if (rid != 0)
+			{
+				result_description.append_frame(ZERO_FRAME_REQUEST_ID);
+				reply.emplace_back(list[rid]);
+			}
+			if (gid != 0)
+			{
+				result_description.append_frame(description[gid - offset] == ZERO_FRAME_GLOBAL_ID_BIN ? ZERO_FRAME_GLOBAL_ID_BIN : ZERO_FRAME_GLOBAL_ID);
+				reply.emplace_back(list[gid]);
+			}
+			if (cid != 0)
+			{
+				result_description.append_frame(ZERO_FRAME_REQUESTER);
+				reply.emplace_back(list[cid]);
+			}
+			result_description.append_frame(ZERO_FRAME_BATCH);
+			shared_char data(records.length());
+			if (!records.empty())
+				memcpy(data.get_buffer(), records.c_str(), records.length());
+			reply.emplace_back(data);
+			reply[1] = result_description;
+			send_request_result(socket, reply);
+		}
+
 		/**
 		* \brief 工作进入计划
 		*/
@@ -412,7 +1224,7 @@ namespace agebull
 			list[1].append_frame(ZERO_FRAME_STATION_ID);
 			if (socket_ex::send(plan_socket_inproc_, list) != zmq_socket_state::Succeed)
 			{
-				send_request_status(socket, *list[0], ZERO_STATUS_SEND_ERROR_ID);
+				send_request_status(socket, list[0], ZERO_STATUS_SEND_ERROR_ID);
 				return;
 			}
 
@@ -424,7 +1236,7 @@ namespace agebull
 			}
 			else
 			{
-				send_request_status(socket, *list[0], ZERO_STATUS_RECV_ERROR_ID);
+				send_request_status(socket, list[0], ZERO_STATUS_RECV_ERROR_ID);
 			}
 		}
 		/**
@@ -432,9 +1244,8 @@ namespace agebull
 		*/
 		void zero_station::plan_end(vector<shared_char>& list)
 		{
-			shared_char description = list[1];
 			list.emplace_back(station_name_);
-			description.append_frame(ZERO_FRAME_STATION_ID);
+			list[1].append_frame(ZERO_FRAME_STATION_ID);
 			if (socket_ex::send(plan_socket_inproc_, list) != zmq_socket_state::Succeed)
 			{
 				config_->error("send to plan dispatcher failed", desc_str(false, list[1].get_buffer(), list.size()));
@@ -464,6 +1275,8 @@ namespace agebull
 			config_->log("resume");
 			config_->runtime_state(station_state::Run);
 			zero_event(zero_net_event::event_station_resume, "station", config_->station_name_.c_str(), nullptr);
+			//轮询线程立即处理暂存的请求
+			wake();
 			return true;
 		}
 
@@ -483,10 +1296,28 @@ namespace agebull
 				return false;
 			}
 			config_->log("close");
-			config_->runtime_state(station_state::Closing);
+			//排空:不再接收新请求,已发往工作者的请求返回(或超时)后再关闭;没有轮询线程时无人排空
+			if (json_config::drain_timeout > 0 && !config_->is_state(station_state::Stop) && polling_.load())
+				drain_until_.store(latency_histogram::now() + json_config::drain_timeout * 1000LL);
+			else
+				config_->runtime_state(station_state::Closing);
 			zero_event(zero_net_event::event_station_closing, "station", config_->station_name_.c_str(), nullptr);
-			while (waiting && config_->is_state(station_state::Closing))
-				thread_sleep(200);
+			//轮询线程立即醒来,排空完成或直接结束,不等轮询超时
+			wake();
+			if (!waiting)
+				return true;
+			//排空的截止时间之后再留出轮询线程结束的余量
+			const int64 deadline = latency_histogram::now() + (std::max(json_config::drain_timeout, 0) + drain_close_margin) * 1000LL;
+			while (!config_->wait_state(1000, [this]() { return drain_until_.load() == 0 && !config_->is_state(station_state::Closing); }))
+			{
+				if (polling_.load() && latency_histogram::now() < deadline)
+					continue;
+				//轮询线程已退出或未按时结束排空,自行结束排空并不再等待
+				if (drain_until_.exchange(0) != 0)
+					config_->runtime_state(station_state::Closing);
+				config_->log("close wait timeout");
+				break;
+			}
 			return true;
 		}
 
@@ -5,6 +5,13 @@
 #include "zmq_extend.h"
 #include "zero_plan.h"
 #include "station_warehouse.h"
+#include "publish_cache.h"
+#include "publish_batch.h"
+#include "admission_control.h"
+#include "caller_quota.h"
+#include "circuit_breaker.h"
+#include "shm_ring.h"
+#include "../ext/mpsc_queue.h"
 
 
 
@@ -12,12 +19,55 @@ namespace agebull
 {
 	namespace zmq_net
 	{
+		/**
+		* \brief 已发往工作者,尚未返回的请求(用于计算延时)
+		*/
+		struct inflight_request
+		{
+			/**
+			* \brief 请求进入的时间(微秒)
+			*/
+			int64 request_time;
+			/**
+			* \brief 发往工作者的时间(微秒)
+			*/
+			int64 dispatch_time;
+			/**
+			* \brief 命令的延时统计(未按命令统计时为空)
+			*/
+			shared_ptr<latency_set> command;
+		};
+
+		/**
+		* \brief 暂停或排空期间暂存的请求(恢复运行后重新处理)
+		*/
+		struct held_request
+		{
+			/**
+			* \brief 请求进入的套接字
+			*/
+			ZMQ_HANDLE socket;
+			/**
+			* \brief 是否进程内调用
+			*/
+			bool inner;
+			/**
+			* \brief 请求进入的时间(微秒)
+			*/
+			int64 request_time;
+			/**
+			* \brief 请求帧
+			*/
+			vector<shared_char> frames;
+		};
+
 		/**
 		* \brief 表示一个基于ZMQ的网络站点
 		*/
 		class zero_station
 		{
 			friend class station_warehouse;
+			friend class station_reactor;
 			/**
 			* \brief 外部SOCKET类型
 			*/
@@ -46,10 +96,6 @@ namespace agebull
 			*/
 			boost::interprocess::interprocess_semaphore task_semaphore_;
 		private:
-			/**
-			* \brief 实例队列访问锁
-			*/
-			boost::mutex send_mutex_;
 			/**
 			* \brief 实例队列访问锁
 			*/
@@ -74,11 +120,11 @@ namespace agebull
 			* \brief 调用句柄
 			*/
 			ZMQ_HANDLE request_socket_inproc_;
+		private:
 			/**
-			* \brief 调用句柄
+			* \brief 是否已同时绑定IPC地址
 			*/
-			//ZMQ_HANDLE request_socket_ipc_;
-		private:
+			bool use_ipc_;
 
 			/**
 			* \brief 调用句柄
@@ -94,9 +140,148 @@ namespace agebull
 			*/
 			ZMQ_HANDLE worker_out_socket_tcp_;
 			/**
-			* \brief 工作句柄
+			* \brief 广播合批句柄(XPUB,只发合批记录集)
+			*/
+			ZMQ_HANDLE batch_socket_tcp_;
+
+			/**
+			* \brief 广播缓存(仅广播类站点启用,仅轮询线程使用)
+			*/
+			publish_cache pub_cache_;
+
+			/**
+			* \brief 广播合批(仅广播类站点启用,仅轮询线程使用)
+			*/
+			publish_batch pub_batch_;
+
+			/**
+			* \brief 准入控制(仅API类站点启用,仅轮询线程使用)
+			*/
+			admission_control admission_;
+
+			/**
+			* \brief 按调用者的配额(仅API类站点启用,仅轮询线程使用)
+			*/
+			caller_quota quota_;
+
+			/**
+			* \brief 断路器(仅API类站点启用,仅轮询线程使用)
+			*/
+			circuit_breaker breaker_;
+
+			/**
+			* \brief 上次清理超时未返回记录的时间(微秒,仅轮询线程使用)
+			*/
+			int64 inflight_purge_time_;
+
+			/**
+			* \brief 是否启用共享内存环(仅API站点)
+			*/
+			bool use_shm_;
+
+			/**
+			* \brief 与本机工作者通讯的共享内存环(仅轮询线程使用)
+			*/
+			shm_segment shm_;
+
+			/**
+			* \brief 上次检查共享内存工作者是否存活的时间(微秒,仅轮询线程使用)
+			*/
+			int64 shm_check_time_;
+
+			/**
+			* \brief 请求的接收帧(仅轮询线程使用,跨消息复用存储)
+			*/
+			vector<shared_char> request_frames_;
+
+			/**
+			* \brief 工作者返回的接收帧(仅轮询线程使用,跨消息复用存储)
+			*/
+			vector<shared_char> response_frames_;
+
+			/**
+			* \brief 当前请求进入的时间(微秒,仅轮询线程使用)
+			*/
+			int64 request_time_;
+
+			/**
+			* \brief 未返回的请求,键为调用者与全局标识(仅轮询线程使用)
+			*/
+			boost::unordered_map<string, inflight_request> inflight_;
+
+			/**
+			* \brief 未返回请求的数量上限,超过时清理超时的记录
+			*/
+			static const size_t max_inflight = 65536;
+
+			/**
+			* \brief 未返回请求的超时(微秒),超时的记录不再计入延时
+			*/
+			static const int64 inflight_timeout = 60000000LL;
+
+			/**
+			* \brief 等待关闭时在排空超时之外留给轮询线程结束的时间(毫秒)
+			*/
+			static const int drain_close_margin = 3000;
+
+			/**
+			* \brief 其它线程的发送(由轮询线程取出后发送,套接字只由轮询线程使用)
 			*/
-			//ZMQ_HANDLE worker_out_socket_ipc_;
+			mpsc_queue<vector<shared_char>> outbox_;
+
+			/**
+			* \brief 发件箱与状态变化的唤醒(eventfd,加入轮询)
+			*/
+			int outbox_bell_;
+
+			/**
+			* \brief 发件箱是否已唤醒(唤醒后到取出前的放入不再写eventfd)
+			*/
+			std::atomic<bool> outbox_signaled_;
+
+			/**
+			* \brief 发件箱是否已关闭(关闭后其它线程的放入与唤醒直接失败)
+			*/
+			std::atomic<bool> outbox_closed_;
+
+			/**
+			* \brief 正在放入或唤醒的其它线程数量(关闭eventfd前等待其归零)
+			*/
+			std::atomic<int> outbox_users_;
+
+			/**
+			* \brief 排空的截止时间(微秒,0 表示未在排空)
+			* \remark 关闭时不再接收新请求,继续转发工作者返回,直到未返回请求为空或到达截止时间才真正关闭
+			*/
+			std::atomic<int64> drain_until_;
+
+			/**
+			* \brief 是否有线程正在轮询本站点(没有时关闭不等待排空)
+			*/
+			std::atomic<bool> polling_;
+
+			/**
+			* \brief 定时工作要求的最长轮询等待(毫秒,小于0 表示没有,仅轮询线程使用)
+			*/
+			int timer_wait_;
+
+			/**
+			* \brief 暂停或排空期间暂存的请求(仅轮询线程使用,上限为json_config::drain_hold_size)
+			*/
+			std::deque<held_request> held_;
+
+			/**
+			* \brief 当前线程正在轮询的站点
+			*/
+			static thread_local zero_station* polling_station_;
+			/**
+			* \brief 设置当前线程正在轮询的站点,帧内存分配同时计入该站点
+			*/
+			static void set_polling(zero_station* station)
+			{
+				polling_station_ = station;
+				frame_pool::attribute(station == nullptr ? nullptr : &station->config_->pool_counters);
+			}
 		protected:
 			/**
 			* \brief 实例队列访问锁
@@ -173,7 +358,7 @@ namespace agebull
 			*/
 			void set_station_state(station_state state) const
 			{
-				config_->station_state_ = state;
+				config_->set_state(state);
 			}
 
 			/**
@@ -207,6 +392,51 @@ namespace agebull
 			* \brief 析构
 			*/
 			bool destruct();
+		private:
+			/**
+			* \brief 开始轮询(轮询线程调用)
+			*/
+			void poll_start();
+
+			/**
+			* \brief 轮询前的准备
+			* \return 能否等待(共享内存入环非空时不能等待)
+			*/
+			bool poll_prepare();
+
+			/**
+			* \brief 处理一次轮询的结果
+			* \param state zmq_poll的返回值(共享轮询时为本站点就绪的数量)
+			* \param items 本站点的轮询节点(与poll_items_顺序一致)
+			* \return 是否继续轮询
+			*/
+			bool on_poll(int state, zmq_pollitem_t* items);
+
+			/**
+			* \brief 结束轮询(轮询线程调用)
+			* \return 是否正常结束
+			*/
+			bool poll_end();
+
+			/**
+			* \brief 保留套接字重启(轮询线程调用)
+			* \remark
+			* 业务站点的轮询正常结束(状态变化或非致命错误),而网络仍在运行且站点未关停时,
+			* 不解绑与关闭套接字,也不离开仓库,只重置运行状态后继续轮询:
+			* 套接字中排队的消息,未返回请求表,发件箱与共享内存环都保留,客户端不会重连.
+			* \return 是否已重启(否则按原方式清理后重新绑定或关闭)
+			*/
+			bool hot_restart();
+
+			/**
+			* \brief 追加绑定IPC地址(未启用时忽略)
+			*/
+			void bind_ipc(ZMQ_HANDLE socket, const char* name);
+
+			/**
+			* \brief 解除IPC地址的绑定
+			*/
+			void unbind_ipc(ZMQ_HANDLE socket, const char* name);
 		public:
 			/**
 			* \brief 暂停
@@ -220,6 +450,10 @@ namespace agebull
 			* \brief 结束
 			*/
 			virtual bool close(bool waiting);
+			/**
+			* \brief 唤醒轮询线程与等待状态的线程(站点或网络状态变化后调用,任意线程)
+			*/
+			void wake();
 		private:
 			/**
 			*\brief 发送消息
@@ -242,14 +476,28 @@ namespace agebull
 			*/
 			bool send_response(const vector<shared_char>& datas, const  size_t first_index = 0)
 			{
-				if (!config_->hase_ready_works())
+				if (!config_->hase_ready_works() && !shm_.attached())
 				{
 					return false;
 				}
-				boost::lock_guard<boost::mutex> guard(send_mutex_);
+				//套接字只由轮询线程使用,其它线程交给发件箱
+				if (polling_station_ != this)
+				{
+					return post_response(datas, first_index);
+				}
 				config_->worker_out++;
-
-				send_response(worker_out_socket_tcp_, datas, first_index);
+				//本机工作者已连接时优先走共享内存,环满时退回套接字
+				if (use_shm_ && shm_.send(datas, first_index))
+				{
+					zmq_state_ = zmq_socket_state::Succeed;
+					return true;
+				}
+				if (pub_batch_.enable())
+					send_batch(datas, first_index);
+				else
+					send_response(worker_out_socket_tcp_, datas, first_index);
+				if (pub_cache_.enable())
+					pub_cache_.push(datas, first_index);
 				//ZMQ_HANDLE socket[2] = { worker_out_socket_tcp_ ,worker_out_socket_ipc_ };
 				////#pragma omp parallel  for schedule(static,2)
 				//for (size_t i = 0; i < 2; i++)
@@ -259,12 +507,56 @@ namespace agebull
 				return zmq_state_ == zmq_socket_state::Succeed;
 			}
 
+			/**
+			*\brief 向订阅者重发缓存的最后值(新订阅触发,附加重发标记)
+			* \param topic 主题前缀(空表示全部)
+			* \param len 前缀长度
+			* \return 重发的消息数量
+			*/
+			size_t republish(const char* topic, size_t len);
+		private:
+			/**
+			*\brief 放入发件箱并唤醒轮询线程
+			* \return 发件箱已关闭时返回false
+			*/
+			bool post_response(const vector<shared_char>& datas, size_t first_index);
+
+			/**
+			*\brief 唤醒轮询线程(已唤醒而未取出时不重复写入)
+			*/
+			void wake_poll();
+
+			/**
+			*\brief 关闭发件箱:拒绝新的放入,等待进行中的放入与唤醒结束
+			*/
+			void close_outbox();
+
+			/**
+			*\brief 发送发件箱中的全部消息(轮询线程调用)
+			*/
+			void drain_outbox();
+
+			/**
+			*\brief 按订阅情况发送原格式或写入合批
+			*/
+			void send_batch(const vector<shared_char>& datas, size_t first_index);
+
+			/**
+			*\brief 发送到期(或全部)的合批
+			*/
+			void flush_batch(bool all);
+
+			/**
+			*\brief 轮询超时(毫秒)
+			*/
+			int poll_timeout();
+		protected:
+
 			/**
 			* \brief 发送
 			*/
 			bool send_request_result(ZMQ_HANDLE socket, vector<shared_char>& ls)
 			{
-				boost::lock_guard<boost::mutex> guard(send_mutex_);
 				config_->request_out++;
 				zmq_state_ = socket_ex::send(socket, ls);
 
@@ -278,10 +570,10 @@ namespace agebull
 			/**
 			* \brief 发送帧
 			*/
-			bool send_request_status(ZMQ_HANDLE socket, const char* addr, uchar state, const char* global_id = nullptr, const char* req_id = nullptr, const char* reqer = nullptr, const char* msg = nullptr)
+			bool send_request_status(ZMQ_HANDLE socket, frame_span addr, uchar state, frame_span global_id = frame_span(), frame_span req_id = frame_span(), frame_span reqer = frame_span(), frame_span msg = frame_span(), bool global_id_bin = false)
 			{
 				++config_->request_out;
-				zmq_state_ = socket_ex::send_status(socket, addr, state, global_id, req_id, reqer, msg);
+				zmq_state_ = socket_ex::send_status(socket, addr, state, global_id, req_id, reqer, msg, global_id_bin);
 				if (zmq_state_ == zmq_socket_state::Succeed)
 					return true;
 				++config_->request_err;
@@ -291,25 +583,33 @@ namespace agebull
 			}
 			/**
 			* \brief 发送帧
+			* \param addr 调用者地址(ROUTER标识为二进制,须带长度)
 			*/
-			bool send_request_status(ZMQ_HANDLE socket, const char* addr, uchar state, vector<shared_char>& ls, size_t glbid_idx, size_t reqid_idx, size_t reqer_idx, const char* msg = nullptr)
+			bool send_request_status(ZMQ_HANDLE socket, frame_span addr, uchar state, vector<shared_char>& ls, size_t glbid_idx, size_t reqid_idx, size_t reqer_idx, const char* msg = nullptr)
 			{
 				return send_request_status(socket, addr, state,
-					glbid_idx == 0 ? nullptr : *ls[glbid_idx],
-					reqid_idx == 0 ? nullptr : *ls[reqid_idx],
-					reqer_idx == 0 ? nullptr : *ls[reqer_idx],
-					msg);
+					glbid_idx == 0 ? frame_span() : frame_span(ls[glbid_idx]),
+					reqid_idx == 0 ? frame_span() : frame_span(ls[reqid_idx]),
+					reqer_idx == 0 ? frame_span() : frame_span(ls[reqer_idx]),
+					msg, is_global_id_bin(ls, glbid_idx));
 			}
 			/**
 			* \brief 发送帧
 			*/
 			bool send_request_status(ZMQ_HANDLE socket, uchar state, vector<shared_char>& ls, size_t glbid_idx, size_t reqid_idx, size_t reqer_idx, const char* msg = nullptr)
 			{
-				return send_request_status(socket, *ls[0], state,
-					glbid_idx == 0 ? nullptr : *ls[glbid_idx],
-					reqid_idx == 0 ? nullptr : *ls[reqid_idx],
-					reqer_idx == 0 ? nullptr : *ls[reqer_idx],
-					msg);
+				return send_request_status(socket, ls[0], state,
+					glbid_idx == 0 ? frame_span() : frame_span(ls[glbid_idx]),
+					reqid_idx == 0 ? frame_span() : frame_span(ls[reqid_idx]),
+					reqer_idx == 0 ? frame_span() : frame_span(ls[reqer_idx]),
+					msg, is_global_id_bin(ls, glbid_idx));
+			}
+			/**
+			* \brief 请求中的全局标识帧是否为二进制(说明帧为ls[1],序号与说明帧中的位置一致)
+			*/
+			static bool is_global_id_bin(vector<shared_char>& ls, size_t glbid_idx)
+			{
+				return glbid_idx > 1 && ls.size() > 1 && ls[1][glbid_idx] == ZERO_FRAME_GLOBAL_ID_BIN;
 			}
 		private:
 			/**
@@ -317,11 +617,58 @@ namespace agebull
 			*/
 			void response();
 
+			/**
+			* \brief 共享内存入环的响应
+			*/
+			void shm_response();
+
+			/**
+			* \brief 处理一条工作者返回
+			*/
+			void on_response(vector<shared_char>& list);
+
 			/**
 			* \brief 调用集合的响应
 			*/
 			void request(ZMQ_HANDLE socket, bool inner);
 
+			/**
+			* \brief 处理一个已接收的请求
+			*/
+			void on_request(ZMQ_HANDLE socket, vector<shared_char>& list, bool inner);
+
+			/**
+			* \brief 暂存暂停或排空期间的请求
+			* \return 暂存已满(或未启用)时返回false
+			*/
+			bool hold_request(ZMQ_HANDLE socket, const vector<shared_char>& list, bool inner);
+
+			/**
+			* \brief 恢复运行后重新处理暂存的请求
+			*/
+			void replay_held();
+
+			/**
+			* \brief 站点不再运行时以暂停状态回复暂存的请求
+			*/
+			void release_held();
+
+			/**
+			* \brief 检查排空是否完成,完成后进入关闭
+			*/
+			void check_drain();
+
+			/**
+			* \brief 订阅消息的响应(XPUB)
+			* \param batch 是否来自合批端口
+			*/
+			void subscribe(bool batch);
+
+			/**
+			* \brief 重放广播的请求
+			*/
+			void replay(ZMQ_HANDLE socket, vector<shared_char>& list, bool inner);
+
 		protected:
 
 			/**
@@ -334,7 +681,86 @@ namespace agebull
 			virtual void job_end(vector<shared_char>& list)
 			{
 			}
+
+			/**
+			* \brief 定时工作(每次轮询后由轮询线程调用)
+			* \param now 当前时间(微秒)
+			* \return 下次调用前最长的等待(毫秒),小于0 表示没有定时工作
+			*/
+			virtual int job_timer(int64 now)
+			{
+				return -1;
+			}
+
+			/**
+			* \brief 结束轮询时(关闭或热重启之前)由轮询线程调用,回复仍在等待的请求
+			*/
+			virtual void job_stop()
+			{
+			}
+
+			/**
+			* \brief 断路器检查,断开时计数(轮询线程调用,解析请求之前)
+			* \return 断开时返回false,调用者应回复ZERO_STATUS_NOT_WORKER_ID
+			*/
+			bool breaker_allow();
+
+			/**
+			* \brief 解析请求之前的检查(断路器),新请求与重放的暂存请求共用
+			* \return 未通过时返回false,已回复调用者
+			*/
+			bool precheck_request(ZMQ_HANDLE socket, vector<shared_char>& list, bool inner);
+
+			/**
+			* \brief 向断路器报告一个请求的结果(轮询线程调用)
+			* \param failed 发送失败或工作者返回错误
+			*/
+			void breaker_result(bool failed);
+
+			/**
+			* \brief 断路器状态变化后记录并发布事件
+			*/
+			void breaker_changed();
+
+			/**
+			* \brief 调用者配额检查,拒绝时计数(轮询线程调用,准入检查之前)
+			* \param caller 调用者的ZMQ身份
+			* \param list 请求帧
+			* \param reqer 请求者帧的序号(0 表示没有,按ZMQ身份计)
+			* \return 超过配额时返回false,调用者应回复ZERO_STATUS_QUOTA_ID
+			*/
+			bool take_quota(const shared_char& caller, const vector<shared_char>& list, size_t reqer);
+
+			/**
+			* \brief 准入检查,拒绝时计数(轮询线程调用,发往工作者之前)
+			* \return 未返回的请求已达上限时返回false,调用者应回复ZERO_STATUS_OVERLOAD_ID
+			*/
+			bool admit();
+
+			/**
+			* \brief 记录请求已发往工作者(轮询线程调用)
+			* \param list 请求帧,list[0]为调用者,list[1]为说明帧
+			* \param glid_index 全局标识帧的序号
+			*/
+			void trace_dispatch(vector<shared_char>& list, size_t glid_index);
+			/**
+			* \brief 未返回请求的键(调用者长度,调用者,全局标识)
+			*/
+			static string inflight_key(const shared_char& caller, const shared_char& global_id)
+			{
+				string key;
+				key.reserve(caller.size() + global_id.size() + 1);
+				key.append(1, static_cast<char>(caller.size()));
+				key.append(*caller, caller.size());
+				key.append(*global_id, global_id.size());
+				return key;
+			}
 		private:
+			/**
+			* \brief 工作者返回时记录延时
+			*/
+			void trace_response(vector<shared_char>& list);
+
 			/**
 			* \brief 工作进入计划
 			*/
@@ -104,6 +104,16 @@ namespace agebull
 				return true;
 			}
 
+			bool bind_ipc(ZMQ_HANDLE socket, const char* station, const char* name)
+			{
+				acl::string dir;
+				dir.format("%sipc", json_config::root_path.c_str());
+				mkdir(dir.c_str(), 00777);
+				make_ipc_address(address, station, name);
+				log_msg2("[%s] : bind_ipc > %s", station, address);
+				return zmq_bind(socket, address) >= 0;
+			}
+
 			void close_res_socket(ZMQ_HANDLE& socket, const char* addr)
 			{
 				zmq_unbind(socket, addr);
@@ -3,6 +3,7 @@
 #define _ZMQ_EXTEND_H_
 #include "zero_net.h"
 #include "../ext/shared_char.h"
+#include "../cfg/json_config.h"
 namespace agebull
 {
 	namespace zmq_net
@@ -148,10 +149,10 @@ namespace agebull
 		};
 
 
-/*#define make_ipc_address(addr,type,name)\
+#define make_ipc_address(addr,type,name)\
 			char addr[MAX_PATH];\
 			sprintf(addr, "ipc://%sipc/%s_%s.ipc", json_config::root_path.c_str(),type, name)
-*/
+
 
 #define make_inproc_address(addr,name)\
 			char addr[MAX_PATH];\
@@ -161,6 +162,132 @@ namespace agebull
 			char identity[MAX_PATH];\
 			sprintf(identity, "%s_%s", type, name)
 
+		/**
+		* \brief 帧内容与长度(用于发送时避免重复计算长度,data为nullptr表示没有该帧)
+		*/
+		struct frame_span
+		{
+			const char* data;
+			size_t size;
+
+			frame_span()
+				: data(nullptr)
+				, size(0)
+			{
+			}
+
+			frame_span(const char* str)
+				: data(str)
+				, size(str == nullptr ? 0 : strlen(str))
+			{
+			}
+
+			frame_span(const char* buffer, size_t len)
+				: data(buffer)
+				, size(len)
+			{
+			}
+
+			frame_span(const shared_char& frame)
+				: data(*frame)
+				, size(frame.size())
+			{
+			}
+		};
+
+		/**
+		* \brief 读取全局标识帧(type 为说明帧中的帧类型,二进制帧按8字节大端解码,否则按十六进制文本解码)
+		*/
+		inline int64 read_global_id(const shared_char& frame, char type)
+		{
+			return static_cast<int64>(type == ZERO_FRAME_GLOBAL_ID_BIN && frame.size() == id_codec::bin_size
+				? id_codec::from_bin(*frame)
+				: id_codec::from_hex(*frame, frame.size()));
+		}
+
+		/**
+		* \brief 写入全局标识帧(按配置为二进制或十六进制文本)
+		* \return 说明帧中对应的帧类型
+		*/
+		inline char write_global_id(shared_char& frame, int64 id)
+		{
+			if (json_config::binary_global_id)
+			{
+				frame.set_int64b(id);
+				return ZERO_FRAME_GLOBAL_ID_BIN;
+			}
+			frame.set_int64x(id);
+			return ZERO_FRAME_GLOBAL_ID;
+		}
+
+		/**
+		* \brief 状态回复说明帧的静态缓存:按状态与附带帧(请求者,消息,请求标识,全局标识)的组合预先生成
+		*/
+		class status_descriptions
+		{
+			/**
+			* \brief 说明帧
+			*/
+			uchar frames_[256][32][8];
+			/**
+			* \brief 各组合的说明帧长度
+			*/
+			size_t sizes_[32];
+
+			status_descriptions()
+			{
+				static const uchar types[4] = { ZERO_FRAME_REQUESTER, ZERO_FRAME_STATUS, ZERO_FRAME_REQUEST_ID, ZERO_FRAME_GLOBAL_ID };
+				memset(frames_, 0, sizeof(frames_));
+				for (int mask = 0; mask < 32; mask++)
+				{
+					for (int state = 0; state < 256; state++)
+					{
+						uchar* description = frames_[state][mask];
+						description[1] = static_cast<uchar>(state);
+						int idx = 2;
+						for (int bit = 0; bit < 4; bit++)
+						{
+							if (mask & (1 << bit))
+								description[idx++] = bit == 3 && (mask & 16) ? ZERO_FRAME_GLOBAL_ID_BIN : types[bit];
+						}
+						description[0] = static_cast<uchar>(idx - 2);
+						description[idx] = ZERO_FRAME_END;
+						sizes_[mask] = static_cast<size_t>(idx + 1);
+					}
+				}
+			}
+		public:
+			/**
+			* \brief 单例
+			*/
+			static const status_descriptions& instance()
+			{
+				static status_descriptions descriptions;
+				return descriptions;
+			}
+
+			/**
+			* \brief 取得说明帧
+			* \param state 状态
+			* \param mask 附带帧的组合(1 请求者,2 消息,4 请求标识,8 全局标识,16 全局标识为二进制)
+			* \param len 说明帧长度
+			*/
+			const uchar* get(uchar state, int mask, size_t& len) const
+			{
+				len = sizes_[mask];
+				return frames_[state][mask];
+			}
+
+			/**
+			* \brief 组合中最后一个附带帧的序号(-1 表示没有附带帧)
+			*/
+			static int last_frame(int mask)
+			{
+				static const signed char lasts[16] = { -1, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3 };
+				return lasts[mask & 15];
+			}
+		};
+
 		namespace socket_ex
 		{
 
@@ -364,23 +491,21 @@ namespace agebull
 				return socket;
 			}
 			/**
-			* \brief 生成用于本机调用的套接字
+			* \brief 在已绑定TCP的套接字上追加绑定本机IPC地址
+			* \param socket 套接字
+			* \param station 站点名称
+			* \param name 用途(req/out/in)
 			*/
-			//inline ZMQ_HANDLE create_req_socket_ipc(const char* station, const char* name, int type)
-			//{
-			//	make_ipc_address(address, station, name);
-			//	make_zmq_identity(identity, station, name);
-			//	return create_req_socket(address, type, identity);
-			//}
+			bool bind_ipc(ZMQ_HANDLE socket, const char* station, const char* name);
+
 			/**
-			* \brief 生成用于本机调用的套接字
+			* \brief 解除IPC地址的绑定
 			*/
-			//inline ZMQ_HANDLE create_res_socket_ipc(const char* station, const char* name, int type)
-			//{
-			//	make_ipc_address(address, station, name);
-			//	make_zmq_identity(identity, station, name);
-			//	return create_res_socket(address, type, identity);
-			//}
+			inline void unbind_ipc(ZMQ_HANDLE socket, const char* station, const char* name)
+			{
+				make_ipc_address(address, station, name);
+				zmq_unbind(socket, address);
+			}
 			/**
 			* \brief 生成用于本机调用的套接字
 			*/
@@ -429,10 +554,14 @@ namespace agebull
 
 			/**
 			* \brief 接收
+			* \remark
+			* ls中原有的帧被依次覆盖,结束时截断为实际帧数;独占且容量足够的帧直接复用其存储,
+			* 因此重复使用同一个ls接收时,稳定状态下不再分配内存
 			*/
 			inline zmq_socket_state recv(ZMQ_HANDLE socket, vector<shared_char>& ls, int flag = 0)
 			{
 				size_t size = sizeof(int);
+				size_t count = 0;
 				int more;
 				do
 				{
@@ -440,20 +569,27 @@ namespace agebull
 					int re = zmq_msg_init(&msg);
 					if (re < 0)
 					{
+						ls.resize(count);
 						return zmq_socket_state::NoBufs;
 					}
 					re = zmq_msg_recv(&msg, socket, flag);
 					if (re < 0)
 					{
+						zmq_msg_close(&msg);
+						ls.resize(count);
 						return check_zmq_error();
 					}
-					if (re == 0)
+					if (count < ls.size())
+						ls[count].assign(zmq_msg_data(&msg), static_cast<size_t>(re));
+					else if (re == 0)
 						ls.emplace_back();
 					else
 						ls.emplace_back(msg);
+					++count;
 					zmq_msg_close(&msg);
 					zmq_getsockopt(socket, ZMQ_RCVMORE, &more, &size);
 				} while (more != 0);
+				ls.resize(count);
 				return zmq_socket_state::Succeed;
 			}
 
@@ -573,105 +709,48 @@ namespace agebull
 				return zmq_socket_state::Succeed;
 			}
 			/**
-			* \brief 发送帧
+			* \brief 发送状态回复
+			* \remark 说明帧取自status_descriptions的静态缓存,以zmq_msg_init_data零复制发送;其余帧按长度发送,不再计算strlen
 			*/
-			inline zmq_socket_state send_status(ZMQ_HANDLE socket, const char* addr, uchar state, const char* global_id, const char* req_id, const char* reqer, const char* msg)
+			inline zmq_socket_state send_status(ZMQ_HANDLE socket, frame_span addr, uchar state, frame_span global_id, frame_span req_id, frame_span reqer, frame_span msg, bool global_id_bin = false)
 			{
-				uchar descirpt[8];
-				descirpt[1] = state;
-
-				int idx = 2;
-				if (reqer != nullptr)
-				{
-					descirpt[idx++] = ZERO_FRAME_REQUESTER;
-				}
-				if (msg != nullptr)
+				//顺序与说明帧一致
+				const frame_span frames[4] = { reqer, msg, req_id, global_id };
+				int mask = 0;
+				for (int idx = 0; idx < 4; idx++)
 				{
-					descirpt[idx++] = ZERO_FRAME_STATUS;
-				}
-				if (req_id != nullptr)
-				{
-					descirpt[idx++] = ZERO_FRAME_REQUEST_ID;
-				}
-				if (global_id != nullptr)
-				{
-					descirpt[idx++] = ZERO_FRAME_GLOBAL_ID;
-				}
-				descirpt[0] = static_cast<char>(idx - 2);
-				descirpt[idx] = ZERO_FRAME_END;
-
-				int reqer_flags = ZMQ_SNDMORE;
-				int reqId_flags = ZMQ_SNDMORE;
-				int descirpt_flags = ZMQ_SNDMORE;
-				int msg_flags = ZMQ_SNDMORE;
-				if (global_id == nullptr)
-				{
-					if (req_id != nullptr)
-					{
-						reqId_flags = ZMQ_DONTWAIT;
-					}
-					else if (msg != nullptr)
-					{
-						msg_flags = ZMQ_DONTWAIT;
-					}
-					else if (reqer != nullptr)
-					{
-						reqer_flags = ZMQ_DONTWAIT;
-					}
-					else
-					{
-						descirpt_flags = ZMQ_DONTWAIT;
-					}
+					if (frames[idx].data != nullptr)
+						mask |= 1 << idx;
 				}
+				if (global_id_bin && global_id.data != nullptr)
+					mask |= 16;
+				size_t len;
+				const uchar* description = status_descriptions::instance().get(state, mask, len);
+				const int last = status_descriptions::last_frame(mask);
 
-				int re = zmq_send(socket, addr, strlen(addr), ZMQ_SNDMORE);
+				int re = zmq_send(socket, addr.data, addr.size, ZMQ_SNDMORE);
 				if (re < 0)
 				{
 					return check_zmq_error();
 				}
-				//state = zmq_send(socket, "", 0, ZMQ_SNDMORE);
-				//if (state < 0)
-				//{
-				//	return check_zmq_error();
-				//}
-				re = zmq_send(socket, descirpt, idx + 1, descirpt_flags);
+				zmq_msg_t msg_description;
+				zmq_msg_init_data(&msg_description, const_cast<uchar*>(description), len, nullptr, nullptr);
+				re = zmq_msg_send(&msg_description, socket, last < 0 ? ZMQ_DONTWAIT : ZMQ_SNDMORE);
 				if (re < 0)
 				{
+					zmq_msg_close(&msg_description);
 					return check_zmq_error();
 				}
-				if (reqer != nullptr)
+				for (int idx = 0; idx <= last; idx++)
 				{
-					re = zmq_send(socket, reqer, strlen(reqer), reqer_flags);
+					if (frames[idx].data == nullptr)
+						continue;
+					re = zmq_send(socket, frames[idx].data, frames[idx].size, idx == last ? ZMQ_DONTWAIT : ZMQ_SNDMORE);
 					if (re < 0)
 					{
 						return check_zmq_error();
 					}
 				}
-				if (msg != nullptr)
-				{
-					re = zmq_send(socket, msg, strlen(msg), msg_flags);
-					if (re < 0)
-					{
-						return check_zmq_error();
-					}
-				}
-				if (req_id != nullptr)
-				{
-					re = zmq_send(socket, req_id, strlen(req_id), reqId_flags);
-					if (re < 0)
-					{
-						return check_zmq_error();
-					}
-				}
-				if (global_id != nullptr)
-				{
-					re = zmq_send(socket, global_id, strlen(global_id), ZMQ_DONTWAIT);
-					if (re < 0)
-					{
-						return check_zmq_error();
-					}
-				}
-
 				return zmq_socket_state::Succeed;
 			}
 		};
@@ -0,0 +1,106 @@
+/**
+* \brief 准入控制(rpc/admission_control.h)的测试
+* \remark 独立的可执行文件,包含路径与中心相同,在src/ZeroCenter下编译:
+* g++ -std=c++14 -I. test/admission_control_test.cpp -lboost_system -lpthread -o admission_control_test
+*/
+#include "../rpc/admission_control.h"
+#include <cassert>
+#include <cstdio>
+
+using namespace agebull::zmq_net;
+
+/**
+* \brief 固定模式只按上限
+*/
+static void test_fixed()
+{
+	admission_control admission;
+	admission.initialize(10, false, 0, 10, 100, 100);
+	assert(admission.enable());
+	assert(admission.limit() == 10);
+	assert(admission.admit(9));
+	assert(!admission.admit(10));
+	//固定模式不调整
+	admission.sample(1000000, 10, 0);
+	admission.sample(1000000, 10, 1000000);
+	assert(admission.limit() == 10);
+
+	admission.initialize(0, false, 0, 10, 100, 100);
+	assert(!admission.enable());
+	assert(admission.admit(100000));
+}
+
+/**
+* \brief 往返时间超出基线加目标时乘性减,恢复后用满上限时加性增
+*/
+static void test_adaptive()
+{
+	admission_control admission;
+	//目标10毫秒,间隔100毫秒,未设上限时最大100
+	admission.initialize(0, true, 0, 10, 100, 100);
+	assert(admission.enable());
+	assert(admission.limit() == 100);
+
+	int64 now = 0;
+	//第一个间隔:建立基线1毫秒
+	admission.sample(1000, 0, now);
+	now += 100000;
+	admission.sample(1000, 0, now);
+	assert(admission.base_latency() == 1000);
+	assert(admission.limit() == 100);
+
+	//工作者积压:最小往返50毫秒,按当时的并发收缩
+	admission.sample(50000, 50, now + 50000);
+	now += 100000;
+	admission.sample(50000, 50, now);
+	assert(admission.base_latency() == 1000);
+	assert(admission.limit() == 45);
+
+	//恢复且上限被用满:加一
+	for (size_t i = 0; i < 46; i++)
+		admission.admit(i);
+	admission.sample(1000, 10, now + 50000);
+	now += 100000;
+	admission.sample(1000, 10, now);
+	assert(admission.limit() == 46);
+
+	//恢复但上限未用满:不变
+	admission.sample(1000, 10, now + 50000);
+	now += 100000;
+	admission.sample(1000, 10, now);
+	assert(admission.limit() == 46);
+}
+
+/**
+* \brief 处理耗时整体变慢后,基线重设,不再一直收缩
+*/
+static void test_base_reset()
+{
+	admission_control admission;
+	admission.initialize(0, true, 2, 10, 100, 100);
+	int64 now = 0;
+	admission.sample(1000, 0, now);
+	now += 100000;
+	admission.sample(1000, 0, now);
+	int64 limit = 0;
+	for (int i = 0; i < 2 * admission_control::base_reset; i++)
+	{
+		now += 100000;
+		admission.sample(50000, 5, now);
+		if (i == admission_control::base_reset + 10)
+			limit = admission.limit();
+	}
+	assert(admission.base_latency() == 50000);
+	assert(admission.limit() == limit);
+	//不低于最小值
+	assert(admission.limit() >= 2);
+}
+
+int main()
+{
+	test_fixed();
+	test_adaptive();
+	test_base_reset();
+	printf("admission_control_test passed\n");
+	return 0;
+}
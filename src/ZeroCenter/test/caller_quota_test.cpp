@@ -0,0 +1,97 @@
+/**
+* \brief 按调用者的令牌桶(rpc/caller_quota.h)的测试
+* \remark 独立的可执行文件,包含路径与中心相同,在src/ZeroCenter下编译:
+* g++ -std=c++14 -I. test/caller_quota_test.cpp -lboost_system -lpthread -o caller_quota_test
+*/
+#include "../rpc/caller_quota.h"
+#include <cassert>
+#include <cstdio>
+
+using namespace agebull::zmq_net;
+
+/**
+* \brief 突发用完后按速率补充,不超过容量
+*/
+static void test_refill()
+{
+	caller_quota quota;
+	quota.initialize(0, 0, 10);
+	assert(!quota.enable());
+	//每秒10个,突发2个
+	quota.initialize(10, 2, 10);
+	assert(quota.enable());
+	int64 now = 1000000;
+	caller_bucket& bucket = quota.find("a", now);
+	assert(quota.take(bucket, now));
+	assert(quota.take(bucket, now));
+	assert(!quota.take(bucket, now));
+	//100毫秒补充一个
+	now += 50000;
+	assert(!quota.take(bucket, now));
+	now += 50000;
+	assert(quota.take(bucket, now));
+	assert(!quota.take(bucket, now));
+	//空闲很久也只补满容量
+	now += 3600000000LL;
+	assert(quota.take(bucket, now));
+	assert(quota.take(bucket, now));
+	assert(!quota.take(bucket, now));
+	//时间回退时不补充
+	assert(!quota.take(bucket, now - 1000000));
+}
+
+/**
+* \brief 各调用者的桶相互独立,未指定突发时与速率相同
+*/
+static void test_callers()
+{
+	caller_quota quota;
+	quota.initialize(3, 0, 10);
+	const int64 now = 1000000;
+	for (int i = 0; i < 3; i++)
+		assert(quota.take(quota.find("a", now), now));
+	assert(!quota.take(quota.find("a", now), now));
+	assert(quota.take(quota.find("b", now), now));
+	assert(&quota.find("a", now) != &quota.find("b", now));
+}
+
+/**
+* \brief 达到上限时回收已补满的桶,仍不够时共用溢出桶
+*/
+static void test_recycle()
+{
+	caller_quota quota;
+	//每秒10个,突发1个,最多2个调用者
+	quota.initialize(10, 1, 2);
+	int64 now = 1000000;
+	assert(quota.take(quota.find("a", now), now));
+	assert(quota.take(quota.find("b", now), now));
+	//两个桶都未补满:新调用者共用溢出桶
+	caller_bucket& overflow = quota.find("c", now);
+	assert(&quota.find("d", now) == &overflow);
+	assert(quota.take(overflow, now));
+	assert(!quota.take(quota.find("d", now), now));
+
+	//b再次取用未补满,a补满后被回收,c分到a的序号且桶是满的
+	now += 150000;
+	assert(quota.take(quota.find("b", now), now));
+	now += 50000;
+	caller_bucket& bucket = quota.find("c", now);
+	assert(&bucket != &overflow);
+	assert(bucket.tokens > 0);
+	assert(quota.take(bucket, now));
+	assert(!quota.take(bucket, now));
+	//回收至多每100毫秒一次(此时b已补满)
+	assert(&quota.find("e", now + 50000) == &overflow);
+	now += 100000;
+	assert(&quota.find("e", now) != &overflow);
+}
+
+int main()
+{
+	test_refill();
+	test_callers();
+	test_recycle();
+	printf("caller_quota_test passed\n");
+	return 0;
+}
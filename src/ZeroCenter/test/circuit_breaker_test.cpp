@@ -0,0 +1,133 @@
+/**
+* \brief 站点断路器(rpc/circuit_breaker.h)的测试
+* \remark 独立的可执行文件,包含路径与中心相同,在src/ZeroCenter下编译:
+* g++ -std=c++14 -I. test/circuit_breaker_test.cpp -lboost_system -lpthread -o circuit_breaker_test
+*/
+#include "../rpc/circuit_breaker.h"
+#include <cassert>
+#include <cstdio>
+
+using namespace agebull::zmq_net;
+
+/**
+* \brief 没有就绪的工作者时断开,恢复后直接半开
+*/
+static void test_no_worker()
+{
+	circuit_breaker breaker;
+	//失败50%,至少4个请求,窗口1秒,断开1秒,探测1个
+	breaker.initialize(true, 50, 4, 1000, 1000, 1);
+	assert(breaker.enable());
+	assert(breaker.state() == breaker_state::closed);
+	assert(breaker.allow(true, 0));
+	assert(!breaker.allow(false, 0));
+	assert(breaker.state() == breaker_state::open);
+	assert(!breaker.allow(false, 100));
+	//工作者恢复:不等断开时间
+	assert(breaker.allow(true, 100));
+	assert(breaker.state() == breaker_state::half_open);
+	breaker.dispatched(100);
+	breaker.success(200);
+	assert(breaker.state() == breaker_state::closed);
+}
+
+/**
+* \brief 失败比例达到阈值时断开,断开时间过后半开,探测成功后闭合
+*/
+static void test_error_rate()
+{
+	circuit_breaker breaker;
+	breaker.initialize(true, 50, 4, 1000, 1000, 1);
+	int64 now = 0;
+	breaker.failure(now);
+	breaker.failure(now);
+	breaker.failure(now);
+	//请求数不足
+	assert(breaker.state() == breaker_state::closed);
+	breaker.success(now);
+	breaker.failure(now);
+	assert(breaker.state() == breaker_state::open);
+	assert(!breaker.allow(true, now + 999999));
+	assert(breaker.state() == breaker_state::open);
+
+	now += 1000000;
+	assert(breaker.allow(true, now));
+	assert(breaker.state() == breaker_state::half_open);
+	breaker.dispatched(now);
+	//探测名额已用
+	assert(!breaker.allow(true, now));
+	breaker.success(now + 1000);
+	assert(breaker.state() == breaker_state::closed);
+	assert(breaker.allow(true, now + 1000));
+}
+
+/**
+* \brief 窗口过后重新计数,未设失败比例时只按工作者断开
+*/
+static void test_window()
+{
+	circuit_breaker breaker;
+	breaker.initialize(true, 50, 4, 1000, 1000, 1);
+	breaker.failure(0);
+	breaker.failure(0);
+	breaker.failure(0);
+	breaker.success(1000000);
+	breaker.failure(1000000);
+	assert(breaker.state() == breaker_state::closed);
+	//只按工作者断开
+	breaker.initialize(true, 0, 1, 1000, 1000, 1);
+	for (int i = 0; i < 10; i++)
+		breaker.failure(0);
+	assert(breaker.state() == breaker_state::closed);
+}
+
+/**
+* \brief 探测失败再次断开;未发往工作者的请求不占用探测名额;探测丢失时断开
+*/
+static void test_probe()
+{
+	circuit_breaker breaker;
+	//探测2个
+	breaker.initialize(true, 50, 1, 1000, 1000, 2);
+	int64 now = 0;
+	breaker.failure(now);
+	assert(breaker.state() == breaker_state::open);
+	now += 1000000;
+	//放行后被拒绝(未调用dispatched)
+	for (int i = 0; i < 5; i++)
+		assert(breaker.allow(true, now));
+	breaker.dispatched(now);
+	breaker.dispatched(now);
+	assert(!breaker.allow(true, now));
+	//多余的dispatched不计数
+	breaker.dispatched(now);
+	breaker.failure(now + 1000);
+	assert(breaker.state() == breaker_state::open);
+	assert(!breaker.allow(true, now + 1000));
+
+	//探测在断开时间内未返回
+	now += 1001000;
+	assert(breaker.allow(true, now));
+	breaker.dispatched(now);
+	breaker.dispatched(now);
+	assert(!breaker.allow(true, now + 999999));
+	assert(breaker.state() == breaker_state::half_open);
+	assert(!breaker.allow(true, now + 1000000));
+	assert(breaker.state() == breaker_state::open);
+
+	//半开时工作者全部断开
+	now += 2000000;
+	assert(breaker.allow(true, now));
+	assert(!breaker.allow(false, now));
+	assert(breaker.state() == breaker_state::open);
+}
+
+int main()
+{
+	test_no_worker();
+	test_error_rate();
+	test_window();
+	test_probe();
+	printf("circuit_breaker_test passed\n");
+	return 0;
+}
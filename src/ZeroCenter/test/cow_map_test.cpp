@@ -0,0 +1,117 @@
+/**
+* \brief 写时复制字典(ext/cow_map.h)的测试
+* \remark 独立的可执行文件,包含路径与中心相同,在src/ZeroCenter下编译:
+* g++ -std=c++14 -I. test/cow_map_test.cpp -lboost_system -lpthread -o cow_map_test
+*/
+#include "../ext/cow_map.h"
+#include <cassert>
+#include <cstdio>
+#include <thread>
+
+using namespace agebull::zmq_net;
+
+/**
+* \brief 读写与返回值
+*/
+static void test_basic()
+{
+	cow_map<string, int> map;
+	int value = 0;
+	assert(map.size() == 0);
+	assert(!map.find("a", value));
+	assert(map.insert("a", 1));
+	assert(!map.insert("a", 2));
+	assert(map.find("a", value) && value == 1);
+	map.set("a", 3);
+	assert(map.find("a", value) && value == 3);
+	map.set("b", 4);
+	assert(map.size() == 2);
+	assert(map.contains("b"));
+	assert(map.erase("b"));
+	assert(!map.erase("b"));
+	assert(!map.contains("b"));
+	//返回false时不发布
+	assert(!map.update([](cow_map<string, int>::map_type& copy)
+	{
+		copy.clear();
+		return false;
+	}));
+	assert(map.size() == 1);
+	map.clear();
+	assert(map.size() == 0);
+}
+
+/**
+* \brief 快照不受之后的修改影响,版本未变时取得同一快照
+*/
+static void test_snapshot()
+{
+	cow_map<string, int> map;
+	map.set("a", 1);
+	const auto first = map.snapshot();
+	assert(map.snapshot() == first);
+	map.set("b", 2);
+	const auto second = map.snapshot();
+	assert(second != first);
+	assert(first->size() == 1);
+	assert(second->size() == 2);
+	//遍历快照时修改
+	for (auto& item : *second)
+		map.erase(item.first);
+	assert(map.size() == 0);
+	assert(second->size() == 2);
+}
+
+/**
+* \brief 同一地址新建的字典不会使用线程缓存的旧快照
+*/
+static void test_version()
+{
+	const uint64_t version = cow_map_next_version();
+	assert(cow_map_next_version() > version);
+	alignas(cow_map<string, int>) char buffer[sizeof(cow_map<string, int>)];
+	auto* map = new(buffer) cow_map<string, int>();
+	map->set("a", 1);
+	assert(map->size() == 1);
+	map->~cow_map();
+	map = new(buffer) cow_map<string, int>();
+	assert(map->size() == 0);
+	assert(!map->contains("a"));
+	map->~cow_map();
+}
+
+/**
+* \brief 其它线程的修改在读取线程可见
+*/
+static void test_threads()
+{
+	cow_map<int, int> map;
+	const int count = 1000;
+	std::thread writer([&map, count]()
+	{
+		for (int i = 0; i < count; i++)
+			map.set(i, i);
+	});
+	size_t last = 0;
+	while (last < static_cast<size_t>(count))
+	{
+		const auto snapshot = map.snapshot();
+		assert(snapshot->size() >= last);
+		last = snapshot->size();
+		for (auto& item : *snapshot)
+			assert(item.first == item.second);
+	}
+	writer.join();
+	int value = 0;
+	assert(map.find(count - 1, value) && value == count - 1);
+}
+
+int main()
+{
+	test_basic();
+	test_snapshot();
+	test_version();
+	test_threads();
+	printf("cow_map_test passed\n");
+	return 0;
+}
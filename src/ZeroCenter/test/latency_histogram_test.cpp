@@ -0,0 +1,115 @@
+/**
+* \brief 延时直方图(ext/latency_histogram.h)的测试
+* \remark 独立的可执行文件,包含路径与中心相同,在src/ZeroCenter下编译:
+* g++ -std=c++14 -I. test/latency_histogram_test.cpp -lboost_system -lpthread -o latency_histogram_test
+*/
+#include "../ext/latency_histogram.h"
+#include <cassert>
+#include <cstdio>
+#include <thread>
+
+using namespace agebull::zmq_net;
+
+/**
+* \brief 单个值的分位数:小值精确,其后为所在桶的上界且不超过最大值
+*/
+static int64 single(int64 value)
+{
+	latency_histogram histogram;
+	histogram.record(value);
+	const latency_summary summary = histogram.summary();
+	assert(summary.count == 1);
+	assert(summary.p50 == summary.p99 && summary.p99 == summary.p999);
+	return summary.p50;
+}
+
+/**
+* \brief 桶的边界
+*/
+static void test_bounds()
+{
+	for (int64 value = 0; value < 16; value++)
+		assert(single(value) == value);
+	assert(single(-5) == 0);
+	latency_histogram histogram;
+	//96~103同在一桶,104开始下一桶
+	histogram.record(96);
+	histogram.record(104);
+	latency_summary summary = histogram.summary();
+	assert(summary.p50 == 103);
+	assert(summary.p99 == 104);
+	assert(summary.max == 104);
+	assert(summary.sum == 200);
+	//超过2^40的值计入最后一桶
+	histogram.reset();
+	histogram.record(1LL << 50);
+	histogram.record(1LL << 50);
+	summary = histogram.summary();
+	assert(summary.count == 2);
+	assert(summary.max == 1LL << 50);
+	assert(summary.p50 == (1LL << 41) - 1);
+	histogram.reset();
+	summary = histogram.summary();
+	assert(summary.count == 0 && summary.max == 0 && summary.p50 == 0);
+}
+
+/**
+* \brief 分位数的相对误差不超过12.5%
+*/
+static void test_percentiles()
+{
+	latency_histogram histogram;
+	for (int64 value = 1; value <= 1000; value++)
+		histogram.record(value);
+	const latency_summary summary = histogram.summary();
+	assert(summary.count == 1000);
+	assert(summary.sum == 500500);
+	assert(summary.max == 1000);
+	assert(summary.p50 == 511);
+	assert(summary.p99 == 1000);
+	assert(summary.p999 == 1000);
+	assert(summary.p50 >= 500 && summary.p50 <= 500 + 500 / 8 + 1);
+
+	//多数很快,少数很慢
+	latency_histogram tail;
+	for (int i = 0; i < 990; i++)
+		tail.record(100);
+	for (int i = 0; i < 10; i++)
+		tail.record(100000);
+	const latency_summary result = tail.summary();
+	assert(result.p50 == 103);
+	assert(result.p99 == 103);
+	assert(result.p999 == 100000);
+}
+
+/**
+* \brief 多个线程同时记录不丢失
+*/
+static void test_threads()
+{
+	latency_histogram histogram;
+	vector<std::thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([&histogram, t]()
+		{
+			for (int i = 0; i < 100000; i++)
+				histogram.record(t + 1);
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	const latency_summary summary = histogram.summary();
+	assert(summary.count == 400000);
+	assert(summary.sum == 1000000);
+	assert(summary.max == 4);
+}
+
+int main()
+{
+	test_bounds();
+	test_percentiles();
+	test_threads();
+	printf("latency_histogram_test passed\n");
+	return 0;
+}
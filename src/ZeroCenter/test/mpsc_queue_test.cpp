@@ -0,0 +1,98 @@
+/**
+* \brief 多生产者单消费者队列(ext/mpsc_queue.h)的测试
+* \remark 独立的可执行文件,包含路径与中心相同,在src/ZeroCenter下编译:
+* g++ -std=c++14 -I. test/mpsc_queue_test.cpp -lboost_system -lpthread -o mpsc_queue_test
+*/
+#include "../ext/mpsc_queue.h"
+#include <cassert>
+#include <cstdio>
+#include <thread>
+
+using namespace agebull::zmq_net;
+
+/**
+* \brief 单线程先进先出
+*/
+static void test_fifo()
+{
+	mpsc_queue<int> queue;
+	int value = -1;
+	assert(!queue.pop(value));
+	for (int i = 0; i < 10; i++)
+		queue.push(std::move(i));
+	for (int i = 0; i < 10; i++)
+	{
+		assert(queue.pop(value));
+		assert(value == i);
+	}
+	assert(!queue.pop(value));
+}
+
+/**
+* \brief 多个生产者同时放入,消费者全部取出且各生产者的顺序不变
+*/
+static void test_producers()
+{
+	const int producers = 4;
+	const int count = 100000;
+	mpsc_queue<int> queue;
+	vector<std::thread> threads;
+	for (int p = 0; p < producers; p++)
+	{
+		threads.emplace_back([&queue, p, count]()
+		{
+			for (int i = 0; i < count; i++)
+			{
+				int value = p * count + i;
+				queue.push(std::move(value));
+			}
+		});
+	}
+	vector<int> last(producers, -1);
+	int total = 0;
+	int value;
+	while (total < producers * count)
+	{
+		if (!queue.pop(value))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		const int p = value / count;
+		assert(p >= 0 && p < producers);
+		assert(value % count == last[p] + 1);
+		last[p] = value % count;
+		++total;
+	}
+	for (auto& thread : threads)
+		thread.join();
+	assert(!queue.pop(value));
+	for (int p = 0; p < producers; p++)
+		assert(last[p] == count - 1);
+}
+
+/**
+* \brief 析构时释放未取出的元素
+*/
+static void test_destruct()
+{
+	auto item = std::make_shared<int>(1);
+	{
+		mpsc_queue<shared_ptr<int>> queue;
+		shared_ptr<int> copy = item;
+		queue.push(std::move(copy));
+		copy = item;
+		queue.push(std::move(copy));
+		assert(item.use_count() == 3);
+	}
+	assert(item.use_count() == 1);
+}
+
+int main()
+{
+	test_fifo();
+	test_producers();
+	test_destruct();
+	printf("mpsc_queue_test passed\n");
+	return 0;
+}
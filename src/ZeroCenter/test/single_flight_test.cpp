@@ -0,0 +1,162 @@
+/**
+* \brief 相同请求的合并(rpc/single_flight.h)的测试
+* \remark 独立的可执行文件,包含路径与中心相同,在src/ZeroCenter下编译:
+* g++ -std=c++14 -I. test/single_flight_test.cpp ext/frame_pool.cpp -lboost_system -lpthread -o single_flight_test
+*/
+#include "../rpc/single_flight.h"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+using namespace agebull::zmq_net;
+
+/**
+* \brief 构造等待者
+*/
+static flight_waiter make_waiter(const char* request_id)
+{
+	flight_waiter waiter;
+	waiter.caller = "caller";
+	waiter.request_id = request_id;
+	waiter.global_id_bin = false;
+	return waiter;
+}
+
+/**
+* \brief 按命令启用
+*/
+static void test_enable()
+{
+	single_flight flight;
+	assert(!flight.enable());
+	flight.initialize({ "query" }, 1000, 10);
+	assert(flight.enable());
+	flight.initialize({ "*" }, 1000, 10);
+	assert(flight.enable());
+	flight.initialize({ "" }, 1000, 10);
+	assert(!flight.enable());
+	assert(single_flight::hash("a") == single_flight::hash("a"));
+	assert(single_flight::hash("a") != single_flight::hash("b"));
+}
+
+/**
+* \brief 第一个请求领头,相同的请求等待,返回时取出全部等待者
+*/
+static void test_lead_join_finish()
+{
+	single_flight flight;
+	flight.initialize({ "*" }, 1000, 2);
+	const string key = "query";
+	const uint64_t code = single_flight::hash(key);
+	vector<flight_waiter> expired;
+	flight_waiter waiter = make_waiter("1");
+	//没有正在执行的合并
+	assert(!flight.join(code, key, waiter, 0));
+	string lead_key = key;
+	flight.lead(code, lead_key, "leader", 0, expired);
+	assert(expired.empty());
+	assert(!flight.empty());
+
+	waiter = make_waiter("2");
+	assert(flight.join(code, key, waiter, 100));
+	waiter = make_waiter("3");
+	assert(flight.join(code, key, waiter, 200));
+	//等待者已满
+	waiter = make_waiter("4");
+	assert(!flight.join(code, key, waiter, 300));
+	//哈希相同而原文不同
+	waiter = make_waiter("5");
+	assert(!flight.join(code, "other", waiter, 300));
+
+	vector<flight_waiter> waiters;
+	assert(!flight.finish("unknown", waiters));
+	assert(flight.finish("leader", waiters));
+	assert(waiters.size() == 2);
+	assert(strcmp(*waiters[0].request_id, "2") == 0);
+	assert(strcmp(*waiters[1].request_id, "3") == 0);
+	assert(flight.empty());
+	waiters.clear();
+	assert(!flight.finish("leader", waiters));
+}
+
+/**
+* \brief 超时的合并不再接受等待者,由新的请求替换或定时取出
+*/
+static void test_expire()
+{
+	single_flight flight;
+	//超时1秒
+	flight.initialize({ "*" }, 1000, 10);
+	const string key = "query";
+	const uint64_t code = single_flight::hash(key);
+	vector<flight_waiter> expired;
+	string lead_key = key;
+	flight.lead(code, lead_key, "first", 0, expired);
+	flight_waiter waiter = make_waiter("1");
+	assert(flight.join(code, key, waiter, 500000));
+	waiter = make_waiter("2");
+	assert(!flight.join(code, key, waiter, 1000000));
+
+	//未超时时保留原有的合并
+	lead_key = key;
+	flight.lead(code, lead_key, "second", 999999, expired);
+	assert(expired.empty());
+	vector<flight_waiter> waiters;
+	assert(!flight.finish("second", waiters));
+
+	//超时后替换,原有的等待者交给调用者
+	lead_key = key;
+	flight.lead(code, lead_key, "second", 1000000, expired);
+	assert(expired.size() == 1);
+	assert(strcmp(*expired[0].request_id, "1") == 0);
+	assert(!flight.finish("first", waiters));
+	waiter = make_waiter("3");
+	assert(flight.join(code, key, waiter, 1100000));
+
+	//未超时
+	waiters.clear();
+	flight.expire(1500000, waiters);
+	assert(waiters.empty());
+	//已超时,但距上次检查不足一秒
+	flight.expire(2100000, waiters);
+	assert(waiters.empty());
+	flight.expire(2500000, waiters);
+	assert(waiters.size() == 1);
+	assert(strcmp(*waiters[0].request_id, "3") == 0);
+	assert(flight.empty());
+	waiters.clear();
+	assert(!flight.finish("second", waiters));
+}
+
+/**
+* \brief 关闭时取出全部等待者
+*/
+static void test_clear()
+{
+	single_flight flight;
+	flight.initialize({ "*" }, 1000, 10);
+	vector<flight_waiter> expired;
+	for (int i = 0; i < 3; i++)
+	{
+		string key = "query" + std::to_string(i);
+		const uint64_t code = single_flight::hash(key);
+		const string join_key = key;
+		flight.lead(code, key, "leader" + std::to_string(i), 0, expired);
+		flight_waiter waiter = make_waiter("1");
+		assert(flight.join(code, join_key, waiter, 0));
+	}
+	vector<flight_waiter> waiters;
+	flight.clear(waiters);
+	assert(waiters.size() == 3);
+	assert(flight.empty());
+}
+
+int main()
+{
+	test_enable();
+	test_lead_join_finish();
+	test_expire();
+	test_clear();
+	printf("single_flight_test passed\n");
+	return 0;
+}